@@ -27,6 +27,9 @@
 
 #include "logic/net/HttpMetaCache.h"
 #include "logic/net/URLConstants.h"
+#include "logic/net/DownloadCoordinator.h"
+#include "logic/storage/ObjectStore.h"
+#include "logic/ModMetadataCache.h"
 
 #include "logic/java/JavaUtils.h"
 
@@ -263,6 +266,12 @@ MultiMC::MultiMC(int &argc, char **argv, bool test_mode) : QApplication(argc, ar
 
 MultiMC::~MultiMC()
 {
+	// write out the queued log messages while the destinations still exist
+	QsLogging::Logger &logger = QsLogging::Logger::instance();
+	logger.setAsynchronous(false);
+	// pool tasks may still log after this, the destinations go away with us
+	logger.removeDestination(m_fileDestination.get());
+	logger.removeDestination(m_debugDestination.get());
 	if (m_mmc_translator)
 	{
 		removeTranslator(m_mmc_translator.get());
@@ -337,6 +346,8 @@ void MultiMC::initLogger()
 	logger.addDestination(m_debugDestination.get());
 	// log all the things
 	logger.setLoggingLevel(QsLogging::TraceLevel);
+	// without making the threads that log wait for the disk
+	logger.setAsynchronous(true);
 }
 
 void MultiMC::initGlobalSettings(bool test_mode)
@@ -491,6 +502,7 @@ void MultiMC::initGlobalSettings(bool test_mode)
 	m_settings->registerSetting("RaiseConsole", true);
 	m_settings->registerSetting("AutoCloseConsole", true);
 	m_settings->registerSetting("LogPrePostOutput", true);
+	m_settings->registerSetting("ConsoleMaxLines", 100000);
 
 	// Console Colors
 	//	m_settings->registerSetting("SysMessageColor", QColor(Qt::blue));
@@ -502,6 +514,12 @@ void MultiMC::initGlobalSettings(bool test_mode)
 	m_settings->registerSetting({"MinecraftWinWidth", "MCWindowWidth"}, 854);
 	m_settings->registerSetting({"MinecraftWinHeight", "MCWindowHeight"}, 480);
 
+	// Downloads
+	m_settings->registerSetting("NetMaxConnections", 24);
+	m_settings->registerSetting("NetMaxConnectionsPerHost", 16);
+	m_settings->registerSetting("NetMaxRetries", 3);
+	m_settings->registerSetting("NetRetryDelay", 500);
+
 	// Proxy Settings
 	m_settings->registerSetting("ProxyType", "None");
 	m_settings->registerSetting({"ProxyAddr", "ProxyHostName"}, "127.0.0.1");
@@ -639,6 +657,33 @@ std::shared_ptr<IconList> MultiMC::icons()
 	return m_icons;
 }
 
+std::shared_ptr<ObjectStore> MultiMC::objectstore()
+{
+	if (!m_objectstore)
+	{
+		m_objectstore.reset(new ObjectStore(QDir("objects").absolutePath()));
+	}
+	return m_objectstore;
+}
+
+std::shared_ptr<ModMetadataCache> MultiMC::modcache()
+{
+	if (!m_modcache)
+	{
+		m_modcache.reset(new ModMetadataCache("modmetacache"));
+	}
+	return m_modcache;
+}
+
+std::shared_ptr<DownloadCoordinator> MultiMC::downloadCoordinator()
+{
+	if (!m_downloadCoordinator)
+	{
+		m_downloadCoordinator.reset(new DownloadCoordinator());
+	}
+	return m_downloadCoordinator;
+}
+
 std::shared_ptr<LWJGLVersionList> MultiMC::lwjgllist()
 {
 	if (!m_lwjgllist)
@@ -752,6 +797,11 @@ QIcon MultiMC::getThemedIcon(const QString& name)
 
 void MultiMC::onExit()
 {
+	// reclaim shared objects no instance uses anymore
+	if (m_objectstore)
+	{
+		m_objectstore->collectGarbage();
+	}
 	if (m_updateOnExitPath.size())
 	{
 		installUpdates(m_updateOnExitPath, m_updateOnExitFlags);
@@ -10,6 +10,9 @@
 class MinecraftVersionList;
 class LWJGLVersionList;
 class HttpMetaCache;
+class ObjectStore;
+class ModMetadataCache;
+class DownloadCoordinator;
 class SettingsObject;
 class InstanceList;
 class MojangAccountList;
@@ -92,6 +95,12 @@ public:
 		return m_metacache;
 	}
 
+	std::shared_ptr<ObjectStore> objectstore();
+
+	std::shared_ptr<ModMetadataCache> modcache();
+
+	std::shared_ptr<DownloadCoordinator> downloadCoordinator();
+
 	std::shared_ptr<UpdateChecker> updateChecker()
 	{
 		return m_updateChecker;
@@ -203,6 +212,9 @@ private:
 	std::shared_ptr<IconList> m_icons;
 	std::shared_ptr<QNetworkAccessManager> m_qnam;
 	std::shared_ptr<HttpMetaCache> m_metacache;
+	std::shared_ptr<ObjectStore> m_objectstore;
+	std::shared_ptr<ModMetadataCache> m_modcache;
+	std::shared_ptr<DownloadCoordinator> m_downloadCoordinator;
 	std::shared_ptr<LWJGLVersionList> m_lwjgllist;
 	std::shared_ptr<ForgeVersionList> m_forgelist;
 	std::shared_ptr<LiteLoaderVersionList> m_liteloaderlist;
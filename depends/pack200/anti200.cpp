@@ -4,19 +4,42 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include "unpack200.h"
 
 int main(int argc, char **argv)
 {
-	if (argc != 3)
+	unpack200_options options;
+	int arg = 1;
+	// options: -0 to -9 pick the deflate level (0 = store), -j N compresses on N threads
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		const char *opt = argv[arg];
+		if (opt[1] >= '0' && opt[1] <= '9' && opt[2] == 0)
+		{
+			options.deflate_level = opt[1] - '0';
+		}
+		else if (strcmp(opt, "-j") == 0 && arg + 1 < argc)
+		{
+			options.threads = atoi(argv[++arg]);
+		}
+		else
+		{
+			argc = 0;
+			break;
+		}
+	}
+	if (argc - arg != 2)
 	{
 		std::cerr << "Simple pack200 unpacker!" << std::endl << "Run like this:" << std::endl
-				  << "  " << argv[0] << " input.jar.lzma output.jar" << std::endl;
+				  << "  " << argv[0] << " [-0..-9] [-j threads] input.jar.lzma output.jar"
+				  << std::endl;
 		return EXIT_FAILURE;
 	}
 
-	FILE *input = fopen(argv[1], "rb");
-	FILE *output = fopen(argv[2], "wb");
+	FILE *input = fopen(argv[arg], "rb");
+	FILE *output = fopen(argv[arg + 1], "wb");
 	if (!input)
 	{
 		std::cerr << "Can't open input file";
@@ -30,7 +53,7 @@ int main(int argc, char **argv)
 	}
 	try
 	{
-		unpack_200(input, output);
+		unpack_200(input, output, options);
 	}
 	catch (std::runtime_error &e)
 	{
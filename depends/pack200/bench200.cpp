@@ -0,0 +1,104 @@
+/*
+ * This is trivial. Do what thou wilt with it. Public domain.
+ */
+
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include "unpack200.h"
+
+// Unpacks from memory, so only the unpacking is measured
+struct memory_input : public unpack200_input
+{
+	memory_input(const std::string &data) : m_data(data)
+	{
+	}
+	virtual int64_t read(void *buf, int64_t, int64_t maxlen)
+	{
+		// everything is there already, so there is always as much as asked for
+		int64_t left = (int64_t)(m_data.size() - m_pos);
+		int64_t len = left < maxlen ? left : maxlen;
+		memcpy(buf, m_data.data() + m_pos, len);
+		m_pos += len;
+		return len;
+	}
+	const std::string &m_data;
+	size_t m_pos = 0;
+};
+
+struct counting_output : public unpack200_output
+{
+	virtual bool write(const void *, size_t len)
+	{
+		m_size += len;
+		return true;
+	}
+	size_t m_size = 0;
+};
+
+int main(int argc, char **argv)
+{
+	if (argc != 2)
+	{
+		std::cerr << "Compares pack200 unpacking speed and jar size for deflate levels and "
+					 "thread counts." << std::endl
+				  << "Run like this:" << std::endl << "  " << argv[0] << " input.pack"
+				  << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::ifstream file(argv[1], std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "Can't open input file" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	const std::string data = contents.str();
+
+	int cores = std::thread::hardware_concurrency();
+	if (cores < 1)
+		cores = 1;
+	const int runs = 3;
+	const int configs[][2] = {{9, 1}, {9, cores}, {6, cores}, {1, 1}, {1, cores}, {0, 1}};
+
+	std::cout << "level threads   best ms   jar bytes" << std::endl;
+	for (auto &config : configs)
+	{
+		unpack200_options options;
+		options.deflate_level = config[0];
+		options.threads = config[1];
+		double best = -1;
+		size_t size = 0;
+		for (int i = 0; i < runs; i++)
+		{
+			memory_input input(data);
+			counting_output output;
+			auto start = std::chrono::steady_clock::now();
+			try
+			{
+				unpack_200(input, output, options);
+			}
+			catch (std::runtime_error &e)
+			{
+				std::cerr << "Bad things happened: " << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+			std::chrono::duration<double, std::milli> took =
+				std::chrono::steady_clock::now() - start;
+			if (best < 0 || took.count() < best)
+				best = took.count();
+			size = output.m_size;
+		}
+		std::cout << std::setw(5) << options.deflate_level << std::setw(8) << options.threads
+				  << std::setw(10) << std::fixed << std::setprecision(1) << best << std::setw(12)
+				  << size << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
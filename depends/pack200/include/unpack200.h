@@ -25,13 +25,70 @@
 
 #pragma once
 #include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * @brief Source of PACK200 data for the streaming unpack_200
+ */
+struct unpack200_input
+{
+	virtual ~unpack200_input() {};
+	/**
+	 * Read at least minlen and at most maxlen bytes into buf, blocking if needed.
+	 * Returning less than minlen means the input ended.
+	 * May throw std::runtime_error, which aborts the unpacking.
+	 */
+	virtual int64_t read(void *buf, int64_t minlen, int64_t maxlen) = 0;
+};
+
+/**
+ * @brief Sink for the jar produced by the streaming unpack_200
+ */
+struct unpack200_output
+{
+	virtual ~unpack200_output() {};
+	/// Write all of buf. Returning false aborts the unpacking.
+	virtual bool write(const void *buf, size_t len) = 0;
+};
+
+/**
+ * @brief How unpack_200 compresses the jar entries
+ *
+ * The defaults give the smallest jar. Jars that are only read locally are better off with
+ * a low level and several threads.
+ */
+struct unpack200_options
+{
+	/// zlib compression level, 1-9. 0 stores the entries uncompressed
+	int deflate_level = 9;
+	/// number of threads compressing entries. 1 compresses on the calling thread
+	int threads = 1;
+};
 
 /**
  * @brief Unpack a PACK200 file
  *
- * @param input_path Path to the input file in PACK200 format. System native string encoding.
- * @param output_path Path to the output file in PACK200 format. System native string encoding.
+ * @param input Input file in PACK200 format. Closed when done.
+ * @param output Output jar file. Closed when done.
+ * @param options Compression options for the output jar
+ * @return void
+ * @throw std::runtime_error for any error encountered
+ */
+void unpack_200(FILE * input, FILE * output,
+				const unpack200_options &options = unpack200_options());
+
+/**
+ * @brief Unpack a PACK200 stream
+ *
+ * The input is pulled as the unpacker needs it and the jar is pushed to the output
+ * as it is produced, so neither side has to be a file.
+ *
+ * @param input Source of the PACK200 data
+ * @param output Sink for the resulting jar
+ * @param options Compression options for the output jar
  * @return void
  * @throw std::runtime_error for any error encountered
  */
-void unpack_200(FILE * input, FILE * output);
+void unpack_200(unpack200_input &input, unpack200_output &output,
+				const unpack200_options &options = unpack200_options());
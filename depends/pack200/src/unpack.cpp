@@ -3473,7 +3473,7 @@ void constant_pool::computeOutputIndexes()
 // Unpacker Start
 // Deallocate all internal storage and reset to a clean state.
 // Do not disturb any input or output connections, including
-// infileptr, inbytes, read_input_fn, jarout, or errstrm.
+// infileptr, instream, inbytes, read_input_fn, jarout, or errstrm.
 // Do not reset any unpack options.
 void unpacker::reset()
 {
@@ -3502,6 +3502,7 @@ void unpacker::reset()
 
 	unpacker save_u = (*this); // save bytewise image
 	infileptr = nullptr;	   // make asserts happy
+	instream = nullptr;
 	jarout = nullptr;		  // do not close the output jar
 	gzin = nullptr;			// do not close the input gzip stream
 	this->free();
@@ -3509,6 +3510,7 @@ void unpacker::reset()
 
 	// restore selected interface state:
 	infileptr = save_u.infileptr;
+	instream = save_u.instream;
 	inbytes = save_u.inbytes;
 	jarout = save_u.jarout;
 	gzin = save_u.gzin;
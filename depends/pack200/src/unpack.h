@@ -135,6 +135,8 @@ struct constant_pool
 	void resetOutputIndexes();
 };
 
+struct unpack200_input;
+
 /*
  * The unpacker provides the entry points to the unpack engine,
  * as well as maintains the state of the engine.
@@ -159,6 +161,7 @@ struct unpacker
 
 	// if running Unix-style, here are the inputs and outputs
 	FILE *infileptr; // buffered
+	unpack200_input *instream; // or pulled from a stream
 	bytes inbytes;   // direct
 	gunzip *gzin;	// gunzip filter, if any
 	jar *jarout;	 // output JAR file
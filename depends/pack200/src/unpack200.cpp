@@ -94,20 +94,17 @@ static int read_magic(unpacker *u, char peek[], int peeklen)
 	return magic;
 }
 
-void unpack_200(FILE *input, FILE *output)
+// Callback for fetching data from an unpack200_input
+static int64_t read_input_via_stream(unpacker *u, void *buf, int64_t minlen, int64_t maxlen)
 {
-	unpacker u;
-	u.init(read_input_via_stdio);
-
-	// initialize jar output
-	// the output takes ownership of the file handle
-	jar jarout;
-	jarout.init(&u);
-	jarout.jarfp = output;
-
-	// the input doesn't
-	u.infileptr = input;
+	assert(u->instream != nullptr);
+	assert(minlen <= maxlen); // don't talk nonsense
+	return u->instream->read(buf, minlen, maxlen);
+}
 
+// Unpacks all segments from the input into the jar set up in u
+static void unpack_segments(unpacker &u)
+{
 	// read the magic!
 	char peek[4];
 	int magic;
@@ -158,5 +155,53 @@ void unpack_200(FILE *input, FILE *output)
 	}
 	u.finish();
 	u.free(); // tidy up malloc blocks
+}
+
+// Unpacks into jarout, making sure the compressor threads are gone if anything fails
+static void unpack_to_jar(unpacker &u, jar &jarout, const unpack200_options &options)
+{
+	jarout.setCompression(options.deflate_level, options.threads);
+	try
+	{
+		unpack_segments(u);
+	}
+	catch (...)
+	{
+		jarout.free();
+		throw;
+	}
+}
+
+void unpack_200(FILE *input, FILE *output, const unpack200_options &options)
+{
+	unpacker u;
+	u.init(read_input_via_stdio);
+
+	// initialize jar output
+	// the output takes ownership of the file handle
+	jar jarout;
+	jarout.init(&u);
+	jarout.jarfp = output;
+
+	// the input doesn't
+	u.infileptr = input;
+
+	unpack_to_jar(u, jarout, options);
 	fclose(input);
 }
+
+void unpack_200(unpack200_input &input, unpack200_output &output,
+				const unpack200_options &options)
+{
+	unpacker u;
+	u.init(read_input_via_stream);
+
+	// initialize jar output, streamed to the caller
+	jar jarout;
+	jarout.init(&u);
+	jarout.sink = &output;
+
+	u.instream = &input;
+
+	unpack_to_jar(u, jarout, options);
+}
@@ -39,6 +39,14 @@
 #include <strings.h>
 #endif
 
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+
 #include "defines.h"
 #include "bytes.h"
 #include "utils.h"
@@ -47,6 +55,7 @@
 #include "unpack.h"
 
 #include "zip.h"
+#include "unpack200.h"
 
 #include "zlib.h"
 
@@ -66,16 +75,183 @@ inline uint32_t jar::get_crc32(uint32_t c, uchar *ptr, uint32_t len)
 
 #define GET_INT_HI(a) SWAP_BYTES((a >> 16) & 0xFFFF);
 
+// One entry on its way through the compressor threads
+struct jar_entry_job
+{
+	std::string name;
+	int modtime;
+	bool deflate; // cleared if compressing doesn't make it smaller
+	std::vector<uchar> data;
+	std::vector<uchar> deflated;
+	uint32_t crc = 0;
+	bool done = false;
+};
+
+// Compresses entries on a pool of threads. They are written out in the order they came in.
+struct jar_compressor
+{
+	// bounds for entries waiting to be written
+	enum
+	{
+		MAX_PENDING_PER_THREAD = 64,
+		MAX_PENDING_BYTES = 64 << 20
+	};
+
+	jar_compressor(int level_) : level(level_)
+	{
+	}
+
+	~jar_compressor()
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			stopping = true;
+		}
+		work_ready.notify_all();
+		for (auto &thread : threads)
+			thread.join();
+		for (auto entry : in_order)
+			delete entry;
+	}
+
+	void start(int count)
+	{
+		for (int i = 0; i < count; i++)
+			threads.push_back(std::thread(&jar_compressor::work, this));
+	}
+
+	void submit(jar_entry_job *entry)
+	{
+		in_order.push_back(entry);
+		in_order_bytes += entry->data.size();
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			todo.push_back(entry);
+		}
+		work_ready.notify_one();
+	}
+
+	bool over_limit()
+	{
+		return in_order.size() > MAX_PENDING_PER_THREAD * threads.size() ||
+			   in_order_bytes > MAX_PENDING_BYTES;
+	}
+
+	// the oldest entry not written yet, if it is done or we are willing to wait for it
+	jar_entry_job *front(bool wait)
+	{
+		if (in_order.empty())
+			return nullptr;
+		jar_entry_job *entry = in_order.front();
+		std::unique_lock<std::mutex> guard(lock);
+		while (!entry->done)
+		{
+			if (!wait)
+				return nullptr;
+			work_done.wait(guard);
+		}
+		return entry;
+	}
+
+	void pop()
+	{
+		jar_entry_job *entry = in_order.front();
+		in_order.pop_front();
+		in_order_bytes -= entry->data.size();
+		delete entry;
+	}
+
+	void work()
+	{
+		for (;;)
+		{
+			jar_entry_job *entry;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				while (todo.empty() && !stopping)
+					work_ready.wait(guard);
+				if (stopping)
+					return;
+				entry = todo.front();
+				todo.pop_front();
+			}
+			compress(*entry);
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				entry->done = true;
+			}
+			work_done.notify_all();
+		}
+	}
+
+	void compress(jar_entry_job &entry);
+
+	int level;
+	std::mutex lock;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+	// entries waiting for a thread, shared with the threads
+	std::deque<jar_entry_job *> todo;
+	// every entry not written yet, oldest first. only used by the writing thread
+	std::deque<jar_entry_job *> in_order;
+	size_t in_order_bytes = 0;
+	bool stopping = false;
+	std::vector<std::thread> threads;
+};
+
 void jar::init(unpacker *u_)
 {
 	BYTES_OF(*this).clear();
 	u = u_;
 	u->jarout = this;
+	deflate_level = Z_BEST_COMPRESSION;
+}
+
+void jar::setCompression(int level, int threads)
+{
+	delete compressor;
+	compressor = nullptr;
+	if (level < 0 || level > Z_BEST_COMPRESSION)
+		level = Z_BEST_COMPRESSION;
+	deflate_level = level;
+	if (threads > 1)
+	{
+		compressor = new jar_compressor(level);
+		try
+		{
+			compressor->start(threads);
+		}
+		catch (std::system_error &)
+		{
+			// make do with what we got
+		}
+		if (compressor->threads.empty())
+		{
+			delete compressor;
+			compressor = nullptr;
+		}
+	}
+}
+
+void jar::free()
+{
+	// stops the threads, anything not written yet is dropped
+	delete compressor;
+	compressor = nullptr;
+	central_directory.free();
+	deflated.free();
 }
 
 // Write data to the ZIP output stream.
 void jar::write_data(void *buff, int len)
 {
+	if (sink)
+	{
+		if (len > 0 && !sink->write(buff, len))
+			unpack_abort("write on output stream failed");
+		output_file_offset += len;
+		return;
+	}
 	while (len > 0)
 	{
 		int rc = (int)fwrite(buff, 1, len, jarfp);
@@ -107,7 +283,7 @@ void jar::add_to_jar_directory(const char *fname, bool store, int modtime, int l
 	header[3] = (ushort)SWAP_BYTES(0xA);
 
 	// flags 02 = maximum  sub-compression flag
-	header[4] = (store) ? 0x0 : SWAP_BYTES(0x2);
+	header[4] = (store) ? 0x0 : SWAP_BYTES(deflate_flags());
 
 	// Compression method 8=deflate.
 	header[5] = (store) ? 0x0 : SWAP_BYTES(0x08);
@@ -171,7 +347,7 @@ void jar::write_jar_header(const char *fname, bool store, int modtime, int len,
 	header[2] = (ushort)SWAP_BYTES(0xA);
 
 	// flags 02 = maximum  sub-compression flag
-	header[3] = (store) ? 0x0 : SWAP_BYTES(0x2);
+	header[3] = (store) ? 0x0 : SWAP_BYTES(deflate_flags());
 
 	// Compression method = deflate
 	header[4] = (store) ? 0x0 : SWAP_BYTES(0x08);
@@ -204,6 +380,38 @@ void jar::write_jar_header(const char *fname, bool store, int modtime, int len,
 	write_data((char *)fname, (int)fname_length);
 }
 
+void jar::write_entry(jar_entry_job &entry)
+{
+	int len = (int)entry.data.size();
+	int clen = (int)((entry.deflate) ? entry.deflated.size() : len);
+	add_to_jar_directory(entry.name.c_str(), !entry.deflate, entry.modtime, len, clen,
+						 entry.crc);
+	write_jar_header(entry.name.c_str(), !entry.deflate, entry.modtime, len, clen, entry.crc);
+	if (entry.deflate)
+	{
+		write_data(entry.deflated.data(), clen);
+	}
+	else
+	{
+		write_data(entry.data.data(), len);
+	}
+}
+
+// Write out compressed entries, in order. With all, wait for everything to be compressed.
+void jar::flush_entries(bool all)
+{
+	if (!compressor)
+		return;
+	for (;;)
+	{
+		jar_entry_job *entry = compressor->front(all || compressor->over_limit());
+		if (!entry)
+			break;
+		write_entry(*entry);
+		compressor->pop();
+	}
+}
+
 void jar::write_central_directory()
 {
 	bytes mc;
@@ -262,14 +470,29 @@ void jar::addJarEntry(const char *fname, bool deflate_hint, int modtime, bytes &
 	int len = (int)(head.len + tail.len);
 	int clen = 0;
 
+	bool deflate = (deflate_hint && len > 0 && deflate_level != 0);
+
+	if (compressor)
+	{
+		// the data is only good until we return. copy it for the compressor threads
+		jar_entry_job *entry = new jar_entry_job();
+		entry->name = fname;
+		entry->modtime = modtime;
+		entry->deflate = deflate;
+		entry->data.reserve(len);
+		entry->data.insert(entry->data.end(), head.ptr, head.ptr + head.len);
+		entry->data.insert(entry->data.end(), tail.ptr, tail.ptr + tail.len);
+		compressor->submit(entry);
+		flush_entries(false);
+		return;
+	}
+
 	uint32_t crc = get_crc32(0, Z_NULL, 0);
 	if (head.len != 0)
 		crc = get_crc32(crc, (uchar *)head.ptr, (uint32_t)head.len);
 	if (tail.len != 0)
 		crc = get_crc32(crc, (uchar *)tail.ptr, (uint32_t)tail.len);
 
-	bool deflate = (deflate_hint && len > 0);
-
 	if (deflate)
 	{
 		if (deflate_bytes(head, tail) == false)
@@ -295,6 +518,17 @@ void jar::addJarEntry(const char *fname, bool deflate_hint, int modtime, bytes &
 // Add a ZIP entry for a directory name no data
 void jar::addDirectoryToJarFile(const char *dir_name)
 {
+	if (compressor)
+	{
+		// keep it in line with the entries still being compressed
+		jar_entry_job *entry = new jar_entry_job();
+		entry->name = dir_name;
+		entry->modtime = default_modtime;
+		entry->deflate = false;
+		compressor->submit(entry);
+		flush_entries(false);
+		return;
+	}
 	bool store = true;
 	add_to_jar_directory((const char *)dir_name, store, default_modtime, 0, 0, 0);
 	write_jar_header((const char *)dir_name, store, default_modtime, 0, 0, 0);
@@ -303,6 +537,7 @@ void jar::addDirectoryToJarFile(const char *dir_name)
 // Write out the central directory and close the jar file.
 void jar::closeJarFile(bool central)
 {
+	flush_entries(true);
 	if (jarfp)
 	{
 		fflush(jarfp);
@@ -311,6 +546,10 @@ void jar::closeJarFile(bool central)
 		fflush(jarfp);
 		fclose(jarfp);
 	}
+	else if (sink && central)
+	{
+		write_central_directory();
+	}
 	reset();
 }
 
@@ -367,7 +606,7 @@ bool jar::deflate_bytes(bytes &head, bytes &tail)
 	// unzip/zipup.c and java/Deflater.c
 
 	int error =
-		deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+		deflateInit2(&zs, deflate_level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
 	if (error != Z_OK)
 	{
 		/*
@@ -436,6 +675,60 @@ bool jar::deflate_bytes(bytes &head, bytes &tail)
 	return false;
 }
 
+// ZIP general purpose flags matching the deflate level
+int jar::deflate_flags()
+{
+	if (deflate_level >= 8)
+		return 0x2; // maximum
+	if (deflate_level == 1)
+		return 0x6; // super fast
+	if (deflate_level == 2)
+		return 0x4; // fast
+	return 0x0; // normal
+}
+
+// Runs on the compressor threads
+void jar_compressor::compress(jar_entry_job &entry)
+{
+	uint32_t len = (uint32_t)entry.data.size();
+	uint32_t crc = jar::get_crc32(0, Z_NULL, 0);
+	if (len != 0)
+		crc = jar::get_crc32(crc, entry.data.data(), len);
+	entry.crc = crc;
+	if (!entry.deflate)
+		return;
+
+	z_stream zs;
+	BYTES_OF(zs).clear();
+	entry.deflate = false;
+	if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return;
+	try
+	{
+		entry.deflated.resize(len + (len / 2));
+	}
+	catch (std::bad_alloc &)
+	{
+		deflateEnd(&zs);
+		return;
+	}
+	zs.next_in = entry.data.data();
+	zs.avail_in = len;
+	zs.next_out = entry.deflated.data();
+	zs.avail_out = (uint32_t)entry.deflated.size();
+	// only worth it if it gets smaller
+	if (deflate(&zs, Z_FINISH) == Z_STREAM_END && len > zs.total_out)
+	{
+		entry.deflated.resize(zs.total_out);
+		entry.deflate = true;
+	}
+	else
+	{
+		entry.deflated.clear();
+	}
+	deflateEnd(&zs);
+}
+
 // Callback for fetching data from a GZIP input stream
 static int64_t read_input_via_gzip(unpacker *u, void *buf, int64_t minlen, int64_t maxlen)
 {
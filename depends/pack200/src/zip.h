@@ -28,11 +28,16 @@ typedef unsigned int uint32_t;
 typedef unsigned char uchar;
 
 struct unpacker;
+struct unpack200_output;
+struct jar_compressor;
+struct jar_entry_job;
 
 struct jar
 {
 	// JAR file writer
 	FILE *jarfp;
+	// or a stream, if not writing to a file
+	unpack200_output *sink;
 	int default_modtime;
 
 	// Used by unix2dostime:
@@ -45,6 +50,11 @@ struct jar
 	uint32_t output_file_offset;
 	fillbytes deflated; // temporary buffer
 
+	// zlib level for entries, 0 = store
+	int deflate_level;
+	// compresses entries on other threads, if enabled
+	jar_compressor *compressor;
+
 	// pointer to outer unpacker, for error checks etc.
 	unpacker *u;
 
@@ -56,12 +66,9 @@ struct jar
 	void closeJarFile(bool central);
 
 	void init(unpacker *u_);
+	void setCompression(int level, int threads);
 
-	void free()
-	{
-		central_directory.free();
-		deflated.free();
-	}
+	void free();
 
 	void reset()
 	{
@@ -80,11 +87,14 @@ struct jar
 	void write_jar_header(const char *fname, bool store, int modtime, int len, int clen,
 						  unsigned int crc);
 	void write_central_directory();
+	void write_entry(jar_entry_job &entry);
+	void flush_entries(bool all);
 	uint32_t dostime(int y, int n, int d, int h, int m, int s);
 	uint32_t get_dostime(int modtime);
 
 	// The definitions of these depend on the NO_ZLIB option:
 	bool deflate_bytes(bytes &head, bytes &tail);
+	int deflate_flags();
 	static uint32_t get_crc32(uint32_t c, unsigned char *ptr, uint32_t len);
 };
 
@@ -53,6 +53,21 @@ LIBUTIL_EXPORT bool ensureFolderPathExists(QString filenamepath);
 
 LIBUTIL_EXPORT bool copyPath(QString src, QString dst);
 
+/**
+ * Copy a single file, sharing its data blocks with the source (reflink) when the
+ * file system supports it and falling back to a regular copy otherwise.
+ */
+LIBUTIL_EXPORT bool cloneFile(QString src, QString dst);
+
+/**
+ * Create a hard link at dst pointing to src.
+ * Fails if dst exists or the two paths are on different file systems.
+ */
+LIBUTIL_EXPORT bool hardlinkFile(QString src, QString dst);
+
+/// Number of hard links pointing at the file, or -1 if it can't be determined
+LIBUTIL_EXPORT int fileLinkCount(QString path);
+
 /// Opens the given file in the default application.
 LIBUTIL_EXPORT void openFileInDefaultProgram(QString filename);
 
@@ -20,6 +20,21 @@
 #include <QDesktopServices>
 #include <QUrl>
 
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#elif defined(Q_OS_MAC)
+#include <sys/clonefile.h>
+#endif
+
 QString PathCombine(QString path1, QString path2)
 {
     return QDir::cleanPath(path1 + QDir::separator() + path2);
@@ -124,11 +139,90 @@ bool copyPath(QString src, QString dst)
 
 	foreach(QString f, dir.entryList(QDir::Files))
 	{
-		QFile::copy(src + QDir::separator() + f, dst + QDir::separator() + f);
+		cloneFile(src + QDir::separator() + f, dst + QDir::separator() + f);
 	}
 	return true;
 }
 
+// try to share the data blocks of src with a new file at dst. no fallback.
+static bool reflinkFile(const QString &src, const QString &dst)
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+	QByteArray srcName = QFile::encodeName(src);
+	QByteArray dstName = QFile::encodeName(dst);
+	int in = ::open(srcName.constData(), O_RDONLY);
+	if (in < 0)
+		return false;
+	struct stat st;
+	if (::fstat(in, &st) != 0)
+	{
+		::close(in);
+		return false;
+	}
+	int out = ::open(dstName.constData(), O_WRONLY | O_CREAT | O_EXCL, st.st_mode & 0777);
+	if (out < 0)
+	{
+		::close(in);
+		return false;
+	}
+	bool ok = ::ioctl(out, FICLONE, in) == 0;
+	::close(out);
+	::close(in);
+	if (!ok)
+	{
+		::unlink(dstName.constData());
+	}
+	return ok;
+#elif defined(Q_OS_MAC)
+	return ::clonefile(QFile::encodeName(src).constData(), QFile::encodeName(dst).constData(),
+					   0) == 0;
+#else
+	Q_UNUSED(src);
+	Q_UNUSED(dst);
+	return false;
+#endif
+}
+
+bool cloneFile(QString src, QString dst)
+{
+	if (QFileInfo(dst).exists())
+		return false;
+	if (reflinkFile(src, dst))
+		return true;
+	return QFile::copy(src, dst);
+}
+
+bool hardlinkFile(QString src, QString dst)
+{
+#if defined(Q_OS_WIN)
+	return CreateHardLinkW((const wchar_t *)dst.utf16(), (const wchar_t *)src.utf16(), NULL);
+#else
+	return ::link(QFile::encodeName(src).constData(), QFile::encodeName(dst).constData()) == 0;
+#endif
+}
+
+int fileLinkCount(QString path)
+{
+#if defined(Q_OS_WIN)
+	HANDLE handle = CreateFileW((const wchar_t *)path.utf16(), 0,
+								FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+								OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return -1;
+	BY_HANDLE_FILE_INFORMATION info;
+	int result = -1;
+	if (GetFileInformationByHandle(handle, &info))
+		result = info.nNumberOfLinks;
+	CloseHandle(handle);
+	return result;
+#else
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+		return -1;
+	return st.st_nlink;
+#endif
+}
+
 void openDirInDefaultProgram(QString path, bool ensureExists)
 {
 	QDir parentPath;
@@ -462,6 +462,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 		// view->viewport()->setAttribute(Qt::WA_Hover);
 		auto delegate = new ListViewDelegate();
 		view->setItemDelegate(delegate);
+		connect(MMC->icons().get(), SIGNAL(iconUpdated(QString)), delegate,
+				SLOT(iconUpdated(QString)));
 		// view->setSpacing(10);
 		// view->setUniformItemWidths(true);
 
@@ -1444,6 +1446,7 @@ void MainWindow::on_actionExportInstance_triggered()
 				return;
 			}
 		}
+		m_selectedInstance->settings().flush();
 		if (!JlCompress::compressDir(output, m_selectedInstance->instanceRoot()))
 		{
 			QMessageBox::warning(this, tr("Error"), tr("Unable to export instance"));
@@ -1689,6 +1692,10 @@ void MainWindow::launchInstance(InstancePtr instance, AuthSessionPtr session,
 	if (!instance->prepareForLaunch(session, launchScript))
 		return;
 
+	// the game and any external tools should see the current settings on disk
+	instance->settings().flush();
+	MMC->settings()->flush();
+
 	MinecraftProcess *proc = new MinecraftProcess(instance);
 	proc->setLaunchScript(launchScript);
 	proc->setWorkdir(instance->minecraftRoot());
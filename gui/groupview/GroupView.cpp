@@ -10,6 +10,9 @@
 #include <QMimeData>
 #include <QCache>
 #include <QScrollBar>
+#include <QSet>
+
+#include <algorithm>
 
 #include "VisualGroup.h"
 #include "logger/QsLog.h"
@@ -50,11 +53,90 @@ void GroupView::setModel(QAbstractItemModel *model)
 void GroupView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
 							const QVector<int> &roles)
 {
-	scheduleDelayedItemsLayout();
+	// finish any pending full layout first, the groups have to match the model below
+	executeDelayedItemsLayout();
+	if (!topLeft.isValid() || bottomRight.row() >= m_groupOfRow.size())
+	{
+		scheduleDelayedItemsLayout();
+		return;
+	}
+
+	const QStyleOptionViewItem option = viewOptions();
+	QSet<VisualGroup *> changed;
+	for (int i = topLeft.row(); i <= bottomRight.row(); ++i)
+	{
+		const QModelIndex index = model()->index(i, 0);
+		VisualGroup *group = m_groupOfRow[i];
+		if (index.data(GroupViewRoles::GroupRole).toString() != group->text)
+		{
+			// moving between groups can create and remove groups. do it the long way.
+			scheduleDelayedItemsLayout();
+			return;
+		}
+		if (group->setItemHeight(i, itemDelegate()->sizeHint(option, index).height()))
+		{
+			changed.insert(group);
+		}
+	}
+
+	if (changed.isEmpty())
+	{
+		// nothing moved, only repaint the items themselves
+		viewport()->update(visualRegionForSelection(QItemSelection(topLeft, bottomRight)));
+		return;
+	}
+	for (auto group : changed)
+	{
+		group->update();
+	}
+	updateGroupPositions();
 }
+
 void GroupView::rowsInserted(const QModelIndex &parent, int start, int end)
 {
-	scheduleDelayedItemsLayout();
+	executeDelayedItemsLayout();
+	const int count = end - start + 1;
+	if (m_groupOfRow.size() == model()->rowCount())
+	{
+		// the pending layout already picked the new rows up
+		return;
+	}
+	if (parent.isValid() || m_groupOfRow.size() + count != model()->rowCount())
+	{
+		scheduleDelayedItemsLayout();
+		return;
+	}
+
+	QSet<VisualGroup *> changed;
+	for (auto group : m_groups)
+	{
+		if (group->shiftItems(start, count))
+		{
+			changed.insert(group);
+		}
+	}
+
+	const QStyleOptionViewItem option = viewOptions();
+	m_groupOfRow.insert(start, count, nullptr);
+	for (int i = start; i <= end; ++i)
+	{
+		const QModelIndex index = model()->index(i, 0);
+		const QString groupName = index.data(GroupViewRoles::GroupRole).toString();
+		VisualGroup *group = category(groupName);
+		if (!group)
+		{
+			group = createCategory(groupName);
+		}
+		group->insertItem(i, itemDelegate()->sizeHint(option, index).height());
+		m_groupOfRow[i] = group;
+		changed.insert(group);
+	}
+
+	for (auto group : changed)
+	{
+		group->update();
+	}
+	updateGroupPositions();
 }
 
 void GroupView::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
@@ -80,27 +162,45 @@ inline bool operator<(const LocaleString &lhs, const LocaleString &rhs)
 
 void GroupView::updateGeometries()
 {
-	geometryCache.clear();
-	int previousScroll = verticalScrollBar()->value();
+	QHash<QString, VisualGroup *> oldGroups;
+	for (auto group : m_groups)
+	{
+		oldGroups.insert(group->text, group);
+	}
 
 	QMap<LocaleString, VisualGroup *> cats;
+	QHash<QString, VisualGroup *> groupsByName;
 
-	for (int i = 0; i < model()->rowCount(); ++i)
+	const QStyleOptionViewItem option = viewOptions();
+	const int rowCount = model()->rowCount();
+	m_groupOfRow.resize(rowCount);
+	VisualGroup *group = nullptr;
+	for (int i = 0; i < rowCount; ++i)
 	{
-		const QString groupName =
-			model()->index(i, 0).data(GroupViewRoles::GroupRole).toString();
-		if (!cats.contains(groupName))
+		const QModelIndex index = model()->index(i, 0);
+		const QString groupName = index.data(GroupViewRoles::GroupRole).toString();
+		// rows of the same group are usually next to each other
+		if (!group || group->text != groupName)
 		{
-			VisualGroup *old = this->category(groupName);
-			if (old)
-			{
-				cats.insert(groupName, new VisualGroup(old));
-			}
-			else
+			group = groupsByName.value(groupName);
+			if (!group)
 			{
-				cats.insert(groupName, new VisualGroup(groupName, this));
+				// keep the existing groups, so they remember if they were collapsed
+				group = oldGroups.take(groupName);
+				if (group)
+				{
+					group->clearItems();
+				}
+				else
+				{
+					group = new VisualGroup(groupName, this);
+				}
+				groupsByName.insert(groupName, group);
+				cats.insert(groupName, group);
 			}
 		}
+		group->insertItem(i, itemDelegate()->sizeHint(option, index).height());
+		m_groupOfRow[i] = group;
 	}
 
 	/*if (m_editedCategory)
@@ -108,7 +208,11 @@ void GroupView::updateGeometries()
 		m_editedCategory = cats[m_editedCategory->text];
 	}*/
 
-	qDeleteAll(m_groups);
+	if (oldGroups.values().contains(m_pressedCategory))
+	{
+		m_pressedCategory = nullptr;
+	}
+	qDeleteAll(oldGroups);
 	m_groups = cats.values();
 
 	for (auto cat : m_groups)
@@ -116,6 +220,14 @@ void GroupView::updateGeometries()
 		cat->update();
 	}
 
+	updateGroupPositions();
+}
+
+void GroupView::updateGroupPositions()
+{
+	geometryCache.clear();
+	int previousScroll = verticalScrollBar()->value();
+
 	if (m_groups.isEmpty())
 	{
 		verticalScrollBar()->setRange(0, 0);
@@ -173,6 +285,11 @@ bool GroupView::isIndexHidden(const QModelIndex &index) const
 
 VisualGroup *GroupView::category(const QModelIndex &index) const
 {
+	const int row = index.row();
+	if (row >= 0 && row < m_groupOfRow.size())
+	{
+		return m_groupOfRow[row];
+	}
 	return category(index.data(GroupViewRoles::GroupRole).toString());
 }
 
@@ -190,8 +307,10 @@ VisualGroup *GroupView::category(const QString &cat) const
 
 VisualGroup *GroupView::categoryAt(const QPoint &pos) const
 {
-	for (auto group : m_groups)
+	auto range = categoriesIn(pos.y(), pos.y());
+	for (int i = range.first; i < range.second; ++i)
 	{
+		VisualGroup *group = m_groups.at(i);
 		if(group->hitScan(pos) & VisualGroup::CheckboxHit)
 		{
 			return group;
@@ -200,6 +319,28 @@ VisualGroup *GroupView::categoryAt(const QPoint &pos) const
 	return nullptr;
 }
 
+VisualGroup *GroupView::createCategory(const QString &cat)
+{
+	auto group = new VisualGroup(cat, this);
+	auto it = std::lower_bound(m_groups.begin(), m_groups.end(), LocaleString(cat),
+							   [](const VisualGroup *other, const LocaleString &text)
+	{ return LocaleString(other->text) < text; });
+	m_groups.insert(it, group);
+	return group;
+}
+
+QPair<int, int> GroupView::categoriesIn(int top, int bottom) const
+{
+	// groups are stacked top to bottom, so both ends can be found by bisection
+	auto first = std::lower_bound(m_groups.begin(), m_groups.end(), top,
+								  [](const VisualGroup *group, int y)
+	{ return group->verticalPosition() + group->totalHeight() <= y; });
+	auto last = std::upper_bound(first, m_groups.end(), bottom,
+								 [](int y, const VisualGroup *group)
+	{ return y < group->verticalPosition(); });
+	return qMakePair(int(first - m_groups.begin()), int(last - m_groups.begin()));
+}
+
 int GroupView::calculateItemsPerRow() const
 {
 	return qFloor((qreal)(contentWidth()) / (qreal)(itemWidth() + m_spacing));
@@ -333,7 +474,7 @@ void GroupView::mouseReleaseEvent(QMouseEvent *event)
 		if (state() == ExpandingState)
 		{
 			m_pressedCategory->collapsed = false;
-			updateGeometries();
+			updateGroupPositions();
 			viewport()->update();
 			event->accept();
 			return;
@@ -341,7 +482,7 @@ void GroupView::mouseReleaseEvent(QMouseEvent *event)
 		else if (state() == CollapsingState)
 		{
 			m_pressedCategory->collapsed = true;
-			updateGeometries();
+			updateGroupPositions();
 			viewport()->update();
 			event->accept();
 			return;
@@ -398,7 +539,11 @@ void GroupView::paintEvent(QPaintEvent *event)
 
 	int wpWidth = viewport()->width();
 	option.rect.setWidth(wpWidth);
-	for (int i = 0; i < m_groups.size(); ++i)
+
+	// only the groups and rows that intersect the damaged area are painted
+	const QRect area = event->rect().translated(offset());
+	auto groupRange = categoriesIn(area.top(), area.bottom());
+	for (int i = groupRange.first; i < groupRange.second; ++i)
 	{
 		VisualGroup *category = m_groups.at(i);
 		int y = category->verticalPosition();
@@ -410,36 +555,40 @@ void GroupView::paintEvent(QPaintEvent *event)
 		option.rect.setLeft(m_leftMargin);
 		option.rect.setRight(wpWidth - m_rightMargin);
 		category->drawHeader(&painter, option);
-		y += category->totalHeight() + m_categoryMargin;
 		option.rect = backup;
 	}
 
-	for (int i = 0; i < model()->rowCount(); ++i)
+	for (int i = groupRange.first; i < groupRange.second; ++i)
 	{
-		const QModelIndex index = model()->index(i, 0);
-		if (isIndexHidden(index))
-		{
-			continue;
-		}
-		Qt::ItemFlags flags = index.flags();
-		option.rect = visualRect(index);
-		option.features |=
-			QStyleOptionViewItemV2::WrapText; // FIXME: what is the meaning of this anyway?
-		if (flags & Qt::ItemIsSelectable && selectionModel()->isSelected(index))
-		{
-			option.state |= selectionModel()->isSelected(index) ? QStyle::State_Selected
-																: QStyle::State_None;
-		}
-		else
-		{
-			option.state &= ~QStyle::State_Selected;
-		}
-		option.state |= (index == currentIndex()) ? QStyle::State_HasFocus : QStyle::State_None;
-		if (!(flags & Qt::ItemIsEnabled))
+		VisualGroup *category = m_groups.at(i);
+		const int contentTop = category->contentTop();
+		auto rowRange = category->rowsIn(area.top() - contentTop, area.bottom() - contentTop);
+		for (int r = rowRange.first; r < rowRange.second; ++r)
 		{
-			option.state &= ~QStyle::State_Enabled;
+			for (auto &index : category->rows[r].items)
+			{
+				Qt::ItemFlags flags = index.flags();
+				option.rect = visualRect(index);
+				option.features |=
+					QStyleOptionViewItemV2::WrapText; // FIXME: what is the meaning of this anyway?
+				if (flags & Qt::ItemIsSelectable && selectionModel()->isSelected(index))
+				{
+					option.state |= selectionModel()->isSelected(index) ? QStyle::State_Selected
+																		: QStyle::State_None;
+				}
+				else
+				{
+					option.state &= ~QStyle::State_Selected;
+				}
+				option.state |=
+					(index == currentIndex()) ? QStyle::State_HasFocus : QStyle::State_None;
+				if (!(flags & Qt::ItemIsEnabled))
+				{
+					option.state &= ~QStyle::State_Enabled;
+				}
+				itemDelegate()->paint(&painter, option, index);
+			}
 		}
-		itemDelegate()->paint(&painter, option, index);
 	}
 
 	/*
@@ -481,7 +630,12 @@ void GroupView::resizeEvent(QResizeEvent *event)
 	{
 		m_currentCursorColumn = -1;
 		m_currentItemsPerRow = newItemsPerRow;
-		updateGeometries();
+		// item heights do not depend on the width, so only the rows need reflowing
+		for (auto group : m_groups)
+		{
+			group->update();
+		}
+		updateGroupPositions();
 	}
 }
 
@@ -616,7 +770,7 @@ QRect GroupView::geometryRect(const QModelIndex &index) const
 	// int y = pos.second;
 
 	QRect out;
-	out.setTop(cat->verticalPosition() + cat->headerHeight() + 5 + cat->rowTopOf(index));
+	out.setTop(cat->contentTop() + cat->rowTopOf(index));
 	out.setLeft(m_spacing + x * (itemWidth() + m_spacing));
 	out.setSize(itemDelegate()->sizeHint(viewOptions(), index));
 	geometryCache.insert(row, new QRect(out));
@@ -625,12 +779,26 @@ QRect GroupView::geometryRect(const QModelIndex &index) const
 
 QModelIndex GroupView::indexAt(const QPoint &point) const
 {
-	for (int i = 0; i < model()->rowCount(); ++i)
+	const QPoint pos = point + offset();
+	auto groupRange = categoriesIn(pos.y(), pos.y());
+	for (int i = groupRange.first; i < groupRange.second; ++i)
 	{
-		QModelIndex index = model()->index(i, 0);
-		if (visualRect(index).contains(point))
+		VisualGroup *category = m_groups.at(i);
+		const int y = pos.y() - category->contentTop();
+		auto rowRange = category->rowsIn(y, y);
+		const int column = (pos.x() - m_spacing) / (itemWidth() + m_spacing);
+		for (int r = rowRange.first; r < rowRange.second; ++r)
 		{
-			return index;
+			const VisualRow &row = category->rows[r];
+			if (pos.x() < m_spacing || column >= row.size())
+			{
+				continue;
+			}
+			const QModelIndex &index = row.items[column];
+			if (geometryRect(index).contains(pos))
+			{
+				return index;
+			}
 		}
 	}
 	return QModelIndex();
@@ -639,14 +807,24 @@ QModelIndex GroupView::indexAt(const QPoint &point) const
 void GroupView::setSelection(const QRect &rect,
 							 const QItemSelectionModel::SelectionFlags commands)
 {
-	for (int i = 0; i < model()->rowCount(); ++i)
+	const QRect area = rect.translated(offset());
+	auto groupRange = categoriesIn(area.top(), area.bottom());
+	for (int i = groupRange.first; i < groupRange.second; ++i)
 	{
-		QModelIndex index = model()->index(i, 0);
-		QRect itemRect = visualRect(index);
-		if (itemRect.intersects(rect))
+		VisualGroup *category = m_groups.at(i);
+		const int contentTop = category->contentTop();
+		auto rowRange = category->rowsIn(area.top() - contentTop, area.bottom() - contentTop);
+		for (int r = rowRange.first; r < rowRange.second; ++r)
 		{
-			selectionModel()->select(index, commands);
-			update(itemRect.translated(-offset()));
+			for (auto &index : category->rows[r].items)
+			{
+				QRect itemRect = visualRect(index);
+				if (itemRect.intersects(rect))
+				{
+					selectionModel()->select(index, commands);
+					update(itemRect.translated(-offset()));
+				}
+			}
 		}
 	}
 }
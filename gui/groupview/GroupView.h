@@ -77,7 +77,10 @@ protected:
 
 private:
 	friend struct VisualGroup;
+	/// groups in the order they are stacked, top to bottom
 	QList<VisualGroup *> m_groups;
+	/// model row -> the group it was laid out in
+	QVector<VisualGroup *> m_groupOfRow;
 
 	// geometry
 	int m_leftMargin = 5;
@@ -94,13 +97,17 @@ private:
 	QPoint m_pressedPosition;
 	QPersistentModelIndex m_pressedIndex;
 	bool m_pressedAlreadySelected;
-	VisualGroup *m_pressedCategory;
+	VisualGroup *m_pressedCategory = nullptr;
 	QItemSelectionModel::SelectionFlag m_ctrlDragSelectionFlag;
 	QPoint m_lastDragPosition;
 
 	VisualGroup *category(const QModelIndex &index) const;
 	VisualGroup *category(const QString &cat) const;
 	VisualGroup *categoryAt(const QPoint &pos) const;
+	VisualGroup *createCategory(const QString &cat);
+
+	/// range [first, last) of the groups overlapping the vertical range [top, bottom]
+	QPair<int, int> categoriesIn(int top, int bottom) const;
 
 	int itemsPerRow() const
 	{
@@ -109,6 +116,8 @@ private:
 	int contentWidth() const;
 
 private: /* methods */
+	/// stack the groups and update the scroll bar to match
+	void updateGroupPositions();
 	int itemWidth() const;
 	int calculateItemsPerRow() const;
 	int verticalScrollToValue(const QModelIndex &index, const QRect &rect,
@@ -51,6 +51,8 @@ static void viewItemTextLayout(QTextLayout &textLayout, int lineWidth, qreal &he
 
 ListViewDelegate::ListViewDelegate(QObject *parent) : QStyledItemDelegate(parent)
 {
+	// in KiB. a tile is about 35 KiB, so this keeps around a thousand of them
+	m_tileCache.setMaxCost(40 * 1024);
 }
 
 void drawSelectionRect(QPainter *painter, const QStyleOptionViewItemV4 &option,
@@ -186,19 +188,12 @@ static QSize viewItemTextSize(const QStyleOptionViewItemV4 *option)
 	return QSize(size.width() + 2 * textMargin, size.height());
 }
 
-void ListViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
-							 const QModelIndex &index) const
+// draws everything except the progress overlay, which changes too often to be cached
+static void drawTile(QPainter *painter, QStyleOptionViewItemV4 &opt, BaseInstance *instance)
 {
-	QStyleOptionViewItemV4 opt = option;
-	initStyleOption(&opt, index);
 	painter->save();
 	painter->setClipRect(opt.rect);
 
-	opt.features |= QStyleOptionViewItem::WrapText;
-	opt.text = index.data().toString();
-	opt.textElideMode = Qt::ElideRight;
-	opt.displayAlignment = Qt::AlignTop | Qt::AlignHCenter;
-
 	QStyle *style = opt.widget ? opt.widget->style() : QApplication::style();
 
 	// const int iconSize =  style->pixelMetric(QStyle::PM_IconViewIconSize);
@@ -317,18 +312,100 @@ void ListViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
 		line.draw(painter, position);
 	}
 
+	if (instance)
+	{
+		drawBadges(painter, opt, instance);
+	}
+
+	painter->restore();
+}
+
+void ListViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+							 const QModelIndex &index) const
+{
+	QStyleOptionViewItemV4 opt = option;
+	initStyleOption(&opt, index);
+
+	opt.features |= QStyleOptionViewItem::WrapText;
+	opt.text = index.data().toString();
+	opt.textElideMode = Qt::ElideRight;
+	opt.displayAlignment = Qt::AlignTop | Qt::AlignHCenter;
+
 	// FIXME: this really has no business of being here. Make generic.
 	auto instance = (BaseInstance*)index.data(InstanceList::InstancePointerRole)
 			.value<void *>();
-	if (instance)
+
+	TileKey key;
+	key.text = opt.text;
+	key.iconKey = opt.icon.cacheKey();
+	key.size = opt.rect.size();
+	key.state = opt.state & (QStyle::State_Selected | QStyle::State_Enabled |
+							 QStyle::State_Active | QStyle::State_Open);
+	key.widgetEnabled = opt.widget && opt.widget->isEnabled();
+	key.flags = instance ? int(instance->flags()) : 0;
+	key.paletteKey = opt.palette.cacheKey();
+	key.font = opt.font;
+	key.pixelRatio = painter->device()->devicePixelRatio();
+
+	if (!m_cacheTiles)
 	{
-		drawBadges(painter, opt, instance);
+		QStyleOptionViewItemV4 tileOpt = opt;
+		drawTile(painter, tileOpt, instance);
+		drawProgressOverlay(painter, opt, index.data(GroupViewRoles::ProgressValueRole).toInt(),
+							index.data(GroupViewRoles::ProgressMaximumRole).toInt());
+		return;
 	}
 
+	// instances that are not loaded yet still have an id. other models only have the text.
+	QString id = index.data(InstanceList::InstanceIDRole).toString();
+	if (id.isEmpty())
+	{
+		id = opt.text;
+	}
+
+	// a tile is only ever replaced when something it shows changed, so renamed instances,
+	// new flags and changed icons all end up here
+	QPixmap pixmap;
+	Tile *tile = m_tileCache.object(id);
+	if (tile && tile->key == key)
+	{
+		pixmap = tile->pixmap;
+	}
+	else
+	{
+		pixmap = QPixmap(opt.rect.size() * key.pixelRatio);
+		pixmap.setDevicePixelRatio(key.pixelRatio);
+		pixmap.fill(Qt::transparent);
+		{
+			QPainter tilePainter(&pixmap);
+			QStyleOptionViewItemV4 tileOpt = opt;
+			tileOpt.rect.moveTo(0, 0);
+			drawTile(&tilePainter, tileOpt, instance);
+		}
+		// cost is in KiB
+		const int cost = pixmap.width() * pixmap.height() * 4 / 1024;
+		m_tileCache.insert(id, new Tile{key, pixmap}, qMax(cost, 1));
+	}
+	painter->drawPixmap(opt.rect.topLeft(), pixmap);
+
 	drawProgressOverlay(painter, opt, index.data(GroupViewRoles::ProgressValueRole).toInt(),
 						index.data(GroupViewRoles::ProgressMaximumRole).toInt());
+}
 
-	painter->restore();
+void ListViewDelegate::setTileCacheEnabled(bool enabled)
+{
+	m_cacheTiles = enabled;
+	if (!enabled)
+	{
+		m_tileCache.clear();
+	}
+}
+
+void ListViewDelegate::iconUpdated(QString key)
+{
+	Q_UNUSED(key);
+	// tiles don't know which icon they show, but icons change rarely
+	m_tileCache.clear();
 }
 
 QSize ListViewDelegate::sizeHint(const QStyleOptionViewItem &option,
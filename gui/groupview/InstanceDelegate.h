@@ -17,19 +17,60 @@
 
 #include <QStyledItemDelegate>
 #include <QCache>
+#include <QPixmap>
+#include <QFont>
 
 class ListViewDelegate : public QStyledItemDelegate
 {
+	Q_OBJECT
 public:
 	explicit ListViewDelegate(QObject *parent = 0);
 
 	static QPixmap requestBadgePixmap(const QString &key);
 
+	/// paint every tile directly instead of going through the tile cache
+	void setTileCacheEnabled(bool enabled);
+
+public
+slots:
+	/// throw away the pre-rendered tiles, some of them may show the old icon
+	void iconUpdated(QString key);
+
 protected:
 	void paint(QPainter *painter, const QStyleOptionViewItem &option,
 			   const QModelIndex &index) const;
 	QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
 
 private:
+	/// everything a tile looks like depends on, except for the progress overlay
+	struct TileKey
+	{
+		QString text;
+		qint64 iconKey = 0;
+		QSize size;
+		int state = 0;
+		bool widgetEnabled = false;
+		int flags = 0;
+		qint64 paletteKey = 0;
+		QFont font;
+		int pixelRatio = 1;
+
+		bool operator==(const TileKey &other) const
+		{
+			return iconKey == other.iconKey && size == other.size && state == other.state &&
+				   widgetEnabled == other.widgetEnabled && flags == other.flags &&
+				   paletteKey == other.paletteKey && pixelRatio == other.pixelRatio &&
+				   text == other.text && font == other.font;
+		}
+	};
+	struct Tile
+	{
+		TileKey key;
+		QPixmap pixmap;
+	};
+	/// pre-rendered tiles, by instance id
+	mutable QCache<QString, Tile> m_tileCache;
+	bool m_cacheTiles = true;
+
 	static QCache<QString, QPixmap> m_pixmapCache;
 };
@@ -4,6 +4,7 @@
 #include <QPainter>
 #include <QtMath>
 #include <QApplication>
+#include <algorithm>
 
 #include "GroupView.h"
 
@@ -11,24 +12,20 @@ VisualGroup::VisualGroup(const QString &text, GroupView *view) : view(view), tex
 {
 }
 
-VisualGroup::VisualGroup(const VisualGroup *other)
-	: view(other->view), text(other->text), collapsed(other->collapsed)
-{
-}
-
 void VisualGroup::update()
 {
-	auto temp_items = items();
 	auto itemsPerRow = view->itemsPerRow();
 
-	int numRows = qMax(1, qCeil((qreal)temp_items.size() / (qreal)itemsPerRow));
+	int numRows = qMax(1, qCeil((qreal)itemRows.size() / (qreal)itemsPerRow));
 	rows = QVector<VisualRow>(numRows);
+	positions.clear();
+	positions.reserve(itemRows.size());
 
 	int maxRowHeight = 0;
 	int positionInRow = 0;
 	int currentRow = 0;
 	int offsetFromTop = 0;
-	for (auto item: temp_items)
+	for (int i = 0; i < itemRows.size(); i++)
 	{
 		if(positionInRow == itemsPerRow)
 		{
@@ -39,34 +36,66 @@ void VisualGroup::update()
 			positionInRow = 0;
 			maxRowHeight = 0;
 		}
-		auto itemHeight = view->itemDelegate()->sizeHint(view->viewOptions(), item).height();
+		auto itemHeight = itemHeights[i];
 		if(itemHeight > maxRowHeight)
 		{
 			maxRowHeight = itemHeight;
 		}
-		rows[currentRow].items.append(item);
+		positions.insert(itemRows[i], qMakePair(positionInRow, currentRow));
+		rows[currentRow].items.append(view->model()->index(itemRows[i], 0));
 		positionInRow++;
 	}
 	rows[currentRow].height = maxRowHeight;
 	rows[currentRow].top = offsetFromTop;
 }
 
-QPair<int, int> VisualGroup::positionOf(const QModelIndex &index) const
+void VisualGroup::clearItems()
+{
+	itemRows.clear();
+	itemHeights.clear();
+}
+
+void VisualGroup::insertItem(int row, int height)
+{
+	auto it = std::lower_bound(itemRows.begin(), itemRows.end(), row);
+	int i = it - itemRows.begin();
+	itemRows.insert(i, row);
+	itemHeights.insert(i, height);
+}
+
+bool VisualGroup::shiftItems(int start, int count)
 {
-	int x = 0;
-	int y = 0;
-	for (auto & row: rows)
+	auto it = std::lower_bound(itemRows.begin(), itemRows.end(), start);
+	if (it == itemRows.end())
 	{
-		for(auto x = 0; x < row.items.size(); x++)
-		{
-			if(row.items[x] == index)
-			{
-				return qMakePair(x,y);
-			}
-		}
-		y++;
+		return false;
+	}
+	for (; it != itemRows.end(); ++it)
+	{
+		*it += count;
+	}
+	return true;
+}
+
+bool VisualGroup::setItemHeight(int row, int height)
+{
+	auto it = std::lower_bound(itemRows.begin(), itemRows.end(), row);
+	if (it == itemRows.end() || *it != row)
+	{
+		return false;
+	}
+	int &current = itemHeights[it - itemRows.begin()];
+	if (current == height)
+	{
+		return false;
 	}
-	return qMakePair(x, y);
+	current = height;
+	return true;
+}
+
+QPair<int, int> VisualGroup::positionOf(const QModelIndex &index) const
+{
+	return positions.value(index.row(), qMakePair(0, rows.size()));
 }
 
 int VisualGroup::rowTopOf(const QModelIndex &index) const
@@ -81,6 +110,25 @@ int VisualGroup::rowHeightOf(const QModelIndex &index) const
 	return rows[position.second].height;
 }
 
+int VisualGroup::contentTop() const
+{
+	return verticalPosition() + headerHeight() + 5;
+}
+
+QPair<int, int> VisualGroup::rowsIn(int top, int bottom) const
+{
+	if (collapsed)
+	{
+		return qMakePair(0, 0);
+	}
+	// rows are stacked top to bottom, so both ends can be found by bisection
+	auto first = std::lower_bound(rows.begin(), rows.end(), top, [](const VisualRow &row, int y)
+	{ return row.top + row.height <= y; });
+	auto last = std::upper_bound(first, rows.end(), bottom, [](int y, const VisualRow &row)
+	{ return y < row.top; });
+	return qMakePair(int(first - rows.begin()), int(last - rows.begin()));
+}
+
 VisualGroup::HitResults VisualGroup::hitScan(const QPoint &pos) const
 {
 	VisualGroup::HitResults results = VisualGroup::NoHit;
@@ -289,13 +337,9 @@ int VisualGroup::verticalPosition() const
 QList<QModelIndex> VisualGroup::items() const
 {
 	QList<QModelIndex> indices;
-	for (int i = 0; i < view->model()->rowCount(); ++i)
+	for (int row : itemRows)
 	{
-		const QModelIndex index = view->model()->index(i, 0);
-		if (index.data(GroupViewRoles::GroupRole).toString() == text)
-		{
-			indices.append(index);
-		}
+		indices.append(view->model()->index(row, 0));
 	}
 	return indices;
 }
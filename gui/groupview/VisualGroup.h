@@ -3,6 +3,7 @@
 #include <QString>
 #include <QRect>
 #include <QVector>
+#include <QHash>
 #include <QStyleOption>
 
 class GroupView;
@@ -28,7 +29,6 @@ struct VisualGroup
 {
 /* constructors */
 	VisualGroup(const QString &text, GroupView *view);
-	VisualGroup(const VisualGroup *other);
 
 /* data */
 	GroupView *view = nullptr;
@@ -38,10 +38,29 @@ struct VisualGroup
 	int firstItemIndex = 0;
 	int m_verticalPosition = 0;
 
+	/// model rows of the items in this group, ascending
+	QVector<int> itemRows;
+	/// delegate height of each item in itemRows, so the rows can be reflowed without measuring
+	QVector<int> itemHeights;
+	/// model row -> x/y position inside the group (in items!)
+	QHash<int, QPair<int, int>> positions;
+
 /* logic */
-	/// update the internal list of items and flow them into the rows.
+	/// flow the items into the rows, using the cached item heights.
 	void update();
 
+	/// forget all items
+	void clearItems();
+
+	/// add the item at the given model row, keeping the items ordered
+	void insertItem(int row, int height);
+
+	/// move the items at or after the model row start down by count rows. returns true if any moved
+	bool shiftItems(int start, int count);
+
+	/// change the cached height of the item at the given model row. returns true if it changed
+	bool setItemHeight(int row, int height);
+
 	/// draw the header at y-position.
 	void drawHeader(QPainter *painter, const QStyleOptionViewItem &option);
 
@@ -69,6 +88,12 @@ struct VisualGroup
 	/// height of the row of the given item
 	int rowHeightOf(const QModelIndex &index) const;
 
+	/// the height at which the first row of items starts, in pixels
+	int contentTop() const;
+
+	/// range [first, last) of the rows overlapping the relative vertical range [top, bottom]
+	QPair<int, int> rowsIn(int top, int bottom) const;
+
 	/// x/y position of the given item inside the group (in items!)
 	QPair<int, int> positionOf(const QModelIndex &index) const;
 
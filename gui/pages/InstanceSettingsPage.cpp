@@ -36,6 +36,8 @@ bool InstanceSettingsPage::apply()
 
 void InstanceSettingsPage::applySettings()
 {
+	m_settings->beginBatch();
+
 	// Console
 	bool console = ui->consoleSettingsBox->isChecked();
 	m_settings->set("OverrideConsole", console);
@@ -123,6 +125,7 @@ void InstanceSettingsPage::applySettings()
 		m_settings->reset("PreLaunchCommand");
 		m_settings->reset("PostExitCommand");
 	}
+	m_settings->commit();
 }
 
 void InstanceSettingsPage::loadSettings()
@@ -8,6 +8,7 @@
 #include <QShortcut>
 
 #include "logic/MinecraftProcess.h"
+#include "logic/LogModel.h"
 #include "gui/GuiUtil.h"
 
 LogPage::LogPage(MinecraftProcess *proc, QWidget *parent)
@@ -15,11 +16,13 @@ LogPage::LogPage(MinecraftProcess *proc, QWidget *parent)
 {
 	ui->setupUi(this);
 	ui->tabWidget->tabBar()->hide();
-	connect(m_process, SIGNAL(log(QString, MessageLevel::Enum)), this,
-			SLOT(write(QString, MessageLevel::Enum)));
+	connect(m_process, SIGNAL(log(LogBlock)), this, SLOT(write(LogBlock)));
 
-	// create the format and set its font
-	defaultFormat = new QTextCharFormat(ui->text->currentCharFormat());
+	// the view only lays out the visible lines, the model drops the oldest ones
+	m_model = new LogModel(MMC->settings()->get("ConsoleMaxLines").toInt(), this);
+	ui->text->setModel(m_model);
+
+	// set the font
 	QString fontFamily = MMC->settings()->get("ConsoleFont").toString();
 	bool conversionOk = false;
 	int fontSize = MMC->settings()->get("ConsoleFontSize").toInt(&conversionOk);
@@ -27,7 +30,7 @@ LogPage::LogPage(MinecraftProcess *proc, QWidget *parent)
 	{
 		fontSize = 11;
 	}
-	defaultFormat->setFont(QFont(fontFamily, fontSize));
+	ui->text->setFont(QFont(fontFamily, fontSize));
 
 	auto findShortcut = new QShortcut(QKeySequence(QKeySequence::Find), this);
 	connect(findShortcut, SIGNAL(activated()), SLOT(findActivated()));
@@ -41,7 +44,6 @@ LogPage::LogPage(MinecraftProcess *proc, QWidget *parent)
 LogPage::~LogPage()
 {
 	delete ui;
-	delete defaultFormat;
 }
 
 bool LogPage::apply()
@@ -56,17 +58,17 @@ bool LogPage::shouldDisplay() const
 
 void LogPage::on_btnPaste_clicked()
 {
-	GuiUtil::uploadPaste(ui->text->toPlainText(), this);
+	GuiUtil::uploadPaste(m_model->toPlainText(), this);
 }
 
 void LogPage::on_btnCopy_clicked()
 {
-	GuiUtil::setClipboardText(ui->text->toPlainText());
+	GuiUtil::setClipboardText(m_model->toPlainText());
 }
 
 void LogPage::on_btnClear_clicked()
 {
-	ui->text->clear();
+	m_model->clear();
 }
 
 void LogPage::on_trackLogCheckbox_clicked(bool checked)
@@ -92,48 +94,64 @@ void LogPage::findActivated()
 	// focus the search bar if it doesn't have focus
 	if (!ui->searchBar->hasFocus())
 	{
-		auto searchForCursor = ui->text->textCursor();
-		auto searchForString = searchForCursor.selectedText();
-		if (searchForString.size())
-		{
-			ui->searchBar->setText(searchForString);
-		}
 		ui->searchBar->setFocus();
 		ui->searchBar->selectAll();
 	}
 }
 
-void LogPage::findNextActivated()
+void LogPage::findText(bool backwards)
 {
 	auto toSearch = ui->searchBar->text();
-	if (toSearch.size())
+	if (!toSearch.size())
+	{
+		return;
+	}
+	// continue from the current line, like searching in a document would
+	int current = ui->text->currentIndex().row();
+	int from;
+	if (backwards)
+	{
+		from = current == -1 ? m_model->rowCount() - 1 : current - 1;
+	}
+	else
+	{
+		from = current + 1;
+	}
+	int row = m_model->find(toSearch, from, backwards);
+	if (row == -1)
 	{
-		ui->text->find(toSearch);
+		return;
 	}
+	auto index = m_model->index(row);
+	ui->text->setCurrentIndex(index);
+	ui->text->scrollTo(index);
+}
+
+void LogPage::findNextActivated()
+{
+	findText(false);
 }
 
 void LogPage::findPreviousActivated()
 {
-	auto toSearch = ui->searchBar->text();
-	if (toSearch.size())
-	{
-		ui->text->find(toSearch, QTextDocument::FindBackward);
-	}
+	findText(true);
 }
 
-void LogPage::write(QString data, MessageLevel::Enum mode)
+void LogPage::write(LogBlock lines)
 {
 	if (!m_write_active)
 	{
-		if (mode != MessageLevel::PrePost && mode != MessageLevel::MultiMC)
+		LogBlock filtered;
+		for (auto &line : lines)
 		{
-			return;
+			if (line.level == MessageLevel::PrePost || line.level == MessageLevel::MultiMC)
+			{
+				filtered.append(line);
+			}
 		}
+		lines.swap(filtered);
 	}
 
-	// save the cursor so it can be restored.
-	auto savedCursor = ui->text->cursor();
-
 	QScrollBar *bar = ui->text->verticalScrollBar();
 	int max_bar = bar->maximum();
 	int val_bar = bar->value();
@@ -148,75 +166,20 @@ void LogPage::write(QString data, MessageLevel::Enum mode)
 			m_scroll_active = val_bar == max_bar;
 		}
 	}
-	if (data.endsWith('\n'))
-		data = data.left(data.length() - 1);
-	QStringList paragraphs = data.split('\n');
-	QStringList filtered;
-	for (QString &paragraph : paragraphs)
-	{
-		//TODO: implement filtering here.
-		filtered.append(paragraph);
-	}
-	QListIterator<QString> iter(filtered);
-	QTextCharFormat format(*defaultFormat);
-
-	switch(mode)
-	{
-		case MessageLevel::MultiMC:
-		{
-			format.setForeground(QColor("blue"));
-			break;
-		}
-		case MessageLevel::Debug:
-		{
-			format.setForeground(QColor("green"));
-			break;
-		}
-		case MessageLevel::Warning:
-		{
-			format.setForeground(QColor("orange"));
-			break;
-		}
-		case MessageLevel::Error:
-		{
-			format.setForeground(QColor("red"));
-			break;
-		}
-		case MessageLevel::Fatal:
-		{
-			format.setForeground(QColor("red"));
-			format.setBackground(QColor("black"));
-			break;
-		}
-		case MessageLevel::PrePost:
-		{
-			format.setForeground(QColor("grey"));
-			break;
-		}
-		case MessageLevel::Info:
-		case MessageLevel::Message:
-		default:
-		{
-			// do nothing, keep original
-		}
-	}
 
-	while (iter.hasNext())
-	{
-		// append a paragraph/line
-		auto workCursor = ui->text->textCursor();
-		workCursor.movePosition(QTextCursor::End);
-		workCursor.insertText(iter.next(), format);
-		workCursor.insertBlock();
-	}
+	int dropped = m_model->append(lines);
 
 	if (isVisible())
 	{
 		if (m_scroll_active)
 		{
-			bar->setValue(bar->maximum());
+			ui->text->scrollToBottom();
+		}
+		else if (dropped)
+		{
+			// the view scrolls by lines, keep the same lines in view as the old ones go away
+			bar->setValue(qMax(0, val_bar - dropped));
 		}
 		m_last_scroll_value = bar->value();
 	}
-	ui->text->setCursor(savedCursor);
 }
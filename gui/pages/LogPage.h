@@ -25,11 +25,11 @@
 
 class EnabledItemFilter;
 class MinecraftProcess;
+class LogModel;
 namespace Ui
 {
 class LogPage;
 }
-class QTextCharFormat;
 
 class LogPage : public QWidget, public BasePage
 {
@@ -59,12 +59,10 @@ public:
 
 private slots:
 	/**
-	 * @brief write a string
-	 * @param data the string
-	 * @param mode the WriteMode
-	 * lines have to be put through this as a whole!
+	 * @brief write a batch of lines
+	 * @param lines the lines, with their levels
 	 */
-	void write(QString data, MessageLevel::Enum level = MessageLevel::MultiMC);
+	void write(LogBlock lines);
 	void on_btnPaste_clicked();
 	void on_btnCopy_clicked();
 	void on_btnClear_clicked();
@@ -76,13 +74,15 @@ private slots:
 	void findNextActivated();
 	void findPreviousActivated();
 
+private:
+	void findText(bool backwards);
+
 private:
 	Ui::LogPage *ui;
 	MinecraftProcess *m_process;
+	LogModel *m_model;
 	int m_last_scroll_value = 0;
 	bool m_scroll_active = true;
 	int m_saved_offset = 0;
 	bool m_write_active = true;
-
-	QTextCharFormat * defaultFormat;
 };
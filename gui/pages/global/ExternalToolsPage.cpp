@@ -61,6 +61,7 @@ void ExternalToolsPage::loadSettings()
 void ExternalToolsPage::applySettings()
 {
 	auto s = MMC->settings();
+	s->beginBatch();
 	s->set("JProfilerPath", ui->jprofilerPathEdit->text());
 	s->set("JVisualVMPath", ui->jvisualvmPathEdit->text());
 	s->set("MCEditPath", ui->mceditPathEdit->text());
@@ -77,6 +78,7 @@ void ExternalToolsPage::applySettings()
 		}
 	}
 	s->set("JsonEditor", jsonEditor);
+	s->commit();
 }
 
 void ExternalToolsPage::on_jprofilerPathBtn_clicked()
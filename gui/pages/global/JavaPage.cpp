@@ -61,6 +61,7 @@ bool JavaPage::apply()
 void JavaPage::applySettings()
 {
 	auto s = MMC->settings();
+	s->beginBatch();
 	// Memory
 	s->set("MinMemAlloc", ui->minMemSpinBox->value());
 	s->set("MaxMemAlloc", ui->maxMemSpinBox->value());
@@ -74,6 +75,7 @@ void JavaPage::applySettings()
 	// Custom Commands
 	s->set("PreLaunchCommand", ui->preLaunchCmdTextBox->text());
 	s->set("PostExitCommand", ui->postExitCmdTextBox->text());
+	s->commit();
 }
 void JavaPage::loadSettings()
 {
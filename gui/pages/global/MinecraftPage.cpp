@@ -74,6 +74,7 @@ void MinecraftPage::on_maximizedCheckBox_clicked(bool checked)
 void MinecraftPage::applySettings()
 {
 	auto s = MMC->settings();
+	s->beginBatch();
 	// Minecraft version updates
 	s->set("AutoUpdateMinecraftVersions", ui->autoupdateMinecraft->isChecked());
 
@@ -81,6 +82,7 @@ void MinecraftPage::applySettings()
 	s->set("LaunchMaximized", ui->maximizedCheckBox->isChecked());
 	s->set("MinecraftWinWidth", ui->windowWidthSpinBox->value());
 	s->set("MinecraftWinHeight", ui->windowHeightSpinBox->value());
+	s->commit();
 }
 
 void MinecraftPage::loadSettings()
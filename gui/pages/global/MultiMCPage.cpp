@@ -260,6 +260,7 @@ void MultiMCPage::refreshUpdateChannelDesc()
 void MultiMCPage::applySettings()
 {
 	auto s = MMC->settings();
+	s->beginBatch();
 	// Language
 	s->set("Language",
 		   ui->languageBox->itemData(ui->languageBox->currentIndex()).toLocale().bcp47Name());
@@ -308,6 +309,7 @@ void MultiMCPage::applySettings()
 	// Console settings
 	s->set("ShowConsole", ui->showConsoleCheck->isChecked());
 	s->set("AutoCloseConsole", ui->autoCloseConsoleCheck->isChecked());
+	s->set("ConsoleMaxLines", ui->consoleMaxLinesBox->value());
 	QString consoleFontFamily = ui->consoleFont->currentFont().family();
 	s->set("ConsoleFont", consoleFontFamily);
 	s->set("ConsoleFontSize", ui->fontSizeBox->value());
@@ -335,6 +337,7 @@ void MultiMCPage::applySettings()
 		s->set("InstSortMode", "Name");
 		break;
 	}
+	s->commit();
 }
 void MultiMCPage::loadSettings()
 {
@@ -388,6 +391,7 @@ void MultiMCPage::loadSettings()
 	// Console settings
 	ui->showConsoleCheck->setChecked(s->get("ShowConsole").toBool());
 	ui->autoCloseConsoleCheck->setChecked(s->get("AutoCloseConsole").toBool());
+	ui->consoleMaxLinesBox->setValue(s->get("ConsoleMaxLines").toInt());
 	QString fontFamily = MMC->settings()->get("ConsoleFont").toString();
 	QFont consoleFont(fontFamily);
 	ui->consoleFont->setCurrentFont(consoleFont);
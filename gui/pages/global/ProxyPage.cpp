@@ -56,6 +56,7 @@ void ProxyPage::proxyChanged(int)
 void ProxyPage::applySettings()
 {
 	auto s = MMC->settings();
+	s->beginBatch();
 
 	// Proxy
 	QString proxyType = "None";
@@ -73,6 +74,7 @@ void ProxyPage::applySettings()
 	s->set("ProxyPort", ui->proxyPortEdit->value());
 	s->set("ProxyUser", ui->proxyUserEdit->text());
 	s->set("ProxyPass", ui->proxyPassEdit->text());
+	s->commit();
 }
 void ProxyPage::loadSettings()
 {
@@ -26,6 +26,10 @@
 #include "QsLog.h"
 #include "QsLogDest.h"
 #include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QAtomicPointer>
+#include <QElapsedTimer>
 #include <QList>
 #include <QDateTime>
 #include <QtGlobal>
@@ -33,6 +37,9 @@
 #include <cstdlib>
 #include <stdexcept>
 
+// how long the writer thread lets messages pile up before writing them out
+#define ASYNC_FLUSH_INTERVAL_MS 100
+
 namespace QsLogging
 {
 typedef QList<Destination *> DestinationList;
@@ -49,31 +56,181 @@ static const char *LevelToText(Level theLevel)
 	return LevelStrings[theLevel];
 }
 
+static QString FormatMessage(Level level, qint64 msecstotal, const QString &message)
+{
+	const char *const levelName = LevelToText(level);
+	qint64 seconds = msecstotal / 1000;
+	qint64 msecs = msecstotal % 1000;
+	char buf[1024];
+
+	::snprintf(buf, 1024, "%5lld.%03lld", seconds, msecs);
+
+	return QString("%1\t%2\t%3").arg(buf).arg(levelName, 5).arg(message);
+}
+
+//! a message waiting for the writer thread
+struct LogEntry
+{
+	Level level;
+	qint64 msecs;
+	QString message;
+	QAtomicPointer<LogEntry> next;
+};
+
+//! Multiple producer, single consumer queue. Pushing never locks.
+//! This is Dmitry Vyukov's intrusive MPSC queue.
+class LogQueue
+{
+public:
+	LogQueue() : head(&stub), tail(&stub)
+	{
+		stub.next.store(nullptr);
+	}
+	~LogQueue()
+	{
+		while (LogEntry *entry = pop())
+			delete entry;
+	}
+
+	//! any thread
+	void push(LogEntry *entry)
+	{
+		entry->next.store(nullptr);
+		LogEntry *prev = head.fetchAndStoreOrdered(entry);
+		prev->next.storeRelease(entry);
+	}
+
+	//! only the consumer. Returns null when empty, or when a push is only half done.
+	LogEntry *pop()
+	{
+		LogEntry *first = tail;
+		LogEntry *next = first->next.loadAcquire();
+		if (first == &stub)
+		{
+			if (!next)
+				return nullptr;
+			tail = next;
+			first = next;
+			next = next->next.loadAcquire();
+		}
+		if (next)
+		{
+			tail = next;
+			return first;
+		}
+		if (first != head.loadAcquire())
+			return nullptr;
+		// the last entry can only be taken out with the stub behind it
+		push(&stub);
+		next = first->next.loadAcquire();
+		if (next)
+		{
+			tail = next;
+			return first;
+		}
+		return nullptr;
+	}
+
+private:
+	QAtomicPointer<LogEntry> head;
+	LogEntry *tail;
+	LogEntry stub;
+};
+
+class LogWriterThread;
+
 class LoggerImpl
 {
 public:
 	LoggerImpl() : level(InfoLevel)
 	{
 	}
+
+	//! wake up the writer now instead of at the next interval. Safe without a writer.
+	void wake()
+	{
+		QMutexLocker lock(&wakeMutex);
+		wakeRequested = true;
+		wakeCondition.wakeOne();
+	}
+
 	QMutex logMutex;
 	Level level;
 	DestinationList destList;
 	QDateTime startTime;
+	QElapsedTimer sinceStart;
+	LogQueue queue;
+
+	//! producers only ever look at this, never at the writer thread
+	QAtomicInt async;
+	//! owned by setAsynchronous
+	LogWriterThread *writer = nullptr;
+
+	QMutex wakeMutex;
+	QWaitCondition wakeCondition;
+	bool wakeRequested = false;
+	bool stopRequested = false;
+};
+
+//! writes queued messages out in batches
+class LogWriterThread : public QThread
+{
+public:
+	explicit LogWriterThread(Logger &logger, LoggerImpl &d) : logger(logger), d(d)
+	{
+	}
+
+	//! write everything that is queued and stop
+	void stop()
+	{
+		{
+			QMutexLocker lock(&d.wakeMutex);
+			d.stopRequested = true;
+			d.wakeCondition.wakeOne();
+		}
+		wait();
+	}
+
+protected:
+	virtual void run()
+	{
+		QMutexLocker lock(&d.wakeMutex);
+		while (true)
+		{
+			const bool stopping = d.stopRequested;
+			lock.unlock();
+			logger.writeQueued();
+			lock.relock();
+			if (stopping)
+				break;
+			if (!d.wakeRequested && !d.stopRequested)
+				d.wakeCondition.wait(&d.wakeMutex, ASYNC_FLUSH_INTERVAL_MS);
+			d.wakeRequested = false;
+		}
+		d.stopRequested = false;
+	}
+
+private:
+	Logger &logger;
+	LoggerImpl &d;
 };
 
 Logger::Logger() : d(new LoggerImpl)
 {
 	d->startTime = QDateTime::currentDateTime();
+	d->sinceStart.start();
 }
 
 Logger::~Logger()
 {
+	setAsynchronous(false);
 	delete d;
 }
 
 void Logger::addDestination(Destination *destination)
 {
 	assert(destination);
+	QMutexLocker lock(&d->logMutex);
 	d->destList.push_back(destination);
 }
 
@@ -94,27 +251,55 @@ QDateTime Logger::timeOfStart() const
 
 qint64 Logger::timeSinceStart() const
 {
-	return d->startTime.msecsTo(QDateTime::currentDateTime());
+	return d->sinceStart.elapsed();
 }
 
+void Logger::setAsynchronous(bool async)
+{
+	if (async == (d->writer != nullptr))
+		return;
+	if (async)
+	{
+		d->writer = new LogWriterThread(*this, *d);
+		d->writer->start();
+		d->async.storeRelease(1);
+	}
+	else
+	{
+		// messages logged from now on are written directly
+		d->async.storeRelease(0);
+		d->writer->stop();
+		delete d->writer;
+		d->writer = nullptr;
+		// anything queued while the writer was stopping
+		writeQueued();
+	}
+}
+
+bool Logger::isAsynchronous() const
+{
+	return d->async.loadAcquire() != 0;
+}
 
 //! creates the complete log message and passes it to the logger
 void Logger::Helper::writeToLog()
 {
-	const char *const levelName = LevelToText(level);
 	Logger &logger = Logger::instance();
-	qint64 msecstotal = logger.timeSinceStart();
-	qint64 seconds = msecstotal / 1000;
-	qint64 msecs = msecstotal % 1000;
-	QString foo;
-	char buf[1024];
-
-	::snprintf(buf, 1024, "%5lld.%03lld", seconds, msecs);
+	if (logger.isAsynchronous())
+	{
+		// formatting is left to the writer thread
+		logger.enqueue(level, buffer);
+		// the writer may have stopped before the message got in. Then nobody else writes it.
+		if (!logger.isAsynchronous())
+			logger.writeQueued();
+		return;
+	}
 
-	const QString completeMessage(QString("%1\t%2\t%3").arg(buf).arg(levelName, 5).arg(buffer));
+	const QString completeMessage(FormatMessage(level, logger.timeSinceStart(), buffer));
 
 	QMutexLocker lock(&logger.d->logMutex);
 	logger.write(completeMessage);
+	logger.flush();
 }
 
 Logger::Helper::Helper(Level logLevel) : level(logLevel), qtDebug(&buffer)
@@ -136,6 +321,34 @@ Logger::Helper::~Helper()
 	}
 }
 
+void Logger::enqueue(Level level, QString &message)
+{
+	LogEntry *entry = new LogEntry;
+	entry->level = level;
+	entry->msecs = timeSinceStart();
+	entry->message.swap(message);
+	d->queue.push(entry);
+	// errors are written out right away, in case they are followed by a crash
+	if (level >= ErrorLevel)
+		d->wake();
+}
+
+//! formats and writes out everything in the queue, then flushes once.
+//! Any thread may call this, the log mutex keeps it to one consumer at a time.
+void Logger::writeQueued()
+{
+	QMutexLocker lock(&d->logMutex);
+	bool written = false;
+	while (LogEntry *entry = d->queue.pop())
+	{
+		write(FormatMessage(entry->level, entry->msecs, entry->message));
+		delete entry;
+		written = true;
+	}
+	if (written)
+		flush();
+}
+
 //! sends the message to all the destinations
 void Logger::write(const QString &message)
 {
@@ -151,8 +364,18 @@ void Logger::write(const QString &message)
 	}
 }
 
+void Logger::flush()
+{
+	for (auto destination : d->destList)
+	{
+		if (destination)
+			destination->flush();
+	}
+}
+
 void Logger::removeDestination(Destination* destination)
 {
+	QMutexLocker lock(&d->logMutex);
 	d->destList.removeAll(destination);
 }
 
@@ -65,6 +65,10 @@ public:
 	qint64 timeSinceStart() const;
 	//! time when the logger was initialized
 	QDateTime timeOfStart() const;
+	//! In asynchronous mode, messages are queued without locking and formatted and written
+	//! in batches by a writer thread. Switching it off writes out everything queued so far.
+	void setAsynchronous(bool async);
+	bool isAsynchronous() const;
 
 
 	//! The helper forwards the streaming to QDebug and builds the final
@@ -94,7 +98,11 @@ private:
 	~Logger();
 
 	void write(const QString &message);
+	void flush();
+	void enqueue(Level level, QString &message);
+	void writeQueued();
 
+	friend class LogWriterThread;
 	LoggerImpl *d;
 };
 
@@ -39,12 +39,17 @@ Destination::~Destination()
 	QsDebugOutput::output("Removed logger destination.");
 }
 
+void Destination::flush()
+{
+}
+
 //! file message sink
 class FileDestination : public Destination
 {
 public:
 	FileDestination(const QString &filePath);
 	virtual void write(const QString &message);
+	virtual void flush();
 
 private:
 	QFile mFile;
@@ -61,7 +66,11 @@ FileDestination::FileDestination(const QString &filePath)
 
 void FileDestination::write(const QString &message)
 {
-	mOutputStream << message << endl;
+	mOutputStream << message << '\n';
+}
+
+void FileDestination::flush()
+{
 	mOutputStream.flush();
 }
 
@@ -37,6 +37,8 @@ class Destination
 public:
 	virtual ~Destination();
 	virtual void write(const QString &message) = 0;
+	//! Called after a batch of messages has been written
+	virtual void flush();
 };
 typedef std::shared_ptr<Destination> DestinationPtr;
 
@@ -86,6 +86,8 @@ void BaseInstance::iconUpdated(QString key)
 
 void BaseInstance::nuke()
 {
+	// write pending changes now, not into the deleted folder later
+	m_settings->flush();
 	QDir(instanceRoot()).removeRecursively();
 	emit nuked(this);
 }
@@ -133,7 +135,10 @@ InstanceList *BaseInstance::instList() const
 
 InstancePtr BaseInstance::getSharedPtr()
 {
-	return instList()->getInstanceById(id());
+	auto list = instList();
+	if (!list)
+		return InstancePtr();
+	return list->getInstanceById(id());
 }
 
 std::shared_ptr<BaseVersionList> BaseInstance::versionList() const
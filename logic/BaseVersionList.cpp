@@ -22,12 +22,20 @@ BaseVersionList::BaseVersionList(QObject *parent) : QAbstractListModel(parent)
 
 BaseVersionPtr BaseVersionList::findVersion(const QString &descriptor)
 {
+	return m_lookup.value(descriptor);
+}
+
+void BaseVersionList::rebuildLookup()
+{
+	m_lookup.clear();
+	m_lookup.reserve(count());
 	for (int i = 0; i < count(); i++)
 	{
-		if (at(i)->descriptor() == descriptor)
-			return at(i);
+		auto version = at(i);
+		auto descriptor = version->descriptor();
+		if (!m_lookup.contains(descriptor))
+			m_lookup.insert(descriptor, version);
 	}
-	return BaseVersionPtr();
 }
 
 BaseVersionPtr BaseVersionList::getLatestStable() const
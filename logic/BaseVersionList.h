@@ -18,6 +18,10 @@
 #include <QObject>
 #include <QVariant>
 #include <QAbstractListModel>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
 
 #include "logic/BaseVersion.h"
 
@@ -102,6 +106,39 @@ public:
 	 */
 	virtual void sort() = 0;
 
+protected:
+	/*!
+	 * \brief Rebuilds m_lookup from the versions in the list.
+	 * Subclasses call this whenever their list was replaced or reordered.
+	 */
+	void rebuildLookup();
+
+	/*!
+	 * \brief Sorts the versions by a key, largest first.
+	 * The key is computed once per version instead of twice per comparison.
+	 */
+	template <typename KeyFunc>
+	static void sortDescending(QList<BaseVersionPtr> &versions, KeyFunc key)
+	{
+		typedef decltype(key(BaseVersionPtr())) Key;
+		typedef QPair<Key, BaseVersionPtr> Keyed;
+		QVector<Keyed> keyed;
+		keyed.reserve(versions.size());
+		for (auto &version : versions)
+		{
+			keyed.append(qMakePair(key(version), version));
+		}
+		std::stable_sort(keyed.begin(), keyed.end(), [](const Keyed &left, const Keyed &right)
+		{ return left.first > right.first; });
+		for (int i = 0; i < keyed.size(); i++)
+		{
+			versions[i] = keyed[i].second;
+		}
+	}
+
+	//! descriptor -> version. if descriptors repeat, the first version in the list wins.
+	QHash<QString, BaseVersionPtr> m_lookup;
+
 protected
 slots:
 	/*!
@@ -43,8 +43,16 @@ InstanceFactory::InstanceFactory() : QObject(NULL)
 InstanceFactory::InstLoadError InstanceFactory::loadInstance(InstancePtr &inst,
 															 const QString &instDir)
 {
-	auto m_settings = new INISettingsObject(PathCombine(instDir, "instance.cfg"));
+	INIFile config;
+	config.loadFile(PathCombine(instDir, "instance.cfg"));
+	return loadInstance(inst, instDir, config);
+}
 
+InstanceFactory::InstLoadError InstanceFactory::loadInstance(InstancePtr &inst,
+															 const QString &instDir,
+															 const INIFile &config)
+{
+	auto m_settings = new INISettingsObject(PathCombine(instDir, "instance.cfg"), config);
 	m_settings->registerSetting("InstanceType", "Legacy");
 
 	QString inst_type = m_settings->get("InstanceType").toString();
@@ -68,6 +76,7 @@ InstanceFactory::InstLoadError InstanceFactory::loadInstance(InstancePtr &inst,
 	}
 	else
 	{
+		delete m_settings;
 		return InstanceFactory::UnknownLoadError;
 	}
 	inst->init();
@@ -135,6 +144,8 @@ InstanceFactory::InstCreateError InstanceFactory::copyInstance(InstancePtr &newI
 	QDir rootDir(instDir);
 
 	QLOG_DEBUG() << instDir.toUtf8();
+	// the copy has to include settings that are still waiting to be written
+	oldInstance->settings().flush();
 	if (!copyPath(oldInstance->instanceRoot(), instDir))
 	{
 		rootDir.removeRecursively();
@@ -149,6 +160,7 @@ InstanceFactory::InstCreateError InstanceFactory::copyInstance(InstancePtr &newI
 		settings_obj.set("InstanceType", "OneSix");
 	if (inst_type == "LegacyFTB")
 		settings_obj.set("InstanceType", "Legacy");
+	settings_obj.flush();
 
 	oldInstance->copy(instDir);
 
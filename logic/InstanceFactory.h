@@ -24,6 +24,7 @@
 
 struct BaseVersion;
 class BaseInstance;
+class INIFile;
 
 /*!
  * The \b InstanceFactory\b is a singleton that manages loading and creating instances.
@@ -99,6 +100,16 @@ public:
 	 */
 	InstLoadError loadInstance(InstancePtr &inst, const QString &instDir);
 
+	/*!
+	 * \brief Loads an instance from the already read contents of its INI file.
+	 * Only reading the file is thread safe. This has to run on the GUI thread.
+	 * \param inst Pointer to store the loaded instance in.
+	 * \param instDir The instance's directory.
+	 * \param config The contents of the instance's INI file.
+	 * \return An InstLoadError error code.
+	 */
+	InstLoadError loadInstance(InstancePtr &inst, const QString &instDir, const INIFile &config);
+
 private:
 	InstanceFactory();
 
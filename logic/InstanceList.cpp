@@ -17,6 +17,9 @@
 #include <QSet>
 #include <QFile>
 #include <QDirIterator>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSaveFile>
 #include <QThread>
 #include <QTextStream>
 #include <QJsonDocument>
@@ -24,6 +27,7 @@
 #include <QJsonArray>
 #include <QXmlStreamReader>
 #include <QRegularExpression>
+#include <QtConcurrentMap>
 #include <pathutils.h>
 
 #include "MultiMC.h"
@@ -37,10 +41,21 @@
 
 const static int GROUP_FILE_FORMAT_VERSION = 1;
 
+const static quint32 SNAPSHOT_MAGIC = 0x4D4D4349; // "MMCI"
+const static quint32 SNAPSHOT_FORMAT_VERSION = 2;
+
+// how long loaded instances are collected before they are inserted into the model together
+const static int PUBLISH_INTERVAL_MS = 100;
+
 InstanceList::InstanceList(const QString &instDir, QObject *parent)
 	: QAbstractListModel(parent), m_instDir(instDir)
 {
 	connect(MMC, &MultiMC::aboutToQuit, this, &InstanceList::saveGroupList);
+	connect(&m_loadWatcher, SIGNAL(resultsReadyAt(int, int)), SLOT(instancesLoaded(int, int)));
+	connect(&m_loadWatcher, SIGNAL(finished()), SLOT(instanceLoadFinished()));
+	m_publishTimer.setSingleShot(true);
+	m_publishTimer.setInterval(PUBLISH_INTERVAL_MS);
+	connect(&m_publishTimer, SIGNAL(timeout()), SLOT(publishLoadedInstances()));
 
 	if (!QDir::current().exists(m_instDir))
 	{
@@ -50,6 +65,8 @@ InstanceList::InstanceList(const QString &instDir, QObject *parent)
 
 InstanceList::~InstanceList()
 {
+	m_loadWatcher.cancel();
+	m_loadWatcher.waitForFinished();
 }
 
 int InstanceList::rowCount(const QModelIndex &parent) const
@@ -63,16 +80,18 @@ QModelIndex InstanceList::index(int row, int column, const QModelIndex &parent)
 	Q_UNUSED(parent);
 	if (row < 0 || row >= m_instances.size())
 		return QModelIndex();
-	return createIndex(row, column, (void *)m_instances.at(row).get());
+	return createIndex(row, column);
 }
 
 QVariant InstanceList::data(const QModelIndex &index, int role) const
 {
-	if (!index.isValid())
+	if (!index.isValid() || index.row() >= m_instances.size())
 	{
 		return QVariant();
 	}
-	BaseInstance *pdata = static_cast<BaseInstance *>(index.internalPointer());
+	// rows that are only known from the snapshot don't have an instance yet
+	BaseInstance *pdata = m_instances.at(index.row()).get();
+	const InstanceSnapshot &record = m_snapshots.at(index.row());
 	switch (role)
 	{
 	case InstancePointerRole:
@@ -81,26 +100,30 @@ QVariant InstanceList::data(const QModelIndex &index, int role) const
 		return v;
 	}
 	case InstanceIDRole:
-    {
-        return pdata->id();
-    }
+	{
+		return pdata ? pdata->id() : record.id;
+	}
 	case Qt::DisplayRole:
 	{
-		return pdata->name();
+		return pdata ? pdata->name() : record.name;
 	}
 	case Qt::ToolTipRole:
 	{
-		return pdata->instanceRoot();
+		return pdata ? pdata->instanceRoot() : record.dir;
 	}
 	case Qt::DecorationRole:
 	{
-		QString key = pdata->iconKey();
+		QString key = pdata ? pdata->iconKey() : record.iconKey;
 		return MMC->icons()->getIcon(key);
 	}
 	// for now.
 	case GroupViewRoles::GroupRole:
 	{
-		return pdata->group();
+		return pdata ? pdata->group() : record.group;
+	}
+	case LastLaunchRole:
+	{
+		return pdata ? pdata->lastLaunch() : record.lastLaunch;
 	}
 	default:
 		break;
@@ -143,10 +166,11 @@ void InstanceList::saveGroupList()
 	}
 	QTextStream out(&groupFile);
 	QMap<QString, QSet<QString>> groupMap;
-	for (auto instance : m_instances)
+	for (int i = 0; i < m_instances.size(); i++)
 	{
-		QString id = instance->id();
-		QString group = instance->group();
+		auto record = m_instances[i] ? snapshotOf(m_instances[i], -1) : m_snapshots[i];
+		QString id = record.id;
+		QString group = record.group;
 		if (group.isEmpty())
 			continue;
 
@@ -165,6 +189,22 @@ void InstanceList::saveGroupList()
 			set.insert(id);
 		}
 	}
+	// while loading, the instances that aren't in the list yet keep their groups
+	if (m_loading)
+	{
+		QSet<QString> loadedIds;
+		for (int i = 0; i < m_instances.size(); i++)
+		{
+			loadedIds.insert(m_instances[i] ? m_instances[i]->id() : m_snapshots[i].id);
+		}
+		for (auto iter = m_loadGroupMap.begin(); iter != m_loadGroupMap.end(); iter++)
+		{
+			if (!loadedIds.contains(iter.key()))
+			{
+				groupMap[iter.value()].insert(iter.key());
+			}
+		}
+	}
 	QJsonObject toplevel;
 	toplevel.insert("formatVersion", QJsonValue(QString("1")));
 	QJsonObject groupsArr;
@@ -186,6 +226,9 @@ void InstanceList::saveGroupList()
 	QJsonDocument doc(toplevel);
 	groupFile.write(doc.toJson());
 	groupFile.close();
+
+	// the snapshot remembers which group file it matches, keep them in step
+	writeSnapshot();
 }
 
 void InstanceList::loadGroupList(QMap<QString, QString> &groupMap)
@@ -446,49 +489,284 @@ void InstanceList::loadFTBInstances(QMap<QString, QString> &groupMap,
 	}
 }
 
+QString InstanceList::snapshotPath() const
+{
+	return PathCombine(m_instDir, "instances.snapshot");
+}
+
+qint64 InstanceList::groupFileTimestamp() const
+{
+	QFileInfo groupFile(PathCombine(m_instDir, "instgroups.json"));
+	if (!groupFile.exists())
+		return -1;
+	return groupFile.lastModified().toMSecsSinceEpoch();
+}
+
+InstanceList::InstanceSnapshot InstanceList::snapshotOf(InstancePtr inst,
+														qint64 configTimestamp) const
+{
+	InstanceSnapshot record;
+	record.dir = inst->instanceRoot();
+	record.id = inst->id();
+	record.name = inst->name();
+	record.iconKey = inst->iconKey();
+	record.group = inst->group();
+	record.type = inst->instanceType();
+	record.intendedVersion = inst->intendedVersionId();
+	record.lastLaunch = inst->lastLaunch();
+	record.configTimestamp = configTimestamp;
+	return record;
+}
+
+bool InstanceList::readSnapshot(QList<InstanceSnapshot> &records, qint64 &groupsTimestamp)
+{
+	QFile file(snapshotPath());
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_1);
+	quint32 magic, version;
+	qint32 count;
+	in >> magic >> version;
+	if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_FORMAT_VERSION)
+	{
+		QLOG_WARN() << "Ignoring instance list snapshot with unknown format.";
+		return false;
+	}
+	in >> groupsTimestamp >> count;
+	for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+	{
+		InstanceSnapshot record;
+		in >> record.dir >> record.id >> record.name >> record.iconKey >> record.group >>
+			record.type >> record.intendedVersion >> record.lastLaunch >> record.configTimestamp;
+		records.append(record);
+	}
+	if (in.status() != QDataStream::Ok)
+	{
+		QLOG_WARN() << "Ignoring truncated instance list snapshot.";
+		records.clear();
+		return false;
+	}
+	return true;
+}
+
+void InstanceList::writeSnapshot()
+{
+	QList<InstanceSnapshot> records;
+	for (int i = 0; i < m_instances.size(); i++)
+	{
+		// instances that weren't found in the instance folder (FTB, new ones) aren't included
+		qint64 configTimestamp = m_snapshots[i].configTimestamp;
+		if (configTimestamp < 0)
+			continue;
+		records.append(m_instances[i] ? snapshotOf(m_instances[i], configTimestamp)
+									  : m_snapshots[i]);
+	}
+
+	QSaveFile file(snapshotPath());
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		QLOG_ERROR() << "Failed to save instance list snapshot:" << file.errorString();
+		return;
+	}
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_1);
+	out << SNAPSHOT_MAGIC << SNAPSHOT_FORMAT_VERSION << groupFileTimestamp()
+		<< qint32(records.size());
+	for (auto &record : records)
+	{
+		out << record.dir << record.id << record.name << record.iconKey << record.group
+			<< record.type << record.intendedVersion << record.lastLaunch
+			<< record.configTimestamp;
+	}
+	if (out.status() != QDataStream::Ok || !file.commit())
+	{
+		QLOG_ERROR() << "Failed to save instance list snapshot:" << file.errorString();
+	}
+}
+
 InstanceList::InstListError InstanceList::loadList()
 {
-	// load the instance groups
-	QMap<QString, QString> groupMap;
-	loadGroupList(groupMap);
+	// instance.cfg is about to be read again, so the changes still waiting must be in it
+	for (auto &instance : m_instances)
+	{
+		if (instance)
+			instance->settings().flush();
+	}
 
-	QList<InstancePtr> tempList;
+	// drop whatever a previous load still had in flight
+	m_loadWatcher.cancel();
+	m_publishTimer.stop();
+	m_loadPending.clear();
+	m_loadSeen.clear();
+
+	QList<InstanceSnapshot> records;
+	qint64 groupsTimestamp = -1;
+	bool haveSnapshot = readSnapshot(records, groupsTimestamp);
+
+	// the groups are only read again if the group file changed since the snapshot
+	m_loadGroupMap.clear();
+	if (!haveSnapshot || groupsTimestamp != groupFileTimestamp())
+	{
+		loadGroupList(m_loadGroupMap);
+		for (auto &record : records)
+		{
+			record.group = m_loadGroupMap.value(record.id);
+		}
+	}
+	else
+	{
+		for (auto &record : records)
+		{
+			if (record.group.isEmpty())
+				continue;
+			m_loadGroupMap[record.id] = record.group;
+			m_groups.insert(record.group);
+		}
+	}
+
+	QMap<QString, qint64> knownTimestamps;
+	beginResetModel();
+	m_instances.clear();
+	m_snapshots.clear();
+	invalidateRows();
+	for (auto &record : records)
+	{
+		m_instances.append(InstancePtr());
+		m_snapshots.append(record);
+		knownTimestamps[record.dir] = record.configTimestamp;
+	}
+	endResetModel();
+	QLOG_INFO() << "Showing" << records.size() << "instances from the snapshot";
+
+	QStringList dirs;
 	{
 		QDirIterator iter(m_instDir, QDir::Dirs | QDir::NoDot | QDir::NoDotDot | QDir::Readable,
 						  QDirIterator::FollowSymlinks);
 		while (iter.hasNext())
 		{
-			QString subDir = iter.next();
-			if (!QFileInfo(PathCombine(subDir, "instance.cfg")).exists())
-				continue;
-			QLOG_INFO() << "Loading MultiMC instance from " << subDir;
-			InstancePtr instPtr;
-			auto error = InstanceFactory::get().loadInstance(instPtr, subDir);
-			if(!continueProcessInstance(instPtr, error, subDir, groupMap))
-				continue;
-			tempList.append(instPtr);
+			dirs.append(iter.next());
 		}
 	}
 
-	if (MMC->settings()->get("TrackFTBInstances").toBool())
+	// Reading the instance configs happens on the thread pool. The instances themselves are made
+	// on this thread, because they use the icon and version lists.
+	std::function<LoadedInstance(const QString &)> loader =
+		[knownTimestamps](const QString &subDir)
 	{
-		loadFTBInstances(groupMap, tempList);
+		LoadedInstance result;
+		result.dir = subDir;
+		QFileInfo config(PathCombine(subDir, "instance.cfg"));
+		if (!config.exists())
+			return result;
+		result.isInstance = true;
+		result.configTimestamp = config.lastModified().toMSecsSinceEpoch();
+		if (knownTimestamps.value(subDir, -1) == result.configTimestamp)
+		{
+			result.changed = false;
+			return result;
+		}
+		result.config.loadFile(config.absoluteFilePath());
+		return result;
+	};
+	m_loading = true;
+	m_loadWatcher.setFuture(QtConcurrent::mapped(dirs, loader));
+	return NoError;
+}
+
+void InstanceList::instancesLoaded(int begin, int end)
+{
+	auto future = m_loadWatcher.future();
+	for (int i = begin; i < end; i++)
+	{
+		auto result = future.resultAt(i);
+		if (!result.isInstance)
+			continue;
+		if (!result.changed)
+		{
+			m_loadSeen.insert(result.dir);
+			continue;
+		}
+		// keep an instance that was already loaded on demand, it may be in use
+		int row = getRowByDir(result.dir);
+		if (row != -1 && m_instances[row])
+		{
+			m_loadSeen.insert(result.dir);
+			continue;
+		}
+		QLOG_INFO() << "Loading MultiMC instance from " << result.dir;
+		result.error =
+			InstanceFactory::get().loadInstance(result.instance, result.dir, result.config);
+		if (!continueProcessInstance(result.instance, result.error, result.dir, m_loadGroupMap))
+			continue;
+		m_loadSeen.insert(result.dir);
+		if (row == -1)
+		{
+			m_loadPending.append(result);
+			continue;
+		}
+		m_instances[row] = result.instance;
+		m_snapshots[row].configTimestamp = result.configTimestamp;
+		connectInstance(result.instance);
+		emit dataChanged(index(row), index(row));
 	}
-	beginResetModel();
-	m_instances.clear();
-	for(auto inst: tempList)
+	if (!m_loadPending.isEmpty() && !m_publishTimer.isActive())
 	{
-		inst->setParent(this);
-		connect(inst.get(), SIGNAL(propertiesChanged(BaseInstance *)), this,
-				SLOT(propertiesChanged(BaseInstance *)));
-		connect(inst.get(), SIGNAL(groupChanged()), this, SLOT(groupChanged()));
-		connect(inst.get(), SIGNAL(nuked(BaseInstance *)), this,
-				SLOT(instanceNuked(BaseInstance *)));
-		m_instances.append(inst);
+		m_publishTimer.start();
 	}
-	endResetModel();
+}
+
+void InstanceList::publishLoadedInstances()
+{
+	m_publishTimer.stop();
+	if (m_loadPending.isEmpty())
+		return;
+	beginInsertRows(QModelIndex(), m_instances.size(),
+					m_instances.size() + m_loadPending.size() - 1);
+	for (auto &loaded : m_loadPending)
+	{
+		attachInstance(loaded.instance, loaded.configTimestamp);
+	}
+	m_loadPending.clear();
+	endInsertRows();
+}
+
+void InstanceList::instanceLoadFinished()
+{
+	if (m_loadWatcher.isCanceled())
+		return;
+
+	// drop the rows of instances that are gone since the snapshot was taken
+	for (int i = m_instances.size() - 1; i >= 0; i--)
+	{
+		if (m_snapshots[i].configTimestamp < 0 || m_loadSeen.contains(m_snapshots[i].dir))
+			continue;
+		beginRemoveRows(QModelIndex(), i, i);
+		m_instances.removeAt(i);
+		m_snapshots.removeAt(i);
+		invalidateRows();
+		endRemoveRows();
+	}
+
+	if (MMC->settings()->get("TrackFTBInstances").toBool())
+	{
+		QList<InstancePtr> ftbInstances;
+		loadFTBInstances(m_loadGroupMap, ftbInstances);
+		for (auto inst : ftbInstances)
+		{
+			LoadedInstance loaded;
+			loaded.instance = inst;
+			m_loadPending.append(loaded);
+		}
+	}
+	publishLoadedInstances();
+	m_loading = false;
+	m_loadSeen.clear();
+	m_loadGroupMap.clear();
+	writeSnapshot();
+	QLOG_INFO() << "Loaded" << m_instances.size() << "instances";
 	emit dataIsInvalid();
-	return NoError;
 }
 
 /// Clear all instances. Triggers notifications.
@@ -497,6 +775,8 @@ void InstanceList::clear()
 	beginResetModel();
 	saveGroupList();
 	m_instances.clear();
+	m_snapshots.clear();
+	invalidateRows();
 	endResetModel();
 	emit dataIsInvalid();
 }
@@ -511,44 +791,93 @@ void InstanceList::on_InstFolderChanged(const Setting &setting, QVariant value)
 int InstanceList::add(InstancePtr t)
 {
 	beginInsertRows(QModelIndex(), m_instances.size(), m_instances.size());
-	m_instances.append(t);
-	t->setParent(this);
-	connect(t.get(), SIGNAL(propertiesChanged(BaseInstance *)), this,
-			SLOT(propertiesChanged(BaseInstance *)));
-	connect(t.get(), SIGNAL(groupChanged()), this, SLOT(groupChanged()));
-	connect(t.get(), SIGNAL(nuked(BaseInstance *)), this, SLOT(instanceNuked(BaseInstance *)));
+	attachInstance(t);
 	endInsertRows();
 	return count() - 1;
 }
 
-InstancePtr InstanceList::getInstanceById(QString instId) const
+void InstanceList::attachInstance(InstancePtr inst, qint64 configTimestamp)
 {
-	if (m_instances.isEmpty())
+	m_instances.append(inst);
+	m_snapshots.append(snapshotOf(inst, configTimestamp));
+	if (!m_rowByDir.isEmpty() && !m_rowByDir.contains(m_snapshots.last().dir))
 	{
-		return InstancePtr();
+		m_rowByDir.insert(m_snapshots.last().dir, m_snapshots.size() - 1);
 	}
+	connectInstance(inst);
+}
 
-	QListIterator<InstancePtr> iter(m_instances);
+void InstanceList::connectInstance(InstancePtr inst)
+{
+	inst->setParent(this);
+	connect(inst.get(), SIGNAL(propertiesChanged(BaseInstance *)), this,
+			SLOT(propertiesChanged(BaseInstance *)));
+	connect(inst.get(), SIGNAL(groupChanged()), this, SLOT(groupChanged()));
+	connect(inst.get(), SIGNAL(nuked(BaseInstance *)), this, SLOT(instanceNuked(BaseInstance *)));
+}
+
+InstancePtr InstanceList::materializeInstance(int row)
+{
+	const InstanceSnapshot record = m_snapshots.at(row);
+	QLOG_INFO() << "Loading MultiMC instance from " << record.dir;
 	InstancePtr inst;
-	while (iter.hasNext())
+	auto error = InstanceFactory::get().loadInstance(inst, record.dir);
+	QMap<QString, QString> groupMap;
+	if (!record.group.isEmpty())
 	{
-		inst = iter.next();
-		if (inst->id() == instId)
-			break;
+		groupMap[record.id] = record.group;
 	}
-	if (inst->id() != instId)
+	if (!continueProcessInstance(inst, error, record.dir, groupMap))
 		return InstancePtr();
-	else
-		return iter.peekPrevious();
+	m_instances[row] = inst;
+	connectInstance(inst);
+	emit dataChanged(index(row), index(row));
+	return inst;
+}
+
+InstancePtr InstanceList::getInstanceById(QString instId)
+{
+	int row = getRowById(instId);
+	if (row == -1)
+		return InstancePtr();
+	return at(row);
 }
 
 QModelIndex InstanceList::getInstanceIndexById(const QString &id) const
 {
-	return index(getInstIndex(getInstanceById(id).get()));
+	return index(getRowById(id));
+}
+
+int InstanceList::getRowById(const QString &id) const
+{
+	for (int i = 0; i < m_instances.count(); i++)
+	{
+		auto inst = m_instances[i];
+		if ((inst ? inst->id() : m_snapshots[i].id) == id)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+int InstanceList::getRowByDir(const QString &dir) const
+{
+	if (m_rowByDir.isEmpty())
+	{
+		// backwards, so the first of two rows with the same dir wins
+		for (int i = m_snapshots.count() - 1; i >= 0; i--)
+		{
+			m_rowByDir.insert(m_snapshots[i].dir, i);
+		}
+	}
+	return m_rowByDir.value(dir, -1);
 }
 
 int InstanceList::getInstIndex(BaseInstance *inst) const
 {
+	if (!inst)
+		return -1;
 	for (int i = 0; i < m_instances.count(); i++)
 	{
 		if (inst == m_instances[i].get())
@@ -603,6 +932,8 @@ void InstanceList::instanceNuked(BaseInstance *inst)
 	{
 		beginRemoveRows(QModelIndex(), i, i);
 		m_instances.removeAt(i);
+		m_snapshots.removeAt(i);
+		invalidateRows();
 		endRemoveRows();
 	}
 }
@@ -623,15 +954,16 @@ InstanceProxyModel::InstanceProxyModel(QObject *parent) : GroupedProxyModel(pare
 bool InstanceProxyModel::subSortLessThan(const QModelIndex &left,
 										 const QModelIndex &right) const
 {
-	BaseInstance *pdataLeft = static_cast<BaseInstance *>(left.internalPointer());
-	BaseInstance *pdataRight = static_cast<BaseInstance *>(right.internalPointer());
+	// go through the model, rows from the snapshot don't have an instance yet
 	QString sortMode = MMC->settings()->get("InstSortMode").toString();
 	if (sortMode == "LastLaunch")
 	{
-		return pdataLeft->lastLaunch() > pdataRight->lastLaunch();
+		return left.data(InstanceList::LastLaunchRole).toLongLong() >
+			   right.data(InstanceList::LastLaunchRole).toLongLong();
 	}
 	else
 	{
-		return QString::localeAwareCompare(pdataLeft->name(), pdataRight->name()) < 0;
+		return QString::localeAwareCompare(left.data(Qt::DisplayRole).toString(),
+										   right.data(Qt::DisplayRole).toString()) < 0;
 	}
 }
@@ -18,10 +18,13 @@
 #include <QObject>
 #include <QAbstractListModel>
 #include <QSet>
+#include <QTimer>
+#include <QFutureWatcher>
 #include <gui/groupview/GroupedProxyModel.h>
 #include <QIcon>
 
 #include "logic/BaseInstance.h"
+#include "logic/settings/INIFile.h"
 
 class BaseInstance;
 
@@ -55,9 +58,48 @@ private:
 	QSet<FTBRecord> discoverFTBInstances();
 	void loadFTBInstances(QMap<QString, QString> &groupMap, QList<InstancePtr> & tempList);
 
+	/// What the list remembers about an instance between runs, see loadList()
+	struct InstanceSnapshot
+	{
+		QString dir;
+		QString id;
+		QString name;
+		QString iconKey;
+		QString group;
+		/// the InstanceType setting
+		QString type;
+		QString intendedVersion;
+		qint64 lastLaunch = 0;
+		/// modification time of instance.cfg when the instance was loaded, -1 if unknown
+		qint64 configTimestamp = -1;
+	};
+
+	/// An instance folder, revalidated on the thread pool by loadList()
+	struct LoadedInstance
+	{
+		QString dir;
+		InstancePtr instance;
+		int error = 0;
+		bool isInstance = false;
+		/// false if instance.cfg didn't change since the snapshot. Nothing is loaded then.
+		bool changed = true;
+		qint64 configTimestamp = -1;
+		/// what instance.cfg contained, read on the loader thread
+		INIFile config;
+	};
+
+	QString snapshotPath() const;
+	qint64 groupFileTimestamp() const;
+	bool readSnapshot(QList<InstanceSnapshot> &records, qint64 &groupsTimestamp);
+	void writeSnapshot();
+	InstanceSnapshot snapshotOf(InstancePtr inst, qint64 configTimestamp) const;
+
 private
 slots:
 	void saveGroupList();
+	void instancesLoaded(int begin, int end);
+	void publishLoadedInstances();
+	void instanceLoadFinished();
 
 public:
 	explicit InstanceList(const QString &instDir, QObject *parent = 0);
@@ -71,8 +113,9 @@ public:
 
 	enum AdditionalRoles
 	{
-		InstancePointerRole = 0x34B1CB48, ///< Return pointer to real instance
-		InstanceIDRole = 0x34B1CB49 ///< Return id if the instance
+		InstancePointerRole = 0x34B1CB48, ///< Return pointer to real instance, null if not loaded yet
+		InstanceIDRole = 0x34B1CB49, ///< Return id if the instance
+		LastLaunchRole = 0x34B1CB4A ///< Return the last launch time of the instance
 	};
 	/*!
 	 * \brief Error codes returned by functions in the InstanceList class.
@@ -91,11 +134,13 @@ public:
 	}
 
 	/*!
-	 * \brief Get the instance at index
+	 * \brief Get the instance at index. Loads it if it is only known from the snapshot.
+	 * Null if that fails.
 	 */
-	InstancePtr at(int i) const
+	InstancePtr at(int i)
 	{
-		return m_instances.at(i);
+		auto inst = m_instances.at(i);
+		return inst ? inst : materializeInstance(i);
 	}
 	;
 
@@ -114,8 +159,8 @@ public:
 	/// Add an instance. Triggers notifications, returns the new index
 	int add(InstancePtr t);
 
-	/// Get an instance by ID
-	InstancePtr getInstanceById(QString id) const;
+	/// Get an instance by ID. Loads it if it is only known from the snapshot.
+	InstancePtr getInstanceById(QString id);
 
 	QModelIndex getInstanceIndexById(const QString &id) const;
 
@@ -130,9 +175,22 @@ slots:
 
 	/*!
 	 * \brief Loads the instance list. Triggers notifications.
+	 *
+	 * The list is first filled from the snapshot written by the last run, so it shows up
+	 * without touching the instance folders. Those rows are only loaded into real instances
+	 * when they are asked for. The instance folders are then revalidated concurrently on the
+	 * global thread pool: only instances with a changed instance.cfg are loaded, and they
+	 * replace or are inserted next to the snapshot rows. dataIsInvalid() is emitted once all
+	 * of them are checked.
 	 */
 	InstListError loadList();
 
+	/// true while loadList() is still loading instances in the background
+	bool isLoading() const
+	{
+		return m_loading;
+	}
+
 private
 slots:
 	void propertiesChanged(BaseInstance *inst);
@@ -141,14 +199,37 @@ slots:
 
 private:
 	int getInstIndex(BaseInstance *inst) const;
+	int getRowById(const QString &id) const;
+	int getRowByDir(const QString &dir) const;
+	void attachInstance(InstancePtr inst, qint64 configTimestamp = -1);
+	void connectInstance(InstancePtr inst);
+	InstancePtr materializeInstance(int row);
+	/// rows moved, the dir -> row index has to be rebuilt
+	void invalidateRows()
+	{
+		m_rowByDir.clear();
+	}
 
 	bool continueProcessInstance(InstancePtr instPtr, const int error, const QDir &dir,
 								 QMap<QString, QString> &groupMap);
 
 protected:
 	QString m_instDir;
+	/// one entry per row, null for rows that are only known from the snapshot
 	QList<InstancePtr> m_instances;
+	/// one entry per row, matching m_instances
+	QList<InstanceSnapshot> m_snapshots;
+	/// dir -> row, built on demand by getRowByDir. Empty when it has to be rebuilt
+	mutable QHash<QString, int> m_rowByDir;
 	QSet<QString> m_groups;
+
+	/// state of the running loadList()
+	QFutureWatcher<LoadedInstance> m_loadWatcher;
+	QList<LoadedInstance> m_loadPending;
+	QSet<QString> m_loadSeen;
+	QMap<QString, QString> m_loadGroupMap;
+	QTimer m_publishTimer;
+	bool m_loading = false;
 };
 
 class InstanceProxyModel : public GroupedProxyModel
@@ -1,146 +1,477 @@
 #include "JarUtils.h"
+#include "logic/storage/ObjectStore.h"
 #include <quazip.h>
 #include <quazipfile.h>
 #include <JlCompress.h>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSaveFile>
+#include <algorithm>
 #include <logger/QsLog.h>
 
 namespace JarUtils {
 
+namespace
+{
+/// copy the current entry of from into the output without recompressing it
+bool copyRawEntry(QuaZip *into, QuaZip &from)
+{
+	QuaZipFileInfo64 info;
+	if (!from.getCurrentFileInfo(&info))
+		return false;
+	int method = 0;
+	int level = 0;
+	QuaZipFile fileIn(&from);
+	if (!fileIn.open(QIODevice::ReadOnly, &method, &level, true))
+		return false;
+
+	QuaZipNewInfo infoOut(info.name);
+	infoOut.dateTime = info.dateTime;
+	infoOut.externalAttr = info.externalAttr;
+	infoOut.uncompressedSize = info.uncompressedSize;
+	QuaZipFile fileOut(into);
+	if (!fileOut.open(QIODevice::WriteOnly, infoOut, nullptr, info.crc, method, level, true))
+	{
+		fileIn.close();
+		return false;
+	}
+	char buffer[64 * 1024];
+	qint64 read;
+	bool ok = true;
+	while (ok && (read = fileIn.read(buffer, sizeof(buffer))) > 0)
+	{
+		ok = fileOut.write(buffer, read) == read;
+	}
+	ok = ok && read == 0;
+	fileOut.close();
+	fileIn.close();
+	return ok && fileOut.getZipError() == UNZ_OK;
+}
+}
+
 bool mergeZipFiles(QuaZip *into, QFileInfo from, QSet<QString> &contained,
 				   std::function<bool(QString)> filter)
 {
 	QuaZip modZip(from.filePath());
-	modZip.open(QuaZip::mdUnzip);
+	if (!modZip.open(QuaZip::mdUnzip))
+	{
+		QLOG_ERROR() << "Failed to open" << from.filePath();
+		return false;
+	}
 
-	QuaZipFile fileInsideMod(&modZip);
-	QuaZipFile zipOutFile(into);
+	int added = 0;
+	int filtered = 0;
+	int duplicates = 0;
 	for (bool more = modZip.goToFirstFile(); more; more = modZip.goToNextFile())
 	{
 		QString filename = modZip.getCurrentFileName();
 		if (!filter(filename))
 		{
-			QLOG_INFO() << "Skipping file " << filename << " from "
-						<< from.fileName() << " - filtered";
+			filtered++;
 			continue;
 		}
 		if (contained.contains(filename))
 		{
-			QLOG_INFO() << "Skipping already contained file " << filename << " from "
-						<< from.fileName();
+			duplicates++;
 			continue;
 		}
 		contained.insert(filename);
-		QLOG_INFO() << "Adding file " << filename << " from " << from.fileName();
 
-		if (!fileInsideMod.open(QIODevice::ReadOnly))
+		// the compressed data and CRC can be used as they are
+		if (!copyRawEntry(into, modZip))
 		{
-			QLOG_ERROR() << "Failed to open " << filename << " from " << from.fileName();
+			QLOG_ERROR() << "Failed to copy" << filename << "from" << from.fileName()
+						 << "into the jar";
 			return false;
 		}
+		added++;
+	}
+	QLOG_INFO() << "Added" << added << "files from" << from.fileName() << "-" << duplicates
+				<< "already contained," << filtered << "filtered";
+	return true;
+}
 
-		QuaZipNewInfo info_out(fileInsideMod.getActualFileName());
+namespace
+{
+/// one of the things a modded jar is built from
+struct JarInput
+{
+	QString path;
+	QString type;
+	QString hash;
+	/// size and modification time of a file input, -1 for folders
+	qint64 size = -1;
+	qint64 mtime = -1;
+	/// the entries it contributed to the jar
+	QStringList entries;
+};
 
-		if (!zipOutFile.open(QIODevice::WriteOnly, info_out))
+const int manifestFormatVersion = 2;
+
+qint64 modificationTime(const QFileInfo &info)
+{
+	return info.lastModified().toMSecsSinceEpoch();
+}
+
+/**
+ * Fill in the hash of a file input. Hashing the base jar and every jar mod on each launch
+ * adds up, so the hash of the previous build is used while size and modification time match.
+ */
+void hashInput(JarInput &input, const QList<JarInput> &previousInputs)
+{
+	QFileInfo info(input.path);
+	input.size = info.size();
+	input.mtime = modificationTime(info);
+	for (auto &previous : previousInputs)
+	{
+		if (previous.path == input.path && previous.type == input.type &&
+			previous.size == input.size && previous.mtime == input.mtime)
 		{
-			QLOG_ERROR() << "Failed to open " << filename << " in the jar";
-			fileInsideMod.close();
+			input.hash = previous.hash;
+			return;
+		}
+	}
+	input.hash = ObjectStore::hashFile(input.path);
+}
+
+/// hash of a folder mod: the file names, sizes and modification times
+QString hashFolder(const QString &path)
+{
+	QStringList files;
+	QDirIterator iter(path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+	while (iter.hasNext())
+	{
+		iter.next();
+		QFileInfo info = iter.fileInfo();
+		files.append(info.filePath() + '\n' + QString::number(info.size()) + '\n' +
+					 QString::number(info.lastModified().toMSecsSinceEpoch()));
+	}
+	files.sort();
+	QCryptographicHash sha1(QCryptographicHash::Sha1);
+	for (auto &file : files)
+	{
+		sha1.addData(file.toUtf8());
+	}
+	return sha1.result().toHex();
+}
+
+QString manifestPath(const QString &jarPath)
+{
+	return jarPath + ".manifest";
+}
+
+/**
+ * The inputs the jar was built from, if the jar is still what the manifest describes.
+ * stale is set when the jar only matches by content and the manifest should be rewritten.
+ */
+bool readManifest(const QString &jarPath, QList<JarInput> &inputs, bool &stale)
+{
+	stale = false;
+	QFile file(manifestPath(jarPath));
+	QFileInfo jarInfo(jarPath);
+	if (!jarInfo.isFile() || !file.open(QIODevice::ReadOnly))
+		return false;
+	QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+	if (root.value("formatVersion").toDouble() != manifestFormatVersion)
+		return false;
+	// somebody else touched the jar, it's no use.
+	if (root.value("jarSize").toDouble() != jarInfo.size())
+		return false;
+	// the jar may have been swapped for an identical object store link, compare contents then
+	if (root.value("jarModified").toDouble() != modificationTime(jarInfo))
+	{
+		if (root.value("jarHash").toString() != ObjectStore::hashFile(jarPath))
 			return false;
+		stale = true;
+	}
+	for (auto inputValue : root.value("inputs").toArray())
+	{
+		QJsonObject obj = inputValue.toObject();
+		JarInput input;
+		input.path = obj.value("path").toString();
+		input.type = obj.value("type").toString();
+		input.hash = obj.value("hash").toString();
+		input.size = obj.value("size").toDouble(-1);
+		input.mtime = obj.value("modified").toDouble(-1);
+		for (auto entry : obj.value("entries").toArray())
+		{
+			input.entries.append(entry.toString());
 		}
-		if (!JlCompress::copyData(fileInsideMod, zipOutFile))
+		inputs.append(input);
+	}
+	return true;
+}
+
+bool writeManifest(const QString &jarPath, const QList<JarInput> &inputs)
+{
+	QFileInfo jarInfo(jarPath);
+	QJsonArray inputArray;
+	for (auto &input : inputs)
+	{
+		QJsonObject obj;
+		obj.insert("path", input.path);
+		obj.insert("type", input.type);
+		obj.insert("hash", input.hash);
+		obj.insert("size", double(input.size));
+		obj.insert("modified", double(input.mtime));
+		obj.insert("entries", QJsonArray::fromStringList(input.entries));
+		inputArray.append(obj);
+	}
+	QJsonObject root;
+	root.insert("formatVersion", double(manifestFormatVersion));
+	root.insert("jarSize", double(jarInfo.size()));
+	root.insert("jarModified", double(modificationTime(jarInfo)));
+	root.insert("jarHash", ObjectStore::hashFile(jarPath));
+	root.insert("inputs", inputArray);
+
+	QSaveFile file(manifestPath(jarPath));
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	file.write(QJsonDocument(root).toJson());
+	return file.commit();
+}
+
+bool sameInput(const JarInput &a, const JarInput &b)
+{
+	return a.path == b.path && a.type == b.type && a.hash == b.hash;
+}
+
+/// copy the named entries of the previous jar that aren't in the new one yet
+bool reuseEntries(QuaZip *into, QuaZip &previous, const QStringList &entries,
+				  QSet<QString> &contained)
+{
+	QSet<QString> wanted = entries.toSet();
+	for (bool more = previous.goToFirstFile(); more; more = previous.goToNextFile())
+	{
+		QString filename = previous.getCurrentFileName();
+		if (!wanted.contains(filename) || contained.contains(filename))
+			continue;
+		if (!copyRawEntry(into, previous))
 		{
-			zipOutFile.close();
-			fileInsideMod.close();
-			QLOG_ERROR() << "Failed to copy data of " << filename << " into the jar";
+			QLOG_ERROR() << "Failed to reuse" << filename << "from the previous jar";
 			return false;
 		}
-		zipOutFile.close();
-		fileInsideMod.close();
+		contained.insert(filename);
 	}
 	return true;
 }
 
-bool createModdedJar(QString sourceJarPath, QString targetJarPath, const QList<Mod>& mods)
+/// compress the files of a folder mod that aren't in the jar yet, named relative to its parent
+bool addFolder(QuaZip *into, const QString &folder, QSet<QString> &contained)
 {
-	QuaZip zipOut(targetJarPath);
-	if (!zipOut.open(QuaZip::mdCreate))
+	QDir parent(folder);
+	parent.cdUp();
+	QDirIterator iter(folder, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+	while (iter.hasNext())
 	{
-		QFile::remove(targetJarPath);
-		QLOG_ERROR() << "Failed to open the minecraft.jar for modding";
-		return false;
+		QString path = iter.next();
+		QString filename = parent.relativeFilePath(path);
+		if (contained.contains(filename))
+			continue;
+		if (!JlCompress::compressFile(into, path, filename))
+			return false;
+		contained.insert(filename);
 	}
-	// Files already added to the jar.
-	// These files will be skipped.
-	QSet<QString> addedFiles;
+	return true;
+}
+}
+
+bool createModdedJar(QString sourceJarPath, QString targetJarPath, const QList<Mod>& mods,
+					 bool *rebuilt)
+{
+	if (rebuilt)
+		*rebuilt = false;
+	QList<JarInput> previousInputs;
+	bool staleManifest = false;
+	bool havePrevious = readManifest(targetJarPath, previousInputs, staleManifest);
 
-	// Modify the jar
+	// Everything the jar is made of, in order. Earlier inputs win.
+	QList<JarInput> inputs;
 	QListIterator<Mod> i(mods);
-    i.toBack();
-    while (i.hasPrevious())
+	i.toBack();
+	while (i.hasPrevious())
 	{
 		const Mod &mod = i.previous();
 		// do not merge disabled mods.
 		if (!mod.enabled())
 			continue;
+		JarInput input;
+		input.path = mod.filename().absoluteFilePath();
 		if (mod.type() == Mod::MOD_ZIPFILE)
 		{
-			if (!mergeZipFiles(&zipOut, mod.filename(), addedFiles, noFilter))
-			{
-				zipOut.close();
-				QFile::remove(targetJarPath);
-				QLOG_ERROR() << "Failed to add" << mod.filename().fileName() << "to the jar.";
-				return false;
-			}
+			input.type = "zip";
+			hashInput(input, previousInputs);
 		}
 		else if (mod.type() == Mod::MOD_SINGLEFILE)
 		{
-			auto filename = mod.filename();
-			if (!JlCompress::compressFile(&zipOut, filename.absoluteFilePath(),
-										  filename.fileName()))
+			input.type = "file";
+			hashInput(input, previousInputs);
+		}
+		else if (mod.type() == Mod::MOD_FOLDER)
+		{
+			input.type = "folder";
+			input.hash = hashFolder(input.path);
+		}
+		else
+		{
+			continue;
+		}
+		if (input.hash.isEmpty())
+		{
+			QLOG_ERROR() << "Failed to read" << input.path;
+			return false;
+		}
+		inputs.append(input);
+	}
+	JarInput base;
+	base.path = QFileInfo(sourceJarPath).absoluteFilePath();
+	base.type = "base";
+	hashInput(base, previousInputs);
+	if (base.hash.isEmpty())
+	{
+		QLOG_ERROR() << "Failed to read" << base.path;
+		return false;
+	}
+	inputs.append(base);
+
+	// Built from the same things before? Then there's nothing to do.
+	if (havePrevious && previousInputs.size() == inputs.size() &&
+		std::equal(inputs.begin(), inputs.end(), previousInputs.begin(), sameInput))
+	{
+		QLOG_INFO() << targetJarPath << "is up to date";
+		// remember the new times, so the next check doesn't have to hash anything
+		bool touched = staleManifest;
+		for (int j = 0; j < inputs.size(); j++)
+		{
+			touched |= inputs[j].size != previousInputs[j].size ||
+					   inputs[j].mtime != previousInputs[j].mtime;
+			inputs[j].entries = previousInputs[j].entries;
+		}
+		if (touched && !writeManifest(targetJarPath, inputs))
+		{
+			QLOG_WARN() << "Failed to update the manifest for" << targetJarPath;
+		}
+		return true;
+	}
+	QFile::remove(manifestPath(targetJarPath));
+
+	// The previous jar may be shared with other instances. Never change it in place.
+	QString partJarPath = targetJarPath + ".part";
+	QuaZip zipOut(partJarPath);
+	if (!zipOut.open(QuaZip::mdCreate))
+	{
+		QFile::remove(partJarPath);
+		QLOG_ERROR() << "Failed to open the minecraft.jar for modding";
+		return false;
+	}
+	QuaZip previousJar(targetJarPath);
+	if (havePrevious && !previousJar.open(QuaZip::mdUnzip))
+	{
+		havePrevious = false;
+	}
+	auto fail = [&](QString message)
+	{
+		zipOut.close();
+		if (havePrevious)
+			previousJar.close();
+		QFile::remove(partJarPath);
+		QLOG_ERROR() << message;
+		return false;
+	};
+
+	// Files already added to the jar.
+	// These files will be skipped.
+	QSet<QString> addedFiles;
+	int reused = 0;
+	for (auto &input : inputs)
+	{
+		QSet<QString> before = addedFiles;
+		const JarInput *previous = nullptr;
+		if (havePrevious)
+		{
+			for (auto &candidate : previousInputs)
 			{
-				zipOut.close();
-				QFile::remove(targetJarPath);
-				QLOG_ERROR() << "Failed to add" << mod.filename().fileName() << "to the jar.";
-				return false;
+				if (sameInput(candidate, input))
+				{
+					previous = &candidate;
+					break;
+				}
 			}
-			addedFiles.insert(filename.fileName());
-			QLOG_INFO() << "Adding file " << filename.fileName() << " from "
-						<< filename.absoluteFilePath();
 		}
-		else if (mod.type() == Mod::MOD_FOLDER)
+		// Unchanged since the last build - take its entries from the previous jar as they are.
+		if (previous)
+		{
+			if (!reuseEntries(&zipOut, previousJar, previous->entries, addedFiles))
+				return fail("Failed to add " + input.path + " to the jar.");
+			reused++;
+		}
+		// Anything that was covered by an input that's gone or changed now comes from this one.
+		// Its previous entries don't include those, so it always gets a look.
+		QFileInfo filename(input.path);
+		if (input.type == "zip")
+		{
+			if (!mergeZipFiles(&zipOut, filename, addedFiles, noFilter))
+				return fail("Failed to add " + filename.fileName() + " to the jar.");
+		}
+		else if (input.type == "file")
 		{
-			auto filename = mod.filename();
-			QString what_to_zip = filename.absoluteFilePath();
-			QDir dir(what_to_zip);
-			dir.cdUp();
-			QString parent_dir = dir.absolutePath();
-			if (!JlCompress::compressSubDir(&zipOut, what_to_zip, parent_dir, true, addedFiles))
+			if (!addedFiles.contains(filename.fileName()))
 			{
-				zipOut.close();
-				QFile::remove(targetJarPath);
-				QLOG_ERROR() << "Failed to add" << mod.filename().fileName() << "to the jar.";
-				return false;
+				if (!JlCompress::compressFile(&zipOut, filename.absoluteFilePath(),
+											  filename.fileName()))
+					return fail("Failed to add " + filename.fileName() + " to the jar.");
+				addedFiles.insert(filename.fileName());
+				QLOG_INFO() << "Adding file " << filename.fileName() << " from "
+							<< filename.absoluteFilePath();
 			}
+		}
+		else if (input.type == "folder")
+		{
+			if (!addFolder(&zipOut, filename.absoluteFilePath(), addedFiles))
+				return fail("Failed to add " + filename.fileName() + " to the jar.");
 			QLOG_INFO() << "Adding folder " << filename.fileName() << " from "
 						<< filename.absoluteFilePath();
 		}
+		else if (input.type == "base")
+		{
+			if (!mergeZipFiles(&zipOut, filename, addedFiles, metaInfFilter))
+				return fail("Failed to insert minecraft.jar contents.");
+		}
+		QSet<QString> contributed = addedFiles;
+		input.entries = contributed.subtract(before).toList();
 	}
-
-	if (!mergeZipFiles(&zipOut, QFileInfo(sourceJarPath), addedFiles, metaInfFilter))
+	if (havePrevious)
 	{
-		zipOut.close();
-		QFile::remove(targetJarPath);
-		QLOG_ERROR() << "Failed to insert minecraft.jar contents.";
-		return false;
+		previousJar.close();
 	}
 
 	// Recompress the jar
 	zipOut.close();
 	if (zipOut.getZipError() != 0)
 	{
-		QFile::remove(targetJarPath);
+		QFile::remove(partJarPath);
 		QLOG_ERROR() << "Failed to finalize minecraft.jar!";
 		return false;
 	}
+	if ((QFile::exists(targetJarPath) && !QFile::remove(targetJarPath)) ||
+		!QFile::rename(partJarPath, targetJarPath))
+	{
+		QFile::remove(partJarPath);
+		QLOG_ERROR() << "Failed to replace" << targetJarPath;
+		return false;
+	}
+	QLOG_INFO() << "Built" << targetJarPath << "reusing" << reused << "of" << inputs.size()
+				<< "inputs from the previous build";
+	if (rebuilt)
+		*rebuilt = true;
+	if (!writeManifest(targetJarPath, inputs))
+	{
+		QLOG_WARN() << "Failed to write the manifest for" << targetJarPath;
+	}
 	return true;
 }
 
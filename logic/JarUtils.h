@@ -14,5 +14,14 @@ namespace JarUtils
 	bool mergeZipFiles(QuaZip *into, QFileInfo from, QSet<QString> &contained,
 				   std::function<bool(QString)> filter);
 
-	bool createModdedJar(QString sourceJarPath, QString targetJarPath, const QList<Mod>& mods);
+	/**
+	 * Build targetJarPath from the source jar and the enabled mods, later mods first.
+	 * The inputs are recorded in targetJarPath.manifest, with their sizes and modification
+	 * times so unchanged files don't have to be hashed again. If they didn't change, the jar is
+	 * left alone. Otherwise entries of unchanged inputs are copied from the previous jar
+	 * without recompressing them.
+	 * If rebuilt is given, it tells whether a new jar was written.
+	 */
+	bool createModdedJar(QString sourceJarPath, QString targetJarPath, const QList<Mod>& mods,
+						 bool *rebuilt = nullptr);
 }
@@ -126,9 +126,7 @@ std::shared_ptr<Task> LegacyInstance::doUpdate()
 
 bool LegacyInstance::prepareForLaunch(AuthSessionPtr account, QString &launchScript)
 {
-	QIcon icon = MMC->icons()->getIcon(iconKey());
-	auto pixmap = icon.pixmap(128, 128);
-	pixmap.save(PathCombine(minecraftRoot(), "icon.png"), "PNG");
+	MMC->icons()->saveIcon(iconKey(), PathCombine(minecraftRoot(), "icon.png"), 128);
 
 	// create the launch script
 	{
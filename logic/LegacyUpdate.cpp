@@ -446,12 +446,6 @@ void LegacyUpdate::ModTheJar()
 		return;
 	}
 
-	if (runnableJar.exists() && !QFile::remove(runnableJar.filePath()))
-	{
-		emitFailed("Failed to delete old minecraft.jar");
-		return;
-	}
-
 	// TaskStep(); // STEP 1
 	setStatus(tr("Installing mods: Opening minecraft.jar ..."));
 
@@ -459,6 +453,7 @@ void LegacyUpdate::ModTheJar()
 	QString outputJarPath = runnableJar.filePath();
 	QString inputJarPath = baseJar.filePath();
 
+	// the old minecraft.jar stays until the new one is done, unchanged parts are reused from it
 	if(!JarUtils::createModdedJar(inputJarPath, outputJarPath, mods))
 	{
 		emitFailed(tr("Failed to create the custom Minecraft jar file."));
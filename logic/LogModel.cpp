@@ -0,0 +1,188 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LogModel.h"
+
+#include <QBrush>
+#include <QColor>
+
+LogModel::LogModel(int maxLines, QObject *parent)
+	: QAbstractListModel(parent), m_maxLines(qMax(1, maxLines))
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+	if (parent.isValid())
+		return 0;
+	return m_numLines;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() < 0 || index.row() >= m_numLines)
+		return QVariant();
+
+	const LogLine &entry = line(index.row());
+	switch (role)
+	{
+	case Qt::DisplayRole:
+		return entry.text;
+	case Qt::ForegroundRole:
+		switch (entry.level)
+		{
+		case MessageLevel::MultiMC:
+			return QBrush(QColor("blue"));
+		case MessageLevel::Debug:
+			return QBrush(QColor("green"));
+		case MessageLevel::Warning:
+			return QBrush(QColor("orange"));
+		case MessageLevel::Error:
+		case MessageLevel::Fatal:
+			return QBrush(QColor("red"));
+		case MessageLevel::PrePost:
+			return QBrush(QColor("grey"));
+		default:
+			return QVariant();
+		}
+	case Qt::BackgroundRole:
+		if (entry.level == MessageLevel::Fatal)
+			return QBrush(QColor("black"));
+		return QVariant();
+	default:
+		return QVariant();
+	}
+}
+
+int LogModel::append(const LogBlock &lines)
+{
+	QVector<LogLine> rows;
+	rows.reserve(lines.size());
+	for (auto &entry : lines)
+	{
+		if (!entry.text.contains('\n'))
+		{
+			rows.append(entry);
+			continue;
+		}
+		QString text = entry.text;
+		if (text.endsWith('\n'))
+			text.chop(1);
+		for (auto &paragraph : text.split('\n'))
+		{
+			rows.append(LogLine{paragraph, entry.level});
+		}
+	}
+	if (rows.isEmpty())
+		return 0;
+
+	// of a batch bigger than the whole log, only the end is kept
+	if (rows.size() > m_maxLines)
+		rows.remove(0, rows.size() - m_maxLines);
+
+	const int overflow = m_numLines + rows.size() - m_maxLines;
+	if (overflow > 0)
+	{
+		beginRemoveRows(QModelIndex(), 0, overflow - 1);
+		// from here on the buffer is full and wraps around
+		if (m_content.size() < m_maxLines)
+			m_content.resize(m_maxLines);
+		for (int i = 0; i < overflow; i++)
+		{
+			m_content[(m_firstLine + i) % m_maxLines].text.clear();
+		}
+		m_firstLine = (m_firstLine + overflow) % m_maxLines;
+		m_numLines -= overflow;
+		endRemoveRows();
+	}
+
+	beginInsertRows(QModelIndex(), m_numLines, m_numLines + rows.size() - 1);
+	for (auto &row : rows)
+	{
+		if (m_content.size() < m_maxLines)
+			m_content.append(row);
+		else
+			m_content[(m_firstLine + m_numLines) % m_maxLines] = row;
+		m_numLines++;
+	}
+	endInsertRows();
+
+	return qMax(overflow, 0);
+}
+
+void LogModel::clear()
+{
+	beginResetModel();
+	m_content.clear();
+	m_firstLine = 0;
+	m_numLines = 0;
+	endResetModel();
+}
+
+void LogModel::setMaxLines(int maxLines)
+{
+	maxLines = qMax(1, maxLines);
+	if (maxLines == m_maxLines)
+		return;
+
+	beginResetModel();
+	// keep the newest lines, in order, and start over without wrapping
+	const int keep = qMin(m_numLines, maxLines);
+	QVector<LogLine> content;
+	content.reserve(keep);
+	for (int row = m_numLines - keep; row < m_numLines; row++)
+	{
+		content.append(line(row));
+	}
+	m_content = content;
+	m_firstLine = 0;
+	m_numLines = keep;
+	m_maxLines = maxLines;
+	endResetModel();
+}
+
+int LogModel::find(const QString &text, int from, bool backwards) const
+{
+	if (text.isEmpty())
+		return -1;
+	if (backwards)
+	{
+		for (int row = qMin(from, m_numLines - 1); row >= 0; row--)
+		{
+			if (line(row).text.contains(text, Qt::CaseInsensitive))
+				return row;
+		}
+	}
+	else
+	{
+		for (int row = qMax(from, 0); row < m_numLines; row++)
+		{
+			if (line(row).text.contains(text, Qt::CaseInsensitive))
+				return row;
+		}
+	}
+	return -1;
+}
+
+QString LogModel::toPlainText() const
+{
+	QString out;
+	for (int row = 0; row < m_numLines; row++)
+	{
+		out += line(row).text;
+		out += '\n';
+	}
+	return out;
+}
@@ -0,0 +1,70 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QVector>
+
+#include "logic/LogProcessor.h"
+
+/**
+ * A log with one row per line, keeping at most maxLines() of the newest lines.
+ * The lines are kept in a ring buffer, so dropping the oldest ones costs nothing.
+ */
+class LogModel : public QAbstractListModel
+{
+	Q_OBJECT
+public:
+	explicit LogModel(int maxLines, QObject *parent = 0);
+
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+	/**
+	 * Append a batch of lines, splitting multi-line messages into rows.
+	 * Returns the number of old lines dropped from the front to make room.
+	 */
+	int append(const LogBlock &lines);
+	void clear();
+
+	int maxLines() const
+	{
+		return m_maxLines;
+	}
+	void setMaxLines(int maxLines);
+
+	/**
+	 * Find the first line containing the text, starting at the given row, case insensitive.
+	 * Returns -1 if there is none.
+	 */
+	int find(const QString &text, int from, bool backwards = false) const;
+
+	/// The whole log, one line per row
+	QString toPlainText() const;
+
+private:
+	const LogLine &line(int row) const
+	{
+		return m_content[(m_firstLine + row) % m_content.size()];
+	}
+
+private:
+	// grows up to m_maxLines, then wraps around
+	QVector<LogLine> m_content;
+	int m_firstLine = 0;
+	int m_numLines = 0;
+	int m_maxLines;
+};
@@ -0,0 +1,312 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LogProcessor.h"
+
+#include <QStringRef>
+#include <algorithm>
+#include <cstring>
+
+// how long lines are collected before they are handed over
+#define FLUSH_INTERVAL_MS 50
+
+LogProcessor::LogProcessor(QObject *parent)
+	: QObject(parent),
+	  m_log4jLevel("\\[(?<timestamp>[0-9:]+)\\] \\[[^/]+/(?<level>[^\\]]+)\\]"),
+	  m_flushTimer(this)
+{
+	qRegisterMetaType<LogBlock>("LogBlock");
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+	connect(&m_flushTimer, SIGNAL(timeout()), SLOT(flush()));
+}
+
+void LogProcessor::setSession(AuthSessionPtr session)
+{
+	QList<CensorEntry> entries;
+	auto add = [&entries](const QString &needle, const QString &replacement)
+	{
+		// an empty string would match everywhere
+		if (!needle.isEmpty())
+			entries.append(CensorEntry{needle, replacement});
+	};
+	if (session)
+	{
+		if (session->session != "-")
+			add(session->session, "<SESSION ID>");
+		add(session->access_token, "<ACCESS TOKEN>");
+		add(session->client_token, "<CLIENT TOKEN>");
+		add(session->uuid, "<PROFILE ID>");
+		add(session->player_name, "<PROFILE NAME>");
+
+		auto i = session->u.properties.begin();
+		while (i != session->u.properties.end())
+		{
+			add(i.value(), "<" + i.key().toUpper() + ">");
+			++i;
+		}
+	}
+	// longer strings win, so the session ID is replaced as a whole before the token inside it
+	std::stable_sort(entries.begin(), entries.end(),
+					 [](const CensorEntry &a, const CensorEntry &b)
+	{ return a.needle.size() > b.needle.size(); });
+
+	QMutexLocker locker(&m_censorMutex);
+	m_censor.clear();
+	for (auto &entry : entries)
+	{
+		m_censor[entry.needle.at(0)].append(entry);
+	}
+}
+
+QString LogProcessor::censor(const QString &in) const
+{
+	QMutexLocker locker(&m_censorMutex);
+	if (m_censor.isEmpty())
+		return in;
+
+	// one pass over the string for all the censored strings at once
+	QString out;
+	const QChar *data = in.constData();
+	const int size = in.size();
+	int copied = 0;
+	int i = 0;
+	while (i < size)
+	{
+		auto candidates = m_censor.constFind(data[i]);
+		if (candidates != m_censor.constEnd())
+		{
+			const CensorEntry *match = nullptr;
+			for (auto &entry : *candidates)
+			{
+				const int length = entry.needle.size();
+				if (length <= size - i && QStringRef(&in, i, length) == entry.needle)
+				{
+					match = &entry;
+					break;
+				}
+			}
+			if (match)
+			{
+				out.append(QStringRef(&in, copied, i - copied));
+				out.append(match->replacement);
+				i += match->needle.size();
+				copied = i;
+				continue;
+			}
+		}
+		i++;
+	}
+	// nothing was censored, no copy
+	if (copied == 0)
+		return in;
+	out.append(QStringRef(&in, copied, size - copied));
+	return out;
+}
+
+// same as matching "\s+at ", without a regular expression
+static bool isStackTraceLine(const QString &line)
+{
+	int pos = 0;
+	while ((pos = line.indexOf("at ", pos)) != -1)
+	{
+		if (pos > 0 && line.at(pos - 1).isSpace())
+			return true;
+		pos++;
+	}
+	return false;
+}
+
+MessageLevel::Enum LogProcessor::guessLevel(const QString &line, MessageLevel::Enum level) const
+{
+	// the log4j pattern can't match without "] [", which is much cheaper to look for
+	QRegularExpressionMatch match;
+	if (line.contains("] ["))
+		match = m_log4jLevel.match(line);
+	if(match.hasMatch())
+	{
+		// New style logs from log4j
+		QString levelStr = match.captured("level");
+		if(levelStr == "INFO")
+			level = MessageLevel::Message;
+		if(levelStr == "WARN")
+			level = MessageLevel::Warning;
+		if(levelStr == "ERROR")
+			level = MessageLevel::Error;
+		if(levelStr == "FATAL")
+			level = MessageLevel::Fatal;
+		if(levelStr == "TRACE" || levelStr == "DEBUG")
+			level = MessageLevel::Debug;
+	}
+	else if (line.contains('['))
+	{
+		// Old style forge logs
+		if (line.contains("[INFO]") || line.contains("[CONFIG]") || line.contains("[FINE]") ||
+			line.contains("[FINER]") || line.contains("[FINEST]"))
+			level = MessageLevel::Message;
+		if (line.contains("[SEVERE]") || line.contains("[STDERR]"))
+			level = MessageLevel::Error;
+		if (line.contains("[WARNING]"))
+			level = MessageLevel::Warning;
+		if (line.contains("[DEBUG]"))
+			level = MessageLevel::Debug;
+	}
+	if (line.contains("overwriting existing"))
+		return MessageLevel::Fatal;
+	if (line.contains("Exception in thread") || isStackTraceLine(line))
+		return MessageLevel::Error;
+	return level;
+}
+
+MessageLevel::Enum LogProcessor::getLevel(const QString &levelName)
+{
+	if (levelName == "MultiMC")
+		return MessageLevel::MultiMC;
+	else if (levelName == "Debug")
+		return MessageLevel::Debug;
+	else if (levelName == "Info")
+		return MessageLevel::Info;
+	else if (levelName == "Message")
+		return MessageLevel::Message;
+	else if (levelName == "Warning")
+		return MessageLevel::Warning;
+	else if (levelName == "Error")
+		return MessageLevel::Error;
+	else if (levelName == "Fatal")
+		return MessageLevel::Fatal;
+	// Skip PrePost, it's not exposed to !![]!
+	else
+		return MessageLevel::Message;
+}
+
+QString LogProcessor::levelName(MessageLevel::Enum level)
+{
+	switch (level)
+	{
+	case MessageLevel::MultiMC:
+		return "MultiMC";
+	case MessageLevel::Debug:
+		return "Debug";
+	case MessageLevel::Info:
+		return "Info";
+	case MessageLevel::Message:
+		return "Message";
+	case MessageLevel::Warning:
+		return "Warning";
+	case MessageLevel::Error:
+		return "Error";
+	case MessageLevel::Fatal:
+		return "Fatal";
+	case MessageLevel::PrePost:
+		return "PrePost";
+	}
+	return "Message";
+}
+
+void LogProcessor::appendOutput(QByteArray data, int channel)
+{
+	if (channel < 0 || channel >= ChannelCount)
+		return;
+	QByteArray &leftover = m_leftover[channel];
+
+	const char *pos = data.constData();
+	const char *const end = pos + data.size();
+	while (pos < end)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(pos, '\n', end - pos));
+		if (!lineEnd)
+			break;
+		if (leftover.isEmpty())
+		{
+			appendLine(pos, lineEnd - pos, channel);
+		}
+		else
+		{
+			leftover.append(pos, lineEnd - pos);
+			appendLine(leftover.constData(), leftover.size(), channel);
+			leftover.clear();
+		}
+		pos = lineEnd + 1;
+	}
+	if (pos < end)
+		leftover.append(pos, end - pos);
+}
+
+void LogProcessor::finishChannel(int channel)
+{
+	if (channel < 0 || channel >= ChannelCount)
+		return;
+	QByteArray &leftover = m_leftover[channel];
+	if (!leftover.isEmpty())
+	{
+		appendLine(leftover.constData(), leftover.size(), channel);
+		leftover.clear();
+	}
+}
+
+void LogProcessor::appendLine(const char *data, int size, int channel)
+{
+	QString line = QString::fromLocal8Bit(data, size);
+	line.remove('\r');
+
+	//FIXME: make more flexible in the future
+	if(line.contains("ignoring option PermSize"))
+	{
+		return;
+	}
+
+	// pre/post launch command output is neither classified nor censored
+	const bool prePost = channel == PrePostOut || channel == PrePostErr;
+	MessageLevel::Enum level = MessageLevel::Message;
+	if (prePost)
+		level = MessageLevel::PrePost;
+	else if (channel == StdErr)
+		level = MessageLevel::Error;
+
+	// Level prefix
+	int endmark = line.indexOf("]!");
+	if (line.startsWith("!![") && endmark != -1)
+	{
+		level = getLevel(line.mid(3, endmark - 3));
+		line = line.mid(endmark + 2);
+	}
+	// Guess level
+	else if (!prePost)
+		level = guessLevel(line, level);
+
+	if (!prePost)
+		line = censor(line);
+
+	m_pending.append(LogLine{line, level});
+	if (!m_flushTimer.isActive())
+		m_flushTimer.start();
+}
+
+void LogProcessor::appendMessage(QString text, int level)
+{
+	m_pending.append(LogLine{text, MessageLevel::Enum(level)});
+	if (!m_flushTimer.isActive())
+		m_flushTimer.start();
+}
+
+void LogProcessor::flush()
+{
+	m_flushTimer.stop();
+	if (m_pending.isEmpty())
+		return;
+	LogBlock lines;
+	lines.swap(m_pending);
+	emit linesReady(lines);
+}
@@ -0,0 +1,99 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+#include <QRegularExpression>
+
+#include "logic/MessageLevel.h"
+#include "logic/auth/AuthSession.h"
+
+struct LogLine
+{
+	QString text;
+	MessageLevel::Enum level;
+};
+typedef QList<LogLine> LogBlock;
+Q_DECLARE_METATYPE(LogBlock)
+
+/**
+ * @brief Turns the raw output of a minecraft process into classified log lines.
+ *
+ * Lives on its own thread. Output is fed in as raw bytes, split into lines, classified and
+ * censored there, and handed back in batches through linesReady().
+ * Everything fed in comes out in the same order, messages included.
+ */
+class LogProcessor : public QObject
+{
+	Q_OBJECT
+public:
+	enum Channel
+	{
+		StdOut,
+		StdErr,
+		PrePostOut,
+		PrePostErr,
+		ChannelCount
+	};
+
+	explicit LogProcessor(QObject *parent = 0);
+
+	/// set the session to censor out of the log. Thread safe.
+	void setSession(AuthSessionPtr session);
+	/// replace private information from the session in the string. Thread safe.
+	QString censor(const QString &in) const;
+
+	MessageLevel::Enum guessLevel(const QString &line, MessageLevel::Enum level) const;
+	static MessageLevel::Enum getLevel(const QString &levelName);
+	static QString levelName(MessageLevel::Enum level);
+
+public
+slots:
+	/// process a chunk of output. Incomplete lines are kept until the rest arrives.
+	void appendOutput(QByteArray data, int channel);
+	/// process whatever is left of the last line of a channel
+	void finishChannel(int channel);
+	/// log a message as it is
+	void appendMessage(QString text, int level);
+	/// hand over the pending lines now
+	void flush();
+
+signals:
+	void linesReady(LogBlock lines);
+
+private:
+	void appendLine(const char *data, int size, int channel);
+
+private:
+	struct CensorEntry
+	{
+		QString needle;
+		QString replacement;
+	};
+	// censored strings by their first character, longest first
+	QHash<QChar, QList<CensorEntry>> m_censor;
+	mutable QMutex m_censorMutex;
+
+	QRegularExpression m_log4jLevel;
+	QByteArray m_leftover[ChannelCount];
+	LogBlock m_pending;
+	QTimer m_flushTimer;
+};
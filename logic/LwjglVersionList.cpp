@@ -157,6 +157,14 @@ void LWJGLVersionList::netRequestComplete()
 
 		beginResetModel();
 		m_vlist.swap(tempList);
+		m_lookup.clear();
+		m_lookup.reserve(m_vlist.size());
+		// when names repeat, the first one in the list wins
+		for (auto &version : m_vlist)
+		{
+			if (!m_lookup.contains(version->name()))
+				m_lookup.insert(version->name(), version);
+		}
 		endResetModel();
 
 		QLOG_INFO() << "Loaded LWJGL list.";
@@ -173,13 +181,7 @@ void LWJGLVersionList::netRequestComplete()
 
 const PtrLWJGLVersion LWJGLVersionList::getVersion(const QString &versionName)
 {
-	for (int i = 0; i < count(); i++)
-	{
-		QString name = at(i)->name();
-		if (name == versionName)
-			return at(i);
-	}
-	return PtrLWJGLVersion();
+	return m_lookup.value(versionName);
 }
 
 void LWJGLVersionList::failed(QString msg)
@@ -18,6 +18,7 @@
 #include <QObject>
 #include <QAbstractListModel>
 #include <QUrl>
+#include <QHash>
 #include <QNetworkReply>
 
 #include <memory>
@@ -128,6 +129,8 @@ signals:
 
 private:
 	QList<PtrLWJGLVersion> m_vlist;
+	/// versions by name, for getVersion. rebuilt whenever m_vlist is replaced.
+	QHash<QString, PtrLWJGLVersion> m_lookup;
 
 	QNetworkReply *m_netReply;
 	QNetworkReply *reply;
@@ -0,0 +1,35 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/**
+ * @brief the MessageLevel Enum
+ * defines what level a message is
+ */
+namespace MessageLevel
+{
+enum Enum
+{
+	MultiMC, /**< MultiMC Messages */
+	Debug,   /**< Debug Messages */
+	Info,    /**< Info Messages */
+	Message, /**< Standard Messages */
+	Warning, /**< Warnings */
+	Error,   /**< Errors */
+	Fatal,   /**< Fatal Errors */
+	PrePost, /**< Pre/Post Launch command output */
+};
+}
@@ -18,12 +18,12 @@
 #include "BuildConfig.h"
 
 #include "MinecraftProcess.h"
+#include "RotatingLogFile.h"
 
 #include <QDataStream>
 #include <QFile>
 #include <QDir>
 #include <QProcessEnvironment>
-#include <QRegularExpression>
 #include <QStandardPaths>
 
 #include "BaseInstance.h"
@@ -37,6 +37,17 @@
 // constructor
 MinecraftProcess::MinecraftProcess(InstancePtr inst) : m_instance(inst)
 {
+	// the output is split, classified and censored away from the GUI thread
+	m_logProcessor = new LogProcessor();
+	m_logProcessor->moveToThread(&m_logThread);
+	connect(m_logProcessor, SIGNAL(linesReady(LogBlock)), SIGNAL(log(LogBlock)));
+	// and the whole log of the launch is kept on disk, no matter how much the console shows
+	m_logFile = new RotatingLogFile(PathCombine(m_instance->minecraftRoot(), "logs", "multimc"));
+	m_logFile->moveToThread(&m_logThread);
+	connect(m_logProcessor, SIGNAL(linesReady(LogBlock)), m_logFile, SLOT(write(LogBlock)));
+	connect(&m_logThread, SIGNAL(finished()), m_logFile, SLOT(close()));
+	m_logThread.start();
+
 	connect(this, SIGNAL(finished(int, QProcess::ExitStatus)),
 			SLOT(finish(int, QProcess::ExitStatus)));
 
@@ -122,6 +133,13 @@ MinecraftProcess::MinecraftProcess(InstancePtr inst) : m_instance(inst)
 	m_instance->setRunning(true);
 }
 
+MinecraftProcess::~MinecraftProcess()
+{
+	stopLogging();
+	delete m_logFile;
+	delete m_logProcessor;
+}
+
 void MinecraftProcess::setWorkdir(QString path)
 {
 	QDir mcDir(path);
@@ -131,203 +149,82 @@ void MinecraftProcess::setWorkdir(QString path)
 
 QString MinecraftProcess::censorPrivateInfo(QString in)
 {
-	if (!m_session)
-		return in;
-
-	if (m_session->session != "-")
-		in.replace(m_session->session, "<SESSION ID>");
-	in.replace(m_session->access_token, "<ACCESS TOKEN>");
-	in.replace(m_session->client_token, "<CLIENT TOKEN>");
-	in.replace(m_session->uuid, "<PROFILE ID>");
-	in.replace(m_session->player_name, "<PROFILE NAME>");
-
-	auto i = m_session->u.properties.begin();
-	while (i != m_session->u.properties.end())
-	{
-		in.replace(i.value(), "<" + i.key().toUpper() + ">");
-		++i;
-	}
-
-	return in;
+	return m_logProcessor->censor(in);
 }
 
-// console window
-MessageLevel::Enum MinecraftProcess::guessLevel(const QString &line, MessageLevel::Enum level)
+void MinecraftProcess::logMessage(QString text, MessageLevel::Enum level)
 {
-	QRegularExpression re("\\[(?<timestamp>[0-9:]+)\\] \\[[^/]+/(?<level>[^\\]]+)\\]");
-	auto match = re.match(line);
-	if(match.hasMatch())
-	{
-		// New style logs from log4j
-		QString timestamp = match.captured("timestamp");
-		QString levelStr = match.captured("level");
-		if(levelStr == "INFO")
-			level = MessageLevel::Message;
-		if(levelStr == "WARN")
-			level = MessageLevel::Warning;
-		if(levelStr == "ERROR")
-			level = MessageLevel::Error;
-		if(levelStr == "FATAL")
-			level = MessageLevel::Fatal;
-		if(levelStr == "TRACE" || levelStr == "DEBUG")
-			level = MessageLevel::Debug;
-	}
-	else
-	{
-		// Old style forge logs
-		if (line.contains("[INFO]") || line.contains("[CONFIG]") || line.contains("[FINE]") ||
-			line.contains("[FINER]") || line.contains("[FINEST]"))
-			level = MessageLevel::Message;
-		if (line.contains("[SEVERE]") || line.contains("[STDERR]"))
-			level = MessageLevel::Error;
-		if (line.contains("[WARNING]"))
-			level = MessageLevel::Warning;
-		if (line.contains("[DEBUG]"))
-			level = MessageLevel::Debug;
-	}
-	if (line.contains("overwriting existing"))
-		return MessageLevel::Fatal;
-	if (line.contains("Exception in thread") || line.contains(QRegularExpression("\\s+at ")))
-		return MessageLevel::Error;
-	return level;
+	QMetaObject::invokeMethod(m_logProcessor, "appendMessage", Qt::QueuedConnection,
+							  Q_ARG(QString, text), Q_ARG(int, level));
 }
 
-MessageLevel::Enum MinecraftProcess::getLevel(const QString &levelName)
+void MinecraftProcess::logOutput(QByteArray data, LogProcessor::Channel channel)
 {
-	if (levelName == "MultiMC")
-		return MessageLevel::MultiMC;
-	else if (levelName == "Debug")
-		return MessageLevel::Debug;
-	else if (levelName == "Info")
-		return MessageLevel::Info;
-	else if (levelName == "Message")
-		return MessageLevel::Message;
-	else if (levelName == "Warning")
-		return MessageLevel::Warning;
-	else if (levelName == "Error")
-		return MessageLevel::Error;
-	else if (levelName == "Fatal")
-		return MessageLevel::Fatal;
-	// Skip PrePost, it's not exposed to !![]!
-	else
-		return MessageLevel::Message;
+	QMetaObject::invokeMethod(m_logProcessor, "appendOutput", Qt::QueuedConnection,
+							  Q_ARG(QByteArray, data), Q_ARG(int, channel));
 }
 
-void MinecraftProcess::logOutput(const QStringList &lines, MessageLevel::Enum defaultLevel,
-								 bool guessLevel, bool censor)
+void MinecraftProcess::finishOutput(LogProcessor::Channel channel)
 {
-	for (int i = 0; i < lines.size(); ++i)
-		logOutput(lines[i], defaultLevel, guessLevel, censor);
+	QMetaObject::invokeMethod(m_logProcessor, "finishChannel", Qt::QueuedConnection,
+							  Q_ARG(int, channel));
 }
 
-void MinecraftProcess::logOutput(QString line, MessageLevel::Enum defaultLevel, bool guessLevel,
-								 bool censor)
+void MinecraftProcess::stopLogging()
 {
-	MessageLevel::Enum level = defaultLevel;
-
-	//FIXME: make more flexible in the future
-	if(line.contains("ignoring option PermSize"))
-	{
+	// a blocking call into a stopped thread would never return
+	if (!m_logThread.isRunning())
 		return;
-	}
-
-	// Level prefix
-	int endmark = line.indexOf("]!");
-	if (line.startsWith("!![") && endmark != -1)
-	{
-		level = getLevel(line.left(endmark).mid(3));
-		line = line.mid(endmark + 2);
-	}
-	// Guess level
-	else if (guessLevel)
-		level = this->guessLevel(line, defaultLevel);
-
-	if (censor)
-		line = censorPrivateInfo(line);
-
-	emit log(line, level);
+	// everything queued so far is processed and handed over before the thread stops
+	QMetaObject::invokeMethod(m_logProcessor, "flush", Qt::BlockingQueuedConnection);
+	m_logThread.quit();
+	m_logThread.wait();
 }
 
 void MinecraftProcess::on_stdErr()
 {
-	QByteArray data = readAllStandardError();
-	QString str = m_err_leftover + QString::fromLocal8Bit(data);
-
-	str.remove('\r');
-	QStringList lines = str.split("\n");
-	m_err_leftover = lines.takeLast();
-
-	logOutput(lines, MessageLevel::Error);
+	logOutput(readAllStandardError(), LogProcessor::StdErr);
 }
 
 void MinecraftProcess::on_stdOut()
 {
-	QByteArray data = readAllStandardOutput();
-	QString str = m_out_leftover + QString::fromLocal8Bit(data);
-
-	str.remove('\r');
-	QStringList lines = str.split("\n");
-	m_out_leftover = lines.takeLast();
-
-	logOutput(lines);
+	logOutput(readAllStandardOutput(), LogProcessor::StdOut);
 }
 
 void MinecraftProcess::on_prepost_stdErr()
 {
-	QByteArray data = m_prepostlaunchprocess.readAllStandardError();
-	QString str = m_err_leftover + QString::fromLocal8Bit(data);
-
-	str.remove('\r');
-	QStringList lines = str.split("\n");
-	m_err_leftover = lines.takeLast();
-
-	logOutput(lines, MessageLevel::PrePost, false, false);
+	logOutput(m_prepostlaunchprocess.readAllStandardError(), LogProcessor::PrePostErr);
 }
 
 void MinecraftProcess::on_prepost_stdOut()
 {
-	QByteArray data = m_prepostlaunchprocess.readAllStandardOutput();
-	QString str = m_out_leftover + QString::fromLocal8Bit(data);
-
-	str.remove('\r');
-	QStringList lines = str.split("\n");
-	m_out_leftover = lines.takeLast();
-
-	logOutput(lines, MessageLevel::PrePost, false, false);
+	logOutput(m_prepostlaunchprocess.readAllStandardOutput(), LogProcessor::PrePostOut);
 }
 
 // exit handler
 void MinecraftProcess::finish(int code, ExitStatus status)
 {
 	// Flush console window
-	if (!m_err_leftover.isEmpty())
-	{
-		logOutput(m_err_leftover, MessageLevel::Error);
-		m_err_leftover.clear();
-	}
-	if (!m_out_leftover.isEmpty())
-	{
-		logOutput(m_out_leftover);
-		m_out_leftover.clear();
-	}
+	finishOutput(LogProcessor::StdErr);
+	finishOutput(LogProcessor::StdOut);
 
 	if (!killed)
 	{
 		if (status == NormalExit)
 		{
 			//: Message displayed on instance exit
-			emit log(tr("Minecraft exited with exitcode %1.").arg(code));
+			logMessage(tr("Minecraft exited with exitcode %1.").arg(code));
 		}
 		else
 		{
 			//: Message displayed on instance crashed
-			emit log(tr("Minecraft crashed with exitcode %1.").arg(code));
+			logMessage(tr("Minecraft crashed with exitcode %1.").arg(code));
 		}
 	}
 	else
 	{
 		//: Message displayed after the instance exits due to kill request
-		emit log(tr("Minecraft was killed by user."), MessageLevel::Error);
+		logMessage(tr("Minecraft was killed by user."), MessageLevel::Error);
 	}
 
 	m_prepostlaunchprocess.processEnvironment().insert("INST_EXITCODE", QString(code));
@@ -337,6 +234,7 @@ void MinecraftProcess::finish(int code, ExitStatus status)
 	m_instance->cleanupAfterRun();
 	// no longer running...
 	m_instance->setRunning(false);
+	stopLogging();
 	emit ended(m_instance, code, status);
 }
 
@@ -360,30 +258,22 @@ bool MinecraftProcess::preLaunch()
 	{
 		prelaunch_cmd = substituteVariables(prelaunch_cmd);
 		// Launch
-		emit log(tr("Running Pre-Launch command: %1").arg(prelaunch_cmd));
+		logMessage(tr("Running Pre-Launch command: %1").arg(prelaunch_cmd));
 		m_prepostlaunchprocess.start(prelaunch_cmd);
 		if (!waitForPrePost())
 		{
-			emit log(tr("The command failed to start"), MessageLevel::Fatal);
+			logMessage(tr("The command failed to start"), MessageLevel::Fatal);
 			return false;
 		}
 		// Flush console window
-		if (!m_err_leftover.isEmpty())
-		{
-			logOutput(m_err_leftover, MessageLevel::PrePost);
-			m_err_leftover.clear();
-		}
-		if (!m_out_leftover.isEmpty())
-		{
-			logOutput(m_out_leftover, MessageLevel::PrePost);
-			m_out_leftover.clear();
-		}
+		finishOutput(LogProcessor::PrePostErr);
+		finishOutput(LogProcessor::PrePostOut);
 		// Process return values
 		if (m_prepostlaunchprocess.exitStatus() != NormalExit)
 		{
-			emit log(tr("Pre-Launch command failed with code %1.\n\n")
-						 .arg(m_prepostlaunchprocess.exitCode()),
-					 MessageLevel::Fatal);
+			logMessage(tr("Pre-Launch command failed with code %1.\n\n")
+						   .arg(m_prepostlaunchprocess.exitCode()),
+					   MessageLevel::Fatal);
 			m_instance->cleanupAfterRun();
 			emit prelaunch_failed(m_instance, m_prepostlaunchprocess.exitCode(),
 								  m_prepostlaunchprocess.exitStatus());
@@ -392,7 +282,7 @@ bool MinecraftProcess::preLaunch()
 			return false;
 		}
 		else
-			emit log(tr("Pre-Launch command ran successfully.\n\n"));
+			logMessage(tr("Pre-Launch command ran successfully.\n\n"));
 
 		return m_instance->reload();
 	}
@@ -404,35 +294,27 @@ bool MinecraftProcess::postLaunch()
 	if (!postlaunch_cmd.isEmpty())
 	{
 		postlaunch_cmd = substituteVariables(postlaunch_cmd);
-		emit log(tr("Running Post-Launch command: %1").arg(postlaunch_cmd));
+		logMessage(tr("Running Post-Launch command: %1").arg(postlaunch_cmd));
 		m_prepostlaunchprocess.start(postlaunch_cmd);
 		if (!waitForPrePost())
 		{
 			return false;
 		}
 		// Flush console window
-		if (!m_err_leftover.isEmpty())
-		{
-			logOutput(m_err_leftover, MessageLevel::PrePost);
-			m_err_leftover.clear();
-		}
-		if (!m_out_leftover.isEmpty())
-		{
-			logOutput(m_out_leftover, MessageLevel::PrePost);
-			m_out_leftover.clear();
-		}
+		finishOutput(LogProcessor::PrePostErr);
+		finishOutput(LogProcessor::PrePostOut);
 		if (m_prepostlaunchprocess.exitStatus() != NormalExit)
 		{
-			emit log(tr("Post-Launch command failed with code %1.\n\n")
-						 .arg(m_prepostlaunchprocess.exitCode()),
-					 MessageLevel::Error);
+			logMessage(tr("Post-Launch command failed with code %1.\n\n")
+						   .arg(m_prepostlaunchprocess.exitCode()),
+					   MessageLevel::Error);
 			emit postlaunch_failed(m_instance, m_prepostlaunchprocess.exitCode(),
 								   m_prepostlaunchprocess.exitStatus());
 			// not running, failed
 			m_instance->setRunning(false);
 		}
 		else
-			emit log(tr("Post-Launch command ran successfully.\n\n"));
+			logMessage(tr("Post-Launch command ran successfully.\n\n"));
 
 		return m_instance->reload();
 	}
@@ -520,11 +402,12 @@ QStringList MinecraftProcess::javaArguments() const
 
 void MinecraftProcess::arm()
 {
-	emit log("MultiMC version: " + BuildConfig.printableVersionString() + "\n\n");
-	emit log("Minecraft folder is:\n" + workingDirectory() + "\n\n");
+	logMessage("MultiMC version: " + BuildConfig.printableVersionString() + "\n\n");
+	logMessage("Minecraft folder is:\n" + workingDirectory() + "\n\n");
 
 	if (!preLaunch())
 	{
+		stopLogging();
 		emit ended(m_instance, 1, QProcess::CrashExit);
 		return;
 	}
@@ -534,16 +417,16 @@ void MinecraftProcess::arm()
 	QStringList args = javaArguments();
 
 	QString JavaPath = m_instance->settings().get("JavaPath").toString();
-	emit log("Java path is:\n" + JavaPath + "\n\n");
+	logMessage("Java path is:\n" + JavaPath + "\n\n");
 	QString allArgs = args.join(", ");
-	emit log("Java Arguments:\n[" + censorPrivateInfo(allArgs) + "]\n\n");
+	logMessage("Java Arguments:\n[" + censorPrivateInfo(allArgs) + "]\n\n");
 
 	auto realJavaPath = QStandardPaths::findExecutable(JavaPath);
 	if (realJavaPath.isEmpty())
 	{
-		emit log(tr("The java binary \"%1\" couldn't be found. You may have to set up java "
-					"if Minecraft fails to launch.").arg(JavaPath),
-				 MessageLevel::Warning);
+		logMessage(tr("The java binary \"%1\" couldn't be found. You may have to set up java "
+					  "if Minecraft fails to launch.").arg(JavaPath),
+				   MessageLevel::Warning);
 	}
 
 	// instantiate the launcher part
@@ -551,8 +434,9 @@ void MinecraftProcess::arm()
 	if (!waitForStarted())
 	{
 		//: Error message displayed if instace can't start
-		emit log(tr("Could not launch minecraft!"), MessageLevel::Error);
+		logMessage(tr("Could not launch minecraft!"), MessageLevel::Error);
 		m_instance->cleanupAfterRun();
+		stopLogging();
 		emit launch_failed(m_instance);
 		// not running, failed
 		m_instance->setRunning(false);
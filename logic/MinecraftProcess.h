@@ -19,26 +19,11 @@
 
 #include <QProcess>
 #include <QString>
+#include <QThread>
 #include "BaseInstance.h"
+#include "LogProcessor.h"
 
-/**
- * @brief the MessageLevel Enum
- * defines what level a message is
- */
-namespace MessageLevel
-{
-enum Enum
-{
-	MultiMC, /**< MultiMC Messages */
-	Debug,   /**< Debug Messages */
-	Info,    /**< Info Messages */
-	Message, /**< Standard Messages */
-	Warning, /**< Warnings */
-	Error,   /**< Errors */
-	Fatal,   /**< Fatal Errors */
-	PrePost, /**< Pre/Post Launch command output */
-};
-}
+class RotatingLogFile;
 
 /**
  * @file data/minecraftprocess.h
@@ -54,10 +39,7 @@ public:
 	 */
 	MinecraftProcess(InstancePtr inst);
 
-	virtual ~MinecraftProcess()
-	{
-		
-	};
+	virtual ~MinecraftProcess();
 	
 	/**
 	 * @brief start the launcher part with the provided launch script
@@ -96,6 +78,7 @@ public:
 	inline void setLogin(AuthSessionPtr session)
 	{
 		m_session = session;
+		m_logProcessor->setSession(session);
 	}
 
 signals:
@@ -120,16 +103,16 @@ signals:
 	void ended(InstancePtr, int code, QProcess::ExitStatus status);
 
 	/**
-	 * @brief emitted when we want to log something
-	 * @param text the text to log
-	 * @param level the level to log at
+	 * @brief emitted with the next batch of classified and censored log lines
+	 * @param lines the lines, in the order they were produced
 	 */
-	void log(QString text, MessageLevel::Enum level = MessageLevel::MultiMC);
+	void log(LogBlock lines);
 
 protected:
 	InstancePtr m_instance;
-	QString m_err_leftover;
-	QString m_out_leftover;
+	QThread m_logThread;
+	LogProcessor *m_logProcessor;
+	RotatingLogFile *m_logFile;
 	QProcess m_prepostlaunchprocess;
 	bool killed = false;
 	AuthSessionPtr m_session;
@@ -144,6 +127,17 @@ protected:
 
 	QStringList javaArguments() const;
 
+	/**
+	 * @brief log a message, after all the output received so far
+	 */
+	void logMessage(QString text, MessageLevel::Enum level = MessageLevel::MultiMC);
+	void logOutput(QByteArray data, LogProcessor::Channel channel);
+	void finishOutput(LogProcessor::Channel channel);
+	/**
+	 * @brief hand over the remaining log lines and stop the log thread
+	 */
+	void stopLogging();
+
 protected
 slots:
 	void finish(int, QProcess::ExitStatus status);
@@ -151,15 +145,7 @@ slots:
 	void on_stdOut();
 	void on_prepost_stdOut();
 	void on_prepost_stdErr();
-	void logOutput(const QStringList &lines,
-				   MessageLevel::Enum defaultLevel = MessageLevel::Message,
-				   bool guessLevel = true, bool censor = true);
-	void logOutput(QString line,
-				   MessageLevel::Enum defaultLevel = MessageLevel::Message,
-				   bool guessLevel = true, bool censor = true);
 
 private:
 	QString censorPrivateInfo(QString in);
-	MessageLevel::Enum guessLevel(const QString &message, MessageLevel::Enum defaultLevel);
-	MessageLevel::Enum getLevel(const QString &levelName);
 };
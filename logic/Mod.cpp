@@ -19,6 +19,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonValue>
+#include <QDataStream>
 #include <quazip.h>
 #include <quazipfile.h>
 
@@ -27,12 +28,12 @@
 #include "logic/settings/INIFile.h"
 #include "logger/QsLog.h"
 
-Mod::Mod(const QFileInfo &file)
+Mod::Mod(const QFileInfo &file, bool withDetails)
 {
-	repath(file);
+	repath(file, withDetails);
 }
 
-void Mod::repath(const QFileInfo &file)
+void Mod::repath(const QFileInfo &file, bool withDetails)
 {
 	m_file = file;
 	QString name_base = file.fileName();
@@ -74,6 +75,14 @@ void Mod::repath(const QFileInfo &file)
 		m_name = name_base;
 	}
 
+	if (withDetails)
+	{
+		readDetails();
+	}
+}
+
+void Mod::readDetails()
+{
 	if (m_type == MOD_ZIPFILE)
 	{
 		QuaZip zip(m_file.filePath());
@@ -148,6 +157,37 @@ void Mod::repath(const QFileInfo &file)
 	}
 }
 
+QByteArray Mod::saveDetails() const
+{
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_1);
+	out << m_mod_id << m_name << m_version << m_mcversion << m_homeurl << m_updateurl
+		<< m_description << m_authors << m_credits;
+	return data;
+}
+
+bool Mod::loadDetails(const QByteArray &data)
+{
+	QDataStream in(data);
+	in.setVersion(QDataStream::Qt_5_1);
+	QString mod_id, name, version, mcversion, homeurl, updateurl, description, authors, credits;
+	in >> mod_id >> name >> version >> mcversion >> homeurl >> updateurl >> description >>
+		authors >> credits;
+	if (in.status() != QDataStream::Ok)
+		return false;
+	m_mod_id = mod_id;
+	m_name = name;
+	m_version = version;
+	m_mcversion = mcversion;
+	m_homeurl = homeurl;
+	m_updateurl = updateurl;
+	m_description = description;
+	m_authors = authors;
+	m_credits = credits;
+	return true;
+}
+
 // NEW format
 // https://github.com/MinecraftForge/FML/wiki/FML-mod-information-file/6f62b37cea040daf350dc253eae6326dd9c822c3
 
@@ -373,5 +413,8 @@ bool Mod::operator==(const Mod &other) const
 }
 bool Mod::strongCompare(const Mod &other) const
 {
-	return mmc_id() == other.mmc_id() && version() == other.version() && type() == other.type();
+	// the version may not be read yet, so the files themselves are compared instead
+	return mmc_id() == other.mmc_id() && type() == other.type() &&
+		   m_file.size() == other.m_file.size() &&
+		   m_file.lastModified() == other.m_file.lastModified();
 }
@@ -28,7 +28,8 @@ public:
 		MOD_LITEMOD, //!< The mod is a litemod
 	};
 
-	Mod(const QFileInfo &file);
+	/// withDetails: also read the mod's metadata (see readDetails()) right away
+	Mod(const QFileInfo &file, bool withDetails = true);
 
 	QFileInfo filename() const
 	{
@@ -94,7 +95,19 @@ public:
 	// replace this mod with a copy of the other
 	bool replace(Mod &with);
 	// change the mod's filesystem path (used by mod lists for *MAGIC* purposes)
-	void repath(const QFileInfo &file);
+	void repath(const QFileInfo &file, bool withDetails = true);
+
+	/// true if the mod has metadata in its files that readDetails() can extract
+	bool hasDetails() const
+	{
+		return m_type == MOD_ZIPFILE || m_type == MOD_LITEMOD || m_type == MOD_FOLDER;
+	}
+	/// read the metadata (mcmod.info, litemod.json, ...) from the mod's files
+	void readDetails();
+	/// serialize the metadata, for caching it
+	QByteArray saveDetails() const;
+	/// restore the metadata serialized by saveDetails()
+	bool loadDetails(const QByteArray &data);
 
 	// WEAK compare operator - used for replacing mods
 	bool operator==(const Mod &other) const;
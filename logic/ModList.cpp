@@ -21,7 +21,13 @@
 #include <QUuid>
 #include <QString>
 #include <QFileSystemWatcher>
+#include <QtConcurrentMap>
+#include <QSet>
+#include <QHash>
+#include <QVector>
 #include "logger/QsLog.h"
+#include "logic/ModMetadataCache.h"
+#include "MultiMC.h"
 
 ModList::ModList(const QString &dir, const QString &list_file)
 	: QAbstractListModel(), m_dir(dir), m_list_file(list_file)
@@ -35,6 +41,8 @@ ModList::ModList(const QString &dir, const QString &list_file)
 	is_watching = false;
 	connect(m_watcher, SIGNAL(directoryChanged(QString)), this,
 			SLOT(directoryChanged(QString)));
+	connect(&m_detailsWatcher, SIGNAL(resultsReadyAt(int, int)), SLOT(detailsReady(int, int)));
+	connect(&m_detailsWatcher, SIGNAL(finished()), SLOT(detailsFinished()));
 }
 
 void ModList::startWatching()
@@ -76,25 +84,184 @@ void ModList::internalSort(QList<Mod> &what)
 	std::sort(what.begin(), what.end(), predicate);
 }
 
+Mod ModList::modFromFile(const QFileInfo &file)
+{
+	Mod mod(file, false);
+	if (mod.hasDetails() && !MMC->modcache()->lookup(mod))
+	{
+		m_detailsPending.append(file);
+	}
+	return mod;
+}
+
+void ModList::readPendingDetails()
+{
+	if (m_detailsPending.isEmpty())
+		return;
+	QLOG_INFO() << "Reading metadata of" << m_detailsPending.size() << "mods in"
+				<< m_dir.absolutePath();
+	std::function<ModDetails(const QFileInfo &)> reader = [](const QFileInfo &file)
+	{
+		Mod mod(file);
+		ModDetails result;
+		result.path = file.absoluteFilePath();
+		result.details = mod.saveDetails();
+		return result;
+	};
+	m_detailsWatcher.setFuture(QtConcurrent::mapped(m_detailsPending, reader));
+	m_detailsPending.clear();
+}
+
+void ModList::detailsReady(int begin, int end)
+{
+	auto cache = MMC->modcache();
+	auto future = m_detailsWatcher.future();
+	QHash<QString, int> rows;
+	for (int row = 0; row < mods.size(); row++)
+	{
+		rows.insert(mods[row].filename().absoluteFilePath(), row);
+	}
+	for (int i = begin; i < end; i++)
+	{
+		auto result = future.resultAt(i);
+		int row = rows.value(result.path, -1);
+		if (row == -1)
+			continue;
+		auto &mod = mods[row];
+		mod.loadDetails(result.details);
+		cache->insert(mod.filename(), result.details);
+		emit dataChanged(index(row, 0), index(row, columnCount(QModelIndex()) - 1));
+	}
+}
+
+void ModList::detailsFinished()
+{
+	MMC->modcache()->SaveEventually();
+}
+
+namespace
+{
+/// true if the two mods look the same in the list
+bool sameDisplay(const Mod &a, const Mod &b)
+{
+	return a.name() == b.name() && a.version() == b.version() && a.enabled() == b.enabled() &&
+		   a.filename().filePath() == b.filename().filePath();
+}
+}
+
+void ModList::applyMods(const QList<Mod> &newMods)
+{
+	// the diff is keyed on the mod id, which is only ambiguous in the corner case of a mod
+	// being there both enabled and disabled. Just start over then.
+	QHash<QString, int> newRows;
+	newRows.reserve(newMods.size());
+	for (int i = 0; i < newMods.size(); i++)
+	{
+		newRows.insert(newMods[i].mmc_id(), i);
+	}
+	QSet<QString> oldIds;
+	oldIds.reserve(mods.size());
+	for (auto &mod : mods)
+	{
+		oldIds.insert(mod.mmc_id());
+	}
+	if (newRows.size() != newMods.size() || oldIds.size() != mods.size())
+	{
+		beginResetModel();
+		mods = newMods;
+		endResetModel();
+		return;
+	}
+
+	int lastColumn = columnCount(QModelIndex()) - 1;
+	auto updateRow = [&](int row, const Mod &mod)
+	{
+		bool changed = !sameDisplay(mods[row], mod);
+		mods[row] = mod;
+		if (changed)
+			emit dataChanged(index(row, 0), index(row, lastColumn));
+	};
+
+	// remove the mods that are gone, a run of rows at a time
+	for (int i = mods.size() - 1; i >= 0; i--)
+	{
+		if (newRows.contains(mods[i].mmc_id()))
+			continue;
+		int last = i;
+		while (i > 0 && !newRows.contains(mods[i - 1].mmc_id()))
+			i--;
+		beginRemoveRows(QModelIndex(), i, last);
+		mods.erase(mods.begin() + i, mods.begin() + last + 1);
+		endRemoveRows();
+	}
+
+	// everything above row matches the new list, the rest of the old mods are below it
+	for (int row = 0; row < newMods.size(); row++)
+	{
+		const Mod &mod = newMods[row];
+		if (row < mods.size() && mods[row].mmc_id() == mod.mmc_id())
+		{
+			updateRow(row, mod);
+			continue;
+		}
+		if (!oldIds.contains(mod.mmc_id()))
+		{
+			int last = row;
+			while (last + 1 < newMods.size() && !oldIds.contains(newMods[last + 1].mmc_id()))
+				last++;
+			beginInsertRows(QModelIndex(), row, last);
+			for (int i = row; i <= last; i++)
+			{
+				mods.insert(i, newMods[i]);
+			}
+			endInsertRows();
+			row = last;
+			continue;
+		}
+		int from = row + 1;
+		while (mods[from].mmc_id() != mod.mmc_id())
+			from++;
+		beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+		mods.move(from, row);
+		endMoveRows();
+		updateRow(row, mod);
+	}
+}
+
 bool ModList::update()
 {
 	if (!isValid())
 		return false;
 
+	// metadata still being read for the old state is read again if it's needed
+	m_detailsWatcher.cancel();
+	m_detailsPending.clear();
+
 	QList<Mod> orderedMods;
 	QList<Mod> newMods;
 	m_dir.refresh();
 	auto folderContents = m_dir.entryInfoList();
 	bool orderOrStateChanged = false;
 
+	// index the folder by file name, so looking up the ordered items is cheap
+	QHash<QString, int> folderIndex;
+	folderIndex.reserve(folderContents.size());
+	for (int i = 0; i < folderContents.size(); i++)
+	{
+		folderIndex.insert(folderContents[i].fileName(), i);
+	}
+	QVector<bool> taken(folderContents.size(), false);
+
 	// first, process the ordered items (if any)
 	OrderList listOrder = readListFile();
 	for (auto item : listOrder)
 	{
-		QFileInfo infoEnabled(m_dir.filePath(item.id));
-		QFileInfo infoDisabled(m_dir.filePath(item.id + ".disabled"));
-		int idxEnabled = folderContents.indexOf(infoEnabled);
-		int idxDisabled = folderContents.indexOf(infoDisabled);
+		int idxEnabled = folderIndex.value(item.id, -1);
+		int idxDisabled = folderIndex.value(item.id + ".disabled", -1);
+		if (idxEnabled >= 0 && taken[idxEnabled])
+			idxEnabled = -1;
+		if (idxDisabled >= 0 && taken[idxDisabled])
+			idxDisabled = -1;
 		bool isEnabled;
 		// if both enabled and disabled versions are present, it's a special case...
 		if (idxEnabled >= 0 && idxDisabled >= 0)
@@ -112,14 +279,13 @@ bool ModList::update()
 			isEnabled = idxEnabled >= 0;
 		}
 		int idx = isEnabled ? idxEnabled : idxDisabled;
-		QFileInfo &info = isEnabled ? infoEnabled : infoDisabled;
 		// if the file from the index file exists
 		if (idx != -1)
 		{
-			// remove from the actual folder contents list
-			folderContents.takeAt(idx);
+			// take it out of the actual folder contents
+			taken[idx] = true;
 			// append the new mod
-			orderedMods.append(Mod(info));
+			orderedMods.append(modFromFile(folderContents[idx]));
 			if (isEnabled != item.enabled)
 				orderOrStateChanged = true;
 		}
@@ -128,14 +294,15 @@ bool ModList::update()
 			orderOrStateChanged = true;
 		}
 	}
+	for (int i = 0; i < folderContents.size(); i++)
+	{
+		if (!taken[i])
+			newMods.append(modFromFile(folderContents[i]));
+	}
 	// if there are any untracked files...
-	if (folderContents.size())
+	if (newMods.size())
 	{
 		// the order surely changed!
-		for (auto entry : folderContents)
-		{
-			newMods.append(Mod(entry));
-		}
 		internalSort(newMods);
 		orderedMods.append(newMods);
 		orderOrStateChanged = true;
@@ -157,9 +324,25 @@ bool ModList::update()
 				}
 			}
 	}
-	beginResetModel();
-	mods.swap(orderedMods);
-	endResetModel();
+
+	// forget the metadata of mod files that are gone
+	{
+		auto cache = MMC->modcache();
+		QSet<QString> present;
+		for (auto &mod : orderedMods)
+		{
+			present.insert(mod.filename().absoluteFilePath());
+		}
+		for (auto &mod : mods)
+		{
+			QString path = mod.filename().absoluteFilePath();
+			if (!present.contains(path))
+				cache->remove(path);
+		}
+	}
+	applyMods(orderedMods);
+	readPendingDetails();
+
 	if (orderOrStateChanged && !m_list_file.isEmpty())
 	{
 		QLOG_INFO() << "Mod list " << m_list_file << " changed!";
@@ -448,8 +631,10 @@ bool ModList::setData(const QModelIndex &index, const QVariant &value, int role)
 	if (role == Qt::CheckStateRole)
 	{
 		auto &mod = mods[index.row()];
+		QString oldPath = mod.filename().absoluteFilePath();
 		if (mod.enable(!mod.enabled()))
 		{
+			MMC->modcache()->move(oldPath, mod.filename().absoluteFilePath());
 			emit dataChanged(index, index);
 			return true;
 		}
@@ -579,9 +764,9 @@ bool ModList::dropMimeData(const QMimeData *data, Qt::DropAction action, int row
 			// if there is no ordering, re-sort the list
 			if (m_list_file.isEmpty())
 			{
-				beginResetModel();
-				internalSort(mods);
-				endResetModel();
+				auto sorted = mods;
+				internalSort(sorted);
+				applyMods(sorted);
 			}
 		}
 		if (was_watching)
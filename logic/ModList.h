@@ -19,6 +19,7 @@
 #include <QString>
 #include <QDir>
 #include <QAbstractListModel>
+#include <QFutureWatcher>
 
 #include "logic/Mod.h"
 
@@ -133,6 +134,8 @@ public:
 
 private:
 	void internalSort(QList<Mod> & what);
+	/// turn the list into newMods, with row changes instead of a model reset
+	void applyMods(const QList<Mod> &newMods);
 	struct OrderItem
 	{
 		QString id;
@@ -141,9 +144,21 @@ private:
 	typedef QList<OrderItem> OrderList;
 	OrderList readListFile();
 	bool saveListFile();
+
+	/// metadata of a mod file, read on the thread pool
+	struct ModDetails
+	{
+		QString path;
+		QByteArray details;
+	};
+	/// make a mod for the file, with metadata from the cache or queued up for reading
+	Mod modFromFile(const QFileInfo &file);
+	void readPendingDetails();
 private
 slots:
 	void directoryChanged(QString path);
+	void detailsReady(int begin, int end);
+	void detailsFinished();
 
 signals:
 	void changed();
@@ -155,4 +170,6 @@ protected:
 	QString m_list_file;
 	QString m_list_id;
 	QList<Mod> mods;
+	QList<QFileInfo> m_detailsPending;
+	QFutureWatcher<ModDetails> m_detailsWatcher;
 };
@@ -0,0 +1,161 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModMetadataCache.h"
+#include "Mod.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+
+#include "logger/QsLog.h"
+
+namespace
+{
+// "MMCM"
+const quint32 CACHE_MAGIC = 0x4d4d434d;
+const quint32 CACHE_VERSION = 1;
+}
+
+ModMetadataCache::ModMetadataCache(QString path) : QObject(), m_path(path)
+{
+	saveBatchingTimer.setSingleShot(true);
+	saveBatchingTimer.setTimerType(Qt::VeryCoarseTimer);
+	connect(&saveBatchingTimer, SIGNAL(timeout()), SLOT(SaveNow()));
+}
+
+ModMetadataCache::~ModMetadataCache()
+{
+	saveBatchingTimer.stop();
+	SaveNow();
+}
+
+void ModMetadataCache::Load()
+{
+	m_loaded = true;
+	QFile file(m_path);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_1);
+	quint32 magic, version;
+	qint32 count;
+	in >> magic >> version;
+	if (magic != CACHE_MAGIC || version != CACHE_VERSION)
+	{
+		QLOG_WARN() << "Ignoring mod metadata cache with unknown format.";
+		return;
+	}
+	in >> count;
+	for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+	{
+		QString path;
+		Entry entry;
+		in >> path >> entry.size >> entry.timestamp >> entry.details;
+		m_entries.insert(path, entry);
+	}
+	if (in.status() != QDataStream::Ok)
+	{
+		QLOG_WARN() << "Ignoring truncated mod metadata cache.";
+		m_entries.clear();
+	}
+}
+
+bool ModMetadataCache::lookup(Mod &mod)
+{
+	if (!m_loaded)
+		Load();
+	const QFileInfo &file = mod.filename();
+	if (!file.isFile())
+		return false;
+	auto iter = m_entries.find(file.absoluteFilePath());
+	if (iter == m_entries.end())
+		return false;
+	if (iter->size != file.size() || iter->timestamp != file.lastModified().toMSecsSinceEpoch())
+		return false;
+	return mod.loadDetails(iter->details);
+}
+
+void ModMetadataCache::insert(const QFileInfo &file, const QByteArray &details)
+{
+	if (!m_loaded)
+		Load();
+	if (!file.isFile())
+		return;
+	Entry entry;
+	entry.size = file.size();
+	entry.timestamp = file.lastModified().toMSecsSinceEpoch();
+	entry.details = details;
+	m_entries.insert(file.absoluteFilePath(), entry);
+	m_dirty = true;
+}
+
+void ModMetadataCache::remove(const QString &path)
+{
+	if (!m_loaded)
+		Load();
+	if (m_entries.remove(path))
+	{
+		m_dirty = true;
+	}
+}
+
+void ModMetadataCache::move(const QString &from, const QString &to)
+{
+	if (!m_loaded)
+		Load();
+	auto iter = m_entries.find(from);
+	if (iter == m_entries.end())
+		return;
+	Entry entry = *iter;
+	m_entries.erase(iter);
+	m_entries.insert(to, entry);
+	m_dirty = true;
+}
+
+void ModMetadataCache::SaveEventually()
+{
+	// reset the save timer
+	saveBatchingTimer.stop();
+	saveBatchingTimer.start(30000);
+}
+
+void ModMetadataCache::SaveNow()
+{
+	if (!m_dirty)
+		return;
+
+	QSaveFile file(m_path);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		QLOG_ERROR() << "Failed to save mod metadata cache:" << file.errorString();
+		return;
+	}
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_1);
+	out << CACHE_MAGIC << CACHE_VERSION << qint32(m_entries.size());
+	for (auto iter = m_entries.begin(); iter != m_entries.end(); iter++)
+	{
+		out << iter.key() << iter->size << iter->timestamp << iter->details;
+	}
+	if (out.status() != QDataStream::Ok || !file.commit())
+	{
+		QLOG_ERROR() << "Failed to save mod metadata cache:" << file.errorString();
+		return;
+	}
+	m_dirty = false;
+}
@@ -0,0 +1,74 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QFileInfo>
+
+class Mod;
+
+/**
+ * Remembers the metadata of mod files between runs, so mod lists don't have to open every
+ * jar again to show it.
+ *
+ * Entries are keyed on the absolute path of the file and are only valid while its size and
+ * modification time stay the same. Folder mods aren't cached, there is nothing to check
+ * their metadata against. Only used from the GUI thread.
+ */
+class ModMetadataCache : public QObject
+{
+	Q_OBJECT
+public:
+	// supply path to the cache file
+	explicit ModMetadataCache(QString path);
+	~ModMetadataCache();
+
+	/// fill in the metadata of the mod, if the cache has it for the current file
+	bool lookup(Mod &mod);
+
+	/// remember the metadata of the mod, serialized with Mod::saveDetails()
+	void insert(const QFileInfo &file, const QByteArray &details);
+
+	/// forget about a file that is gone
+	void remove(const QString &path);
+
+	/// keep the metadata of a file that was renamed (mods get renamed to disable them)
+	void move(const QString &from, const QString &to);
+
+	// (re)start a timer that saves the cache later.
+	void SaveEventually();
+public
+slots:
+	// save the cache now, if it changed
+	void SaveNow();
+
+private:
+	void Load();
+
+	struct Entry
+	{
+		qint64 size = 0;
+		qint64 timestamp = 0;
+		QByteArray details;
+	};
+	QHash<QString, Entry> m_entries;
+	QString m_path;
+	bool m_loaded = false;
+	bool m_dirty = false;
+	QTimer saveBatchingTimer;
+};
@@ -26,6 +26,7 @@
 #include "minecraft/VersionBuildError.h"
 
 #include "logic/assets/AssetsUtils.h"
+#include "logic/storage/ObjectStore.h"
 #include "icons/IconList.h"
 #include "logic/MinecraftProcess.h"
 #include "gui/pagedialog/PageDialog.h"
@@ -146,30 +147,22 @@ QDir OneSixInstance::reconstructAssets(std::shared_ptr<InstanceVersion> version)
 	{
 		QLOG_INFO() << "Reconstructing virtual assets folder at" << virtualRoot.path();
 
+		// the asset objects folder is laid out as a content addressed store already
+		ObjectStore objectStore(objectDir.path());
+
 		for (QString map : index.objects.keys())
 		{
 			AssetObject asset_object = index.objects.value(map);
 			QString target_path = PathCombine(virtualRoot.path(), map);
 			QFile target(target_path);
 
-			QString tlk = asset_object.hash.left(2);
-
-			QString original_path =
-				PathCombine(PathCombine(objectDir.path(), tlk), asset_object.hash);
-			QFile original(original_path);
-			if (!original.exists())
+			if (!objectStore.contains(asset_object.hash))
 				continue;
 			if (!target.exists())
 			{
-				QFileInfo info(target_path);
-				QDir target_dir = info.dir();
-				// QLOG_DEBUG() << target_dir;
-				if (!target_dir.exists())
-					QDir("").mkpath(target_dir.path());
-
-				bool couldCopy = original.copy(target_path);
-				QLOG_DEBUG() << " Copying" << original_path << "to" << target_path
-							 << QString::number(couldCopy); // << original.errorString();
+				bool couldLink = objectStore.materialize(asset_object.hash, target_path);
+				QLOG_DEBUG() << " Linking" << asset_object.hash << "to" << target_path
+							 << QString::number(couldLink);
 			}
 		}
 
@@ -221,9 +214,7 @@ QStringList OneSixInstance::processMinecraftArgs(AuthSessionPtr session)
 bool OneSixInstance::prepareForLaunch(AuthSessionPtr session, QString &launchScript)
 {
 
-	QIcon icon = MMC->icons()->getIcon(iconKey());
-	auto pixmap = icon.pixmap(128, 128);
-	pixmap.save(PathCombine(minecraftRoot(), "icon.png"), "PNG");
+	MMC->icons()->saveIcon(iconKey(), PathCombine(minecraftRoot(), "icon.png"), 128);
 
 	if (!version)
 		return nullptr;
@@ -33,6 +33,7 @@
 #include "logic/forge/ForgeMirrors.h"
 #include "logic/net/URLConstants.h"
 #include "logic/assets/AssetsUtils.h"
+#include "logic/storage/ObjectStore.h"
 #include "JarUtils.h"
 
 OneSixUpdate::OneSixUpdate(OneSixInstance *inst, QObject *parent) : Task(parent), m_inst(inst)
@@ -208,9 +209,9 @@ void OneSixUpdate::jarlibStart()
 	auto libs = version->getActiveNativeLibs();
 	libs.append(version->getActiveNormalLibs());
 
-	auto metacache = MMC->metacache();
-	QList<ForgeXzDownloadPtr> ForgeLibs;
 	QList<std::shared_ptr<OneSixLibrary>> brokenLocalLibs;
+	QList<MetaResolveRequest> requests;
+	jarlibPending.clear();
 
 	for (auto lib : libs)
 	{
@@ -226,18 +227,11 @@ void OneSixUpdate::jarlibStart()
 
 		auto f = [&](QString storage, QString dl)
 		{
-			auto entry = metacache->resolveEntry("libraries", storage);
-			if (entry->stale)
-			{
-				if (lib->hint() == "forge-pack-xz")
-				{
-					ForgeLibs.append(ForgeXzDownload::make(storage, entry));
-				}
-				else
-				{
-					jarlibDownloadJob->addNetAction(CacheDownload::make(dl, entry));
-				}
-			}
+			PendingLibrary pending;
+			pending.url = dl;
+			pending.forgeXz = lib->hint() == "forge-pack-xz";
+			jarlibPending.append(pending);
+			requests.append({"libraries", storage, QString()});
 		};
 		if (raw_storage.contains("${arch}"))
 		{
@@ -268,6 +262,36 @@ void OneSixUpdate::jarlibStart()
 					  "outside of MultiMC.").arg(failed_all));
 		return;
 	}
+
+	// checking the cached libraries may involve hashing them - don't wait for it here
+	setStatus(tr("Checking the library files..."));
+	jarlibResolveBatch = MMC->metacache()->resolveEntries(requests);
+	connect(jarlibResolveBatch.get(), SIGNAL(finished()), SLOT(jarlibResolved()));
+}
+
+void OneSixUpdate::jarlibResolved()
+{
+	auto entries = jarlibResolveBatch->entries();
+	jarlibResolveBatch.reset();
+
+	QList<ForgeXzDownloadPtr> ForgeLibs;
+	for (int i = 0; i < entries.size(); i++)
+	{
+		auto entry = entries[i];
+		if (!entry->stale)
+			continue;
+		auto &pending = jarlibPending[i];
+		if (pending.forgeXz)
+		{
+			ForgeLibs.append(ForgeXzDownload::make(entry->path, entry));
+		}
+		else
+		{
+			jarlibDownloadJob->addNetAction(CacheDownload::make(pending.url, entry));
+		}
+	}
+	jarlibPending.clear();
+
 	// TODO: think about how to propagate this from the original json file... or IF AT ALL
 	QString forgeMirrorList = "http://files.minecraftforge.net/mirror-brand.list";
 	if (!ForgeLibs.empty())
@@ -276,6 +300,7 @@ void OneSixUpdate::jarlibStart()
 			ForgeMirrors::make(ForgeLibs, jarlibDownloadJob, forgeMirrorList));
 	}
 
+	setStatus(tr("Getting the library files from Mojang..."));
 	connect(jarlibDownloadJob.get(), SIGNAL(succeeded()), SLOT(jarlibFinished()));
 	connect(jarlibDownloadJob.get(), SIGNAL(failed()), SLOT(jarlibFailed()));
 	connect(jarlibDownloadJob.get(), SIGNAL(progress(qint64, qint64)),
@@ -299,13 +324,15 @@ void OneSixUpdate::jarlibFinished()
 	}
 	auto finalJarPath = QDir(m_inst->instanceRoot()).absoluteFilePath("temp.jar");
 	QFile finalJar(finalJarPath);
-	if(finalJar.exists())
+	// with jar mods, the previous jar is reused when possible
+	if(finalJar.exists() && !version->hasJarMods())
 	{
 		if(!finalJar.remove())
 		{
 			emitFailed(tr("Couldn't remove stale jar file: %1").arg(finalJarPath));
 			return;
 		}
+		QFile::remove(finalJarPath + ".manifest");
 	}
 
 	// create stripped jar, if needed
@@ -323,11 +350,18 @@ void OneSixUpdate::jarlibFinished()
 			QString filePath = m_inst->jarmodsPath().absoluteFilePath(jarmod->name);
 			mods.push_back(Mod(QFileInfo(filePath)));
 		}
-		if(!JarUtils::createModdedJar(sourceJarPath, finalJarPath, mods))
+		bool rebuilt = false;
+		if(!JarUtils::createModdedJar(sourceJarPath, finalJarPath, mods, &rebuilt))
 		{
 			emitFailed(tr("Failed to create the custom Minecraft jar file."));
 			return;
 		}
+		// instances with the same jar mods end up sharing the modded jar.
+		// an unchanged jar was deduplicated when it was built.
+		if (rebuilt && !MMC->objectstore()->deduplicate(finalJarPath))
+		{
+			QLOG_WARN() << "Couldn't move" << finalJarPath << "into the object store";
+		}
 	}
 	if (version->traits.contains("legacyFML"))
 	{
@@ -417,6 +451,7 @@ void OneSixUpdate::fmllibsFinished()
 		setStatus(tr("Copying FML libraries into the instance..."));
 		OneSixInstance *inst = (OneSixInstance *)m_inst;
 		auto metacache = MMC->metacache();
+		auto objectstore = MMC->objectstore();
 		int index = 0;
 		for (auto &lib : fmlLibsToProcess)
 		{
@@ -428,7 +463,9 @@ void OneSixUpdate::fmllibsFinished()
 				emitFailed(tr("Failed creating FML library folder inside the instance."));
 				return;
 			}
-			if (!QFile::copy(entry->getFullPath(), PathCombine(inst->libDir(), lib.filename)))
+			// all instances share the one stored copy of each library
+			QString hash = objectstore->importFile(entry->getFullPath());
+			if (hash.isEmpty() || !objectstore->materialize(hash, path))
 			{
 				emitFailed(tr("Failed copying Forge/FML library: %1.").arg(lib.filename));
 				return;
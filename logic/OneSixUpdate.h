@@ -39,6 +39,7 @@ slots:
 	void versionUpdateFailed(QString reason);
 
 	void jarlibStart();
+	void jarlibResolved();
 	void jarlibFinished();
 	void jarlibFailed();
 
@@ -55,6 +56,14 @@ slots:
 
 private:
 	NetJobPtr jarlibDownloadJob;
+	/// library cache entries being verified before the download job is assembled
+	MetaResolveBatchPtr jarlibResolveBatch;
+	struct PendingLibrary
+	{
+		QString url;
+		bool forgeXz = false;
+	};
+	QList<PendingLibrary> jarlibPending;
 	NetJobPtr legacyDownloadJob;
 
 	/// target version, determined during this task
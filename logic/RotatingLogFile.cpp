@@ -0,0 +1,211 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RotatingLogFile.h"
+
+#include <QDir>
+#include <QRegularExpression>
+#include <QMutex>
+#include <QSet>
+#include <QtConcurrentRun>
+#include <quagzipfile.h>
+
+#include "logger/QsLog.h"
+#include "pathutils.h"
+
+// segments being compressed right now, by any log of this process
+static QMutex compressingLock;
+static QSet<QString> compressing;
+
+// gzip a full segment and replace it with the compressed one
+static void compressSegment(QString path)
+{
+	struct Release
+	{
+		QString path;
+		~Release()
+		{
+			QMutexLocker locker(&compressingLock);
+			compressing.remove(path);
+		}
+	} release{path};
+
+	// another task may have finished it between listing and queueing
+	if (!QFile::exists(path))
+		return;
+	QFile in(path);
+	if (!in.open(QIODevice::ReadOnly))
+	{
+		QLOG_WARN() << "Unable to open log segment" << path << "for compression";
+		return;
+	}
+	// written under a temporary name, so a half written file never looks finished
+	const QString partPath = path + ".gz.part";
+	QuaGzipFile out(partPath);
+	if (!out.open(QIODevice::WriteOnly))
+	{
+		QLOG_WARN() << "Unable to create compressed log segment" << partPath;
+		return;
+	}
+	while (!in.atEnd())
+	{
+		const QByteArray chunk = in.read(64 * 1024);
+		if (out.write(chunk) != chunk.size())
+		{
+			QLOG_WARN() << "Unable to compress log segment" << path;
+			out.close();
+			QFile::remove(partPath);
+			return;
+		}
+	}
+	out.close();
+	in.close();
+	QFile::remove(path + ".gz");
+	if (!QFile::rename(partPath, path + ".gz"))
+	{
+		QLOG_WARN() << "Unable to rename compressed log segment" << partPath;
+		QFile::remove(partPath);
+		return;
+	}
+	QFile::remove(path);
+}
+
+// compress the segment on the thread pool, unless that is already happening
+static void queueCompression(const QString &path)
+{
+	{
+		QMutexLocker locker(&compressingLock);
+		if (compressing.contains(path))
+			return;
+		compressing.insert(path);
+	}
+	QtConcurrent::run(compressSegment, path);
+}
+
+RotatingLogFile::RotatingLogFile(const QString &dir, qint64 maxSegmentSize, int keepLaunches,
+								 QObject *parent)
+	: QObject(parent), m_dir(dir), m_maxSegmentSize(maxSegmentSize),
+	  m_keepLaunches(qMax(1, keepLaunches)), m_file(this)
+{
+}
+
+RotatingLogFile::~RotatingLogFile()
+{
+	close();
+}
+
+bool RotatingLogFile::open()
+{
+	if (!ensureFolderPathExists(m_dir))
+	{
+		QLOG_ERROR() << "Unable to create the log folder" << m_dir;
+		return false;
+	}
+	if (m_baseName.isEmpty())
+	{
+		m_baseName = "launch-" + QDateTime::currentDateTime().toString("yyyy-MM-dd_HH-mm-ss");
+		removeOldLaunches();
+	}
+	m_file.setFileName(PathCombine(m_dir, m_baseName + ".log"));
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		QLOG_ERROR() << "Unable to open the log file" << m_file.fileName() << ":"
+					 << m_file.errorString();
+		return false;
+	}
+	return true;
+}
+
+void RotatingLogFile::removeOldLaunches()
+{
+	QDir dir(m_dir);
+	// the names start with the launch time, so they sort from oldest to newest
+	QStringList files = dir.entryList(QStringList() << "launch-*", QDir::Files, QDir::Name);
+	QStringList launches;
+	QRegularExpression segmentName("\\.log(\\.[0-9]+)?(\\.gz)?(\\.part)?$");
+	for (auto &file : files)
+	{
+		QString launch = file.left(file.indexOf(segmentName));
+		if (launches.isEmpty() || launches.last() != launch)
+			launches.append(launch);
+	}
+	// the new launch counts too
+	const int toRemove = launches.size() - (m_keepLaunches - 1);
+	for (int i = 0; i < toRemove; i++)
+	{
+		for (auto &file : dir.entryList(QStringList() << launches[i] + ".log*", QDir::Files))
+		{
+			dir.remove(file);
+		}
+	}
+	// segments left uncompressed when MultiMC quit before it could finish
+	QRegularExpression unfinishedSegment("\\.log\\.[0-9]+$");
+	for (auto &file : dir.entryList(QStringList() << "launch-*.log.*", QDir::Files))
+	{
+		if (file.contains(unfinishedSegment))
+			queueCompression(dir.absoluteFilePath(file));
+	}
+}
+
+void RotatingLogFile::rotate()
+{
+	m_file.close();
+	m_segment++;
+	const QString segmentPath = m_file.fileName() + "." + QString::number(m_segment);
+	QFile::remove(segmentPath);
+	if (!QFile::rename(m_file.fileName(), segmentPath))
+	{
+		QLOG_WARN() << "Unable to rotate the log file" << m_file.fileName();
+		// keep writing to the same file instead of losing the log
+		m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+		return;
+	}
+	queueCompression(segmentPath);
+	m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+void RotatingLogFile::write(LogBlock lines)
+{
+	if (m_failed)
+		return;
+	if (!m_file.isOpen() && !open())
+	{
+		// don't try again for every batch
+		m_failed = true;
+		return;
+	}
+
+	QByteArray out;
+	for (auto &line : lines)
+	{
+		out += '[';
+		out += LogProcessor::levelName(line.level).toUtf8();
+		out += "] ";
+		out += line.text.toUtf8();
+		out += '\n';
+	}
+	m_file.write(out);
+	// written right away, so the log survives a crash of MultiMC itself
+	m_file.flush();
+
+	if (m_file.size() >= m_maxSegmentSize)
+		rotate();
+}
+
+void RotatingLogFile::close()
+{
+	if (m_file.isOpen())
+		m_file.close();
+}
@@ -0,0 +1,63 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QFile>
+#include <QDateTime>
+
+#include "logic/LogProcessor.h"
+
+/**
+ * @brief Writes the log of one launch to disk.
+ *
+ * The log goes to launch-<time>.log in the given folder. When that grows past the segment
+ * size, it is renamed to launch-<time>.log.<n> and gzipped on the thread pool, and a new
+ * launch-<time>.log is started. Only the logs of the last few launches are kept.
+ */
+class RotatingLogFile : public QObject
+{
+	Q_OBJECT
+public:
+	explicit RotatingLogFile(const QString &dir, qint64 maxSegmentSize = 10 * 1024 * 1024,
+							 int keepLaunches = 5, QObject *parent = 0);
+	virtual ~RotatingLogFile();
+
+	/// the file currently written to. Empty until the first lines arrive.
+	QString fileName() const
+	{
+		return m_file.fileName();
+	}
+
+public
+slots:
+	void write(LogBlock lines);
+	void close();
+
+private:
+	bool open();
+	void rotate();
+	void removeOldLaunches();
+
+private:
+	QString m_dir;
+	QString m_baseName;
+	qint64 m_maxSegmentSize;
+	int m_keepLaunches;
+	QFile m_file;
+	int m_segment = 0;
+	bool m_failed = false;
+};
@@ -19,9 +19,14 @@
 #include "logic/net/URLConstants.h"
 #include "MultiMC.h"
 
+#include <pathutils.h>
+
 #include <QtNetwork>
 #include <QtXml>
 #include <QRegExp>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QtConcurrentRun>
 
 #include "logger/QsLog.h"
 
@@ -142,6 +147,7 @@ void ForgeVersionList::updateListData(QList<BaseVersionPtr> versions)
 	beginResetModel();
 	m_vlist = versions;
 	m_loaded = true;
+	rebuildLookup();
 	endResetModel();
 	// NOW SORT!!
 	// sort();
@@ -155,6 +161,7 @@ void ForgeVersionList::sort()
 ForgeListLoadTask::ForgeListLoadTask(ForgeVersionList *vlist) : Task()
 {
 	m_list = vlist;
+	connect(&m_parseWatcher, SIGNAL(finished()), SLOT(parseFinished()));
 }
 
 void ForgeListLoadTask::executeTask()
@@ -162,17 +169,17 @@ void ForgeListLoadTask::executeTask()
 	setStatus(tr("Fetching Forge version lists..."));
 	auto job = new NetJob("Version index");
 	// we do not care if the version is stale or not.
-	auto forgeListEntry = MMC->metacache()->resolveEntry("minecraftforge", "list.json");
-	auto gradleForgeListEntry = MMC->metacache()->resolveEntry("minecraftforge", "json");
+	listEntry = MMC->metacache()->resolveEntry("minecraftforge", "list.json");
+	gradleListEntry = MMC->metacache()->resolveEntry("minecraftforge", "json");
 
 	// verify by poking the server.
-	forgeListEntry->stale = true;
-	gradleForgeListEntry->stale = true;
+	listEntry->stale = true;
+	gradleListEntry->stale = true;
 
 	job->addNetAction(listDownload = CacheDownload::make(QUrl(URLConstants::FORGE_LEGACY_URL),
-														 forgeListEntry));
+														 listEntry));
 	job->addNetAction(gradleListDownload = CacheDownload::make(
-						  QUrl(URLConstants::FORGE_GRADLE_URL), gradleForgeListEntry));
+						  QUrl(URLConstants::FORGE_GRADLE_URL), gradleListEntry));
 
 	connect(listDownload.get(), SIGNAL(failed(int)), SLOT(listFailed()));
 	connect(gradleListDownload.get(), SIGNAL(failed(int)), SLOT(gradleListFailed()));
@@ -183,33 +190,21 @@ void ForgeListLoadTask::executeTask()
 	listJob->start();
 }
 
-bool ForgeListLoadTask::parseForgeList(QList<BaseVersionPtr> &out)
+bool ForgeListLoadTask::parseForgeList(const QByteArray &data, QList<BaseVersionPtr> &out,
+									   QString &error)
 {
-	QByteArray data;
-	{
-		auto dlJob = listDownload;
-		auto filename = std::dynamic_pointer_cast<CacheDownload>(dlJob)->getTargetFilepath();
-		QFile listFile(filename);
-		if (!listFile.open(QIODevice::ReadOnly))
-		{
-			return false;
-		}
-		data = listFile.readAll();
-		dlJob.reset();
-	}
-
 	QJsonParseError jsonError;
 	QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &jsonError);
 
 	if (jsonError.error != QJsonParseError::NoError)
 	{
-		emitFailed("Error parsing version list JSON:" + jsonError.errorString());
+		error = "Error parsing version list JSON:" + jsonError.errorString();
 		return false;
 	}
 
 	if (!jsonDoc.isObject())
 	{
-		emitFailed("Error parsing version list JSON: JSON root is not an object");
+		error = "Error parsing version list JSON: JSON root is not an object";
 		return false;
 	}
 
@@ -218,8 +213,7 @@ bool ForgeListLoadTask::parseForgeList(QList<BaseVersionPtr> &out)
 	// Now, get the array of versions.
 	if (!root.value("builds").isArray())
 	{
-		emitFailed(
-			"Error parsing version list JSON: version list object is missing 'builds' array");
+		error = "Error parsing version list JSON: version list object is missing 'builds' array";
 		return false;
 	}
 	QJsonArray builds = root.value("builds").toArray();
@@ -294,33 +288,21 @@ bool ForgeListLoadTask::parseForgeList(QList<BaseVersionPtr> &out)
 	return true;
 }
 
-bool ForgeListLoadTask::parseForgeGradleList(QList<BaseVersionPtr> &out)
+bool ForgeListLoadTask::parseForgeGradleList(const QByteArray &data, QList<BaseVersionPtr> &out,
+											 QString &error)
 {
-	QByteArray data;
-	{
-		auto dlJob = gradleListDownload;
-		auto filename = std::dynamic_pointer_cast<CacheDownload>(dlJob)->getTargetFilepath();
-		QFile listFile(filename);
-		if (!listFile.open(QIODevice::ReadOnly))
-		{
-			return false;
-		}
-		data = listFile.readAll();
-		dlJob.reset();
-	}
-
 	QJsonParseError jsonError;
 	QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &jsonError);
 
 	if (jsonError.error != QJsonParseError::NoError)
 	{
-		emitFailed("Error parsing gradle version list JSON:" + jsonError.errorString());
+		error = "Error parsing gradle version list JSON:" + jsonError.errorString();
 		return false;
 	}
 
 	if (!jsonDoc.isObject())
 	{
-		emitFailed("Error parsing gradle version list JSON: JSON root is not an object");
+		error = "Error parsing gradle version list JSON: JSON root is not an object";
 		return false;
 	}
 
@@ -406,30 +388,162 @@ bool ForgeListLoadTask::parseForgeGradleList(QList<BaseVersionPtr> &out)
 	return true;
 }
 
-void ForgeListLoadTask::listDownloaded()
+namespace
+{
+// bump when the cached fields change
+const quint32 CACHE_MAGIC = 0x4d4d4346;
+const quint32 CACHE_VERSION = 1;
+
+bool readFile(const QString &path, QByteArray &data)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	data = file.readAll();
+	return true;
+}
+}
+
+bool ForgeListLoadTask::readCache(QString cachePath, QString cacheKey,
+								  QList<BaseVersionPtr> &out)
+{
+	QFile file(cachePath);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_1);
+	quint32 magic, version;
+	QString key;
+	in >> magic >> version >> key;
+	if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+		key != cacheKey)
+	{
+		return false;
+	}
+	quint32 count;
+	in >> count;
+	QList<BaseVersionPtr> versions;
+	for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+	{
+		std::shared_ptr<ForgeVersion> fVersion(new ForgeVersion());
+		qint32 type, buildnr;
+		in >> type >> buildnr >> fVersion->branch >> fVersion->universal_url >>
+			fVersion->changelog_url >> fVersion->installer_url >> fVersion->jobbuildver >>
+			fVersion->mcver >> fVersion->mcver_sane >> fVersion->universal_filename >>
+			fVersion->installer_filename >> fVersion->is_recommended;
+		fVersion->type = type == ForgeVersion::Gradle ? ForgeVersion::Gradle : ForgeVersion::Legacy;
+		fVersion->m_buildnr = buildnr;
+		versions.append(fVersion);
+	}
+	// a truncated cache is as good as none
+	if (in.status() != QDataStream::Ok)
+	{
+		return false;
+	}
+	out = versions;
+	return true;
+}
+
+bool ForgeListLoadTask::writeCache(QString cachePath, QString cacheKey,
+								   const QList<BaseVersionPtr> &versions)
 {
-	QList<BaseVersionPtr> list;
-	bool ret = true;
-	if (!parseForgeList(list))
+	QSaveFile file(cachePath);
+	if (!file.open(QIODevice::WriteOnly))
 	{
-		ret = false;
+		return false;
+	}
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_1);
+	out << CACHE_MAGIC << CACHE_VERSION << cacheKey << quint32(versions.size());
+	for (auto &version : versions)
+	{
+		auto fVersion = std::dynamic_pointer_cast<ForgeVersion>(version);
+		out << qint32(fVersion->type) << qint32(fVersion->m_buildnr) << fVersion->branch
+			<< fVersion->universal_url << fVersion->changelog_url << fVersion->installer_url
+			<< fVersion->jobbuildver << fVersion->mcver << fVersion->mcver_sane
+			<< fVersion->universal_filename << fVersion->installer_filename
+			<< fVersion->is_recommended;
 	}
-	if (!parseForgeGradleList(list))
+	if (out.status() != QDataStream::Ok)
 	{
-		ret = false;
+		file.cancelWriting();
+		return false;
 	}
+	return file.commit();
+}
 
-	if (!ret)
+ForgeListLoadTask::ParseResult ForgeListLoadTask::parseLists(QString listPath,
+															 QString gradleListPath,
+															 QString cachePath, QString cacheKey)
+{
+	ParseResult result;
+	if (readCache(cachePath, cacheKey, result.versions))
 	{
-		return;
+		result.fromCache = true;
+		return result;
 	}
-	std::sort(list.begin(), list.end(), [](const BaseVersionPtr & l, const BaseVersionPtr & r)
-	{ return (*l > *r); });
 
-	m_list->updateListData(list);
+	QByteArray data;
+	if (!readFile(listPath, data))
+	{
+		result.error = "Error opening " + listPath;
+		return result;
+	}
+	if (!parseForgeList(data, result.versions, result.error))
+	{
+		return result;
+	}
+	if (!readFile(gradleListPath, data))
+	{
+		result.error = "Error opening " + gradleListPath;
+		return result;
+	}
+	if (!parseForgeGradleList(data, result.versions, result.error))
+	{
+		return result;
+	}
+	ForgeVersionList::sortDescending(result.versions, [](const BaseVersionPtr &version)
+	{ return std::dynamic_pointer_cast<ForgeVersion>(version)->m_buildnr; });
 
+	if (!writeCache(cachePath, cacheKey, result.versions))
+	{
+		QLOG_WARN() << "Couldn't write the forge version list cache to" << cachePath;
+	}
+	return result;
+}
+
+void ForgeListLoadTask::listDownloaded()
+{
+	setStatus(tr("Reading Forge version lists..."));
+	// the etags come from the server, the md5 sums cover servers that don't send any
+	QString cacheKey = QStringList({listEntry->etag, listEntry->md5sum, gradleListEntry->etag,
+									gradleListEntry->md5sum}).join('\n');
+	QString cachePath =
+		PathCombine(MMC->metacache()->getBasePath("minecraftforge"), "versions.dat");
+	m_parseWatcher.setFuture(QtConcurrent::run(&ForgeListLoadTask::parseLists,
+											   listDownload->getTargetFilepath(),
+											   gradleListDownload->getTargetFilepath(),
+											   cachePath, cacheKey));
+}
+
+void ForgeListLoadTask::parseFinished()
+{
+	auto result = m_parseWatcher.result();
+	if (!result.error.isEmpty())
+	{
+		emitFailed(result.error);
+		return;
+	}
+	if (result.fromCache)
+	{
+		QLOG_INFO() << "Forge version lists unchanged, using the cached versions";
+	}
+	m_list->updateListData(result.versions);
 	emitSucceeded();
-	return;
 }
 
 void ForgeListLoadTask::listFailed()
@@ -19,6 +19,7 @@
 #include <QAbstractListModel>
 #include <QUrl>
 #include <QNetworkReply>
+#include <QFutureWatcher>
 
 #include "logic/BaseVersionList.h"
 #include "logic/tasks/Task.h"
@@ -66,9 +67,26 @@ public:
 
 	virtual void executeTask();
 
+	/// what the parser thread ended with
+	struct ParseResult
+	{
+		QList<BaseVersionPtr> versions;
+		QString error;
+		bool fromCache = false;
+	};
+	/**
+	 * Turns the two downloaded lists into sorted versions.
+	 * If the binary cache at cachePath was made from lists matching cacheKey, it is used
+	 * instead of the JSON. Otherwise the JSON is parsed and the cache rewritten.
+	 * Doesn't touch any objects, so it can run on any thread.
+	 */
+	static ParseResult parseLists(QString listPath, QString gradleListPath, QString cachePath,
+								  QString cacheKey);
+
 protected
 slots:
 	void listDownloaded();
+	void parseFinished();
 	void listFailed();
 	void gradleListFailed();
 
@@ -78,8 +96,17 @@ protected:
 
 	CacheDownloadPtr listDownload;
 	CacheDownloadPtr gradleListDownload;
+	MetaEntryPtr listEntry;
+	MetaEntryPtr gradleListEntry;
+
+	QFutureWatcher<ParseResult> m_parseWatcher;
 
 private:
-	bool parseForgeList(QList<BaseVersionPtr> &out);
-	bool parseForgeGradleList(QList<BaseVersionPtr> &out);
+	static bool parseForgeList(const QByteArray &data, QList<BaseVersionPtr> &out,
+							   QString &error);
+	static bool parseForgeGradleList(const QByteArray &data, QList<BaseVersionPtr> &out,
+									 QString &error);
+	static bool readCache(QString cachePath, QString cacheKey, QList<BaseVersionPtr> &out);
+	static bool writeCache(QString cachePath, QString cacheKey,
+						   const QList<BaseVersionPtr> &versions);
 };
@@ -21,17 +21,263 @@
 #include <QFileInfo>
 #include <QDateTime>
 #include <QDir>
+#include <QSaveFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QAtomicInt>
 #include "logger/QsLog.h"
 
+#include "xz.h"
+#include "unpack200.h"
+#include <stdexcept>
+
+/**
+ * Hands the downloaded .pack.xz from the network reply to the unpacker thread.
+ * Chunks are queued as they arrive, the unpacker blocks until there is more.
+ */
+class XzPack200Pipe
+{
+public:
+	/// queue a chunk, dropped if the unpacker already gave up
+	void push(const QByteArray &data)
+	{
+		QMutexLocker locker(&m_lock);
+		if (m_closed || m_abandoned)
+			return;
+		m_chunks.append(data);
+		m_cond.wakeAll();
+	}
+	/// no more data is coming. aborted means the download failed
+	void close(bool aborted)
+	{
+		QMutexLocker locker(&m_lock);
+		m_closed = true;
+		m_aborted = aborted;
+		m_cond.wakeAll();
+	}
+	/// the unpacker is done with the pipe, stop queueing data
+	void abandon()
+	{
+		QMutexLocker locker(&m_lock);
+		m_abandoned = true;
+		m_chunks.clear();
+	}
+	/// wait for the next chunk. false when there are no more
+	bool take(QByteArray &data)
+	{
+		QMutexLocker locker(&m_lock);
+		while (m_chunks.isEmpty() && !m_closed)
+			m_cond.wait(&m_lock);
+		if (m_aborted)
+			throw std::runtime_error("download aborted");
+		if (m_chunks.isEmpty())
+			return false;
+		data = m_chunks.takeFirst();
+		return true;
+	}
+
+private:
+	QMutex m_lock;
+	QWaitCondition m_cond;
+	QList<QByteArray> m_chunks;
+	bool m_closed = false;
+	bool m_aborted = false;
+	bool m_abandoned = false;
+};
+
+namespace
+{
+/// de-xz the pipe contents as the unpacker asks for them
+class XzInput : public unpack200_input
+{
+public:
+	XzInput(std::shared_ptr<XzPack200Pipe> pipe) : m_pipe(pipe)
+	{
+		m_dec = xz_dec_init(XZ_DYNALLOC, 1 << 26);
+		m_buf.in = nullptr;
+		m_buf.in_pos = 0;
+		m_buf.in_size = 0;
+	}
+	virtual ~XzInput()
+	{
+		xz_dec_end(m_dec);
+	}
+	virtual int64_t read(void *buf, int64_t minlen, int64_t maxlen)
+	{
+		if (!m_dec)
+			throw std::runtime_error("Memory allocation failed");
+		m_buf.out = (uint8_t *)buf;
+		m_buf.out_pos = 0;
+		m_buf.out_size = maxlen;
+		while (!m_ended && (int64_t)m_buf.out_pos < minlen)
+		{
+			if (m_buf.in_pos == m_buf.in_size)
+			{
+				if (!m_pipe->take(m_in))
+					break;
+				m_buf.in = (const uint8_t *)m_in.constData();
+				m_buf.in_pos = 0;
+				m_buf.in_size = m_in.size();
+			}
+			switch (xz_dec_run(m_dec, &m_buf))
+			{
+			case XZ_OK:
+			// unsupported check. this is OK, the data is still fine
+			case XZ_UNSUPPORTED_CHECK:
+				continue;
+			case XZ_STREAM_END:
+				m_ended = true;
+				break;
+			case XZ_MEM_ERROR:
+				throw std::runtime_error("Memory allocation failed");
+			case XZ_MEMLIMIT_ERROR:
+				throw std::runtime_error("Memory usage limit reached");
+			case XZ_FORMAT_ERROR:
+				throw std::runtime_error("Not a .xz file");
+			case XZ_OPTIONS_ERROR:
+				throw std::runtime_error("Unsupported options in the .xz headers");
+			case XZ_DATA_ERROR:
+			case XZ_BUF_ERROR:
+				throw std::runtime_error("File is corrupt");
+			default:
+				throw std::runtime_error("Bug!");
+			}
+		}
+		return m_buf.out_pos;
+	}
+
+private:
+	std::shared_ptr<XzPack200Pipe> m_pipe;
+	struct xz_dec *m_dec;
+	struct xz_buf m_buf;
+	QByteArray m_in;
+	bool m_ended = false;
+};
+
+/// write the jar, hashing it on the way
+class HashingJarOutput : public unpack200_output
+{
+public:
+	HashingJarOutput(QString path) : m_file(path), m_md5(QCryptographicHash::Md5)
+	{
+	}
+	bool open()
+	{
+		return m_file.open(QIODevice::WriteOnly);
+	}
+	virtual bool write(const void *buf, size_t len)
+	{
+		m_md5.addData((const char *)buf, len);
+		return m_file.write((const char *)buf, len) == (qint64)len;
+	}
+	QSaveFile m_file;
+	QCryptographicHash m_md5;
+};
+
+/**
+ * Splits the compressor threads between the unpacks that run at the same time.
+ * Unpacks that start while others run get a share of the cores instead of all of them.
+ */
+class CompressorBudget
+{
+public:
+	CompressorBudget()
+	{
+		int running = s_running.fetchAndAddOrdered(1) + 1;
+		threads = qMax(1, QThread::idealThreadCount() / running);
+	}
+	~CompressorBudget()
+	{
+		s_running.fetchAndAddOrdered(-1);
+	}
+	int threads;
+
+private:
+	static QAtomicInt s_running;
+};
+QAtomicInt CompressorBudget::s_running;
+
+ForgeXzDownload::UnpackResult unpackStream(std::shared_ptr<XzPack200Pipe> pipe, QString target)
+{
+	ForgeXzDownload::UnpackResult result;
+	CompressorBudget budget;
+	HashingJarOutput output(target);
+	if (!output.open())
+	{
+		result.error = "Error opening " + target;
+		pipe->abandon();
+		return result;
+	}
+	try
+	{
+		XzInput input(pipe);
+		// the jar only gets read locally. compress fast, on the cores this unpack gets
+		unpack200_options options;
+		options.deflate_level = 1;
+		options.threads = budget.threads;
+		unpack_200(input, output, options);
+	}
+	catch (std::runtime_error &err)
+	{
+		result.error = err.what();
+		output.m_file.cancelWriting();
+		pipe->abandon();
+		return result;
+	}
+	pipe->abandon();
+	if (!output.m_file.commit())
+	{
+		result.error = "Error writing " + target;
+		return result;
+	}
+	result.md5sum = output.m_md5.result().toHex().constData();
+	result.ok = true;
+	return result;
+}
+}
+
+/**
+ * Runs one unpacker. It spends most of its time waiting for the network, so it gets a thread
+ * of its own instead of holding on to one from the global thread pool.
+ */
+class XzUnpackThread : public QThread
+{
+public:
+	XzUnpackThread(std::shared_ptr<XzPack200Pipe> pipe, QString target)
+		: m_pipe(pipe), m_target(target)
+	{
+		connect(this, SIGNAL(finished()), SLOT(deleteLater()));
+	}
+	ForgeXzDownload::UnpackResult result;
+
+protected:
+	virtual void run()
+	{
+		result = unpackStream(m_pipe, m_target);
+		m_pipe.reset();
+	}
+
+private:
+	std::shared_ptr<XzPack200Pipe> m_pipe;
+	QString m_target;
+};
+
 ForgeXzDownload::ForgeXzDownload(QString relative_path, MetaEntryPtr entry) : NetAction()
 {
 	m_entry = entry;
 	m_target_path = entry->getFullPath();
-	m_pack200_xz_file.setFileTemplate("./dl_temp.XXXXXX");
 	m_status = Job_NotStarted;
 	m_url_path = relative_path;
 }
 
+ForgeXzDownload::~ForgeXzDownload()
+{
+	// the unpacker thread holds on to the pipe, let it wind down on its own
+	if (m_pipe)
+		m_pipe->close(true);
+}
+
 void ForgeXzDownload::setMirrors(QList<ForgeMirror> &mirrors)
 {
 	m_mirror_index = 0;
@@ -61,6 +307,9 @@ void ForgeXzDownload::start()
 		emit failed(m_index_within_job);
 		return;
 	}
+	m_pipe.reset();
+	m_download_done = false;
+	m_unpack_done = false;
 
 	QLOG_INFO() << "Downloading " << m_url.toString();
 	QNetworkRequest request(m_url);
@@ -88,8 +337,8 @@ void ForgeXzDownload::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 
 void ForgeXzDownload::downloadError(QNetworkReply::NetworkError error)
 {
-	// error happened during download.
-	// TODO: log the reason why
+	QLOG_ERROR() << "Error" << error << ":" << m_reply->errorString() << "while downloading"
+				 << m_reply->url();
 	m_status = Job_Failed;
 }
 
@@ -117,273 +366,115 @@ void ForgeXzDownload::updateUrl()
 	m_url = QUrl(aggregate);
 }
 
-void ForgeXzDownload::downloadFinished()
+void ForgeXzDownload::startUnpacking()
 {
-	//TEST: defer to other possible mirrors (autofail the first one)
-	/*
-	QLOG_INFO() <<"dl " << index_within_job << " mirror " << m_mirror_index;
-	if( m_mirror_index == 0)
+	static bool xz_initialized = false;
+	if (!xz_initialized)
 	{
-		QLOG_INFO() <<"dl " << index_within_job << " AUTOFAIL";
-		m_status = Job_Failed;
-		m_pack200_xz_file.close();
-		m_pack200_xz_file.remove();
-		m_reply.reset();
-		failAndTryNextMirror();
-		return;
+		xz_crc32_init();
+		xz_crc64_init();
+		xz_initialized = true;
 	}
-	*/
+	m_pipe = std::make_shared<XzPack200Pipe>();
+	m_unpack_thread = new XzUnpackThread(m_pipe, m_target_path);
+	connect(m_unpack_thread, SIGNAL(finished()), SLOT(unpackFinished()));
+	m_unpack_thread->start();
+}
 
-	// if the download succeeded
-	if (m_status != Job_Failed)
+void ForgeXzDownload::downloadFinished()
+{
+	m_download_done = true;
+	if (!m_pipe)
 	{
-		// nothing went wrong...
-		m_status = Job_Finished;
-		if (m_pack200_xz_file.isOpen())
-		{
-			// we actually downloaded something! process and isntall it
-			decompressAndInstall();
-			return;
-		}
-		else
-		{
-			// something bad happened -- on the local machine!
-			m_status = Job_Failed;
-			m_pack200_xz_file.remove();
-			m_reply.reset();
-			emit failed(m_index_within_job);
-			return;
-		}
+		// nothing to unpack. either it failed or something bad happened -- on the local machine!
+		m_unpack_done = true;
 	}
-	// else the download failed
 	else
 	{
-		m_status = Job_Failed;
-		m_pack200_xz_file.close();
-		m_pack200_xz_file.remove();
-		m_reply.reset();
-		failAndTryNextMirror();
-		return;
+		m_pipe->close(m_status == Job_Failed);
 	}
+	finishIfDone();
 }
 
 void ForgeXzDownload::downloadReadyRead()
 {
-
-	if (!m_pack200_xz_file.isOpen())
+	if (!m_pipe)
 	{
-		if (!m_pack200_xz_file.open())
+		// don't feed error pages to the unpacker
+		int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+		if (status != 200)
 		{
-			/*
-			* Can't open the file... the job failed
-			*/
-			m_reply->abort();
-			emit failed(m_index_within_job);
+			m_reply->readAll();
 			return;
 		}
+		startUnpacking();
 	}
-	m_pack200_xz_file.write(m_reply->readAll());
+	m_pipe->push(m_reply->readAll());
 }
 
-#include "xz.h"
-#include "unpack200.h"
-#include <stdexcept>
-
-const size_t buffer_size = 8196;
-
-void ForgeXzDownload::decompressAndInstall()
+void ForgeXzDownload::unpackFinished()
 {
-	// rewind the downloaded temp file
-	m_pack200_xz_file.seek(0);
-	// de-xz'd file
-	QTemporaryFile pack200_file("./dl_temp.XXXXXX");
-	pack200_file.open();
-
-	bool xz_success = false;
-	// first, de-xz
+	m_unpack_result = m_unpack_thread->result;
+	m_unpack_thread = nullptr;
+	m_unpack_done = true;
+	if (!m_download_done)
 	{
-		uint8_t in[buffer_size];
-		uint8_t out[buffer_size];
-		struct xz_buf b;
-		struct xz_dec *s;
-		enum xz_ret ret;
-		xz_crc32_init();
-		xz_crc64_init();
-		s = xz_dec_init(XZ_DYNALLOC, 1 << 26);
-		if (s == nullptr)
+		auto &result = m_unpack_result;
+		if (!result.ok)
 		{
-			xz_dec_end(s);
-			failAndTryNextMirror();
-			return;
-		}
-		b.in = in;
-		b.in_pos = 0;
-		b.in_size = 0;
-		b.out = out;
-		b.out_pos = 0;
-		b.out_size = buffer_size;
-		while (!xz_success)
-		{
-			if (b.in_pos == b.in_size)
-			{
-				b.in_size = m_pack200_xz_file.read((char *)in, sizeof(in));
-				b.in_pos = 0;
-			}
-
-			ret = xz_dec_run(s, &b);
-
-			if (b.out_pos == sizeof(out))
-			{
-				if (pack200_file.write((char *)out, b.out_pos) != b.out_pos)
-				{
-					// msg = "Write error\n";
-					xz_dec_end(s);
-					failAndTryNextMirror();
-					return;
-				}
-
-				b.out_pos = 0;
-			}
-
-			if (ret == XZ_OK)
-				continue;
-
-			if (ret == XZ_UNSUPPORTED_CHECK)
-			{
-				// unsupported check. this is OK, but we should log this
-				continue;
-			}
-
-			if (pack200_file.write((char *)out, b.out_pos) != b.out_pos)
-			{
-				// write error
-				pack200_file.close();
-				xz_dec_end(s);
-				return;
-			}
-
-			switch (ret)
-			{
-			case XZ_STREAM_END:
-				xz_dec_end(s);
-				xz_success = true;
-				break;
-
-			case XZ_MEM_ERROR:
-				QLOG_ERROR() << "Memory allocation failed\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_MEMLIMIT_ERROR:
-				QLOG_ERROR() << "Memory usage limit reached\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_FORMAT_ERROR:
-				QLOG_ERROR() << "Not a .xz file\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_OPTIONS_ERROR:
-				QLOG_ERROR() << "Unsupported options in the .xz headers\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_DATA_ERROR:
-			case XZ_BUF_ERROR:
-				QLOG_ERROR() << "File is corrupt\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			default:
-				QLOG_ERROR() << "Bug!\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-			}
+			// the unpacker gave up early, no point in downloading the rest
+			QLOG_ERROR() << "Error unpacking " << m_url.toString() << " : " << result.error;
+			m_status = Job_Failed;
+			m_reply->abort();
 		}
-	}
-	m_pack200_xz_file.remove();
-
-	// revert pack200
-	pack200_file.seek(0);
-	int handle_in = pack200_file.handle();
-	// FIXME: dispose of file handles, pointers and the like. Ideally wrap in objects.
-	if(handle_in == -1)
-	{
-		QLOG_ERROR() << "Error reopening " << pack200_file.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	FILE * file_in = fdopen(handle_in,"r");
-	if(!file_in)
-	{
-		QLOG_ERROR() << "Error reopening " << pack200_file.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	QFile qfile_out(m_target_path);
-	if(!qfile_out.open(QIODevice::WriteOnly))
-	{
-		QLOG_ERROR() << "Error opening " << qfile_out.fileName();
-		failAndTryNextMirror();
 		return;
 	}
-	int handle_out = qfile_out.handle();
-	if(handle_out == -1)
+	finishIfDone();
+}
+
+void ForgeXzDownload::adoptTransfer(NetActionPtr other)
+{
+	auto winner = std::dynamic_pointer_cast<ForgeXzDownload>(other);
+	if (winner && winner->m_entry != m_entry)
 	{
-		QLOG_ERROR() << "Error opening " << qfile_out.fileName();
-		failAndTryNextMirror();
-		return;
+		m_entry->adoptState(*winner->m_entry);
 	}
-	FILE * file_out = fdopen(handle_out,"w");
-	if(!file_out)
-	{
-		QLOG_ERROR() << "Error opening " << qfile_out.fileName();
-		failAndTryNextMirror();
+	NetAction::adoptTransfer(other);
+}
+
+void ForgeXzDownload::finishIfDone()
+{
+	if (!m_download_done || !m_unpack_done)
 		return;
-	}
-	try
+
+	UnpackResult result;
+	if (m_pipe)
 	{
-		unpack_200(file_in, file_out);
+		result = m_unpack_result;
+		m_pipe.reset();
 	}
-	catch (std::runtime_error &err)
+	else
 	{
-		m_status = Job_Failed;
-		QLOG_ERROR() << "Error unpacking " << pack200_file.fileName() << " : " << err.what();
-		QFile f(m_target_path);
-		if (f.exists())
-			f.remove();
-		failAndTryNextMirror();
-		return;
+		result.error = "nothing was downloaded";
 	}
-	pack200_file.remove();
-
-	QFile jar_file(m_target_path);
-
-	if (!jar_file.open(QIODevice::ReadOnly))
+	if (m_status == Job_Failed || !result.ok)
 	{
-		jar_file.remove();
+		if (m_status != Job_Failed)
+			QLOG_ERROR() << "Error unpacking " << m_url.toString() << " : " << result.error;
+		m_reply.reset();
 		failAndTryNextMirror();
 		return;
 	}
-	m_entry->md5sum = QCryptographicHash::hash(jar_file.readAll(), QCryptographicHash::Md5)
-						  .toHex()
-						  .constData();
-	jar_file.close();
 
 	QFileInfo output_file_info(m_target_path);
+	m_entry->md5sum = result.md5sum;
 	m_entry->etag = m_reply->rawHeader("ETag").constData();
 	m_entry->local_changed_timestamp =
 		output_file_info.lastModified().toUTC().toMSecsSinceEpoch();
 	m_entry->stale = false;
 	MMC->metacache()->updateEntry(m_entry);
 
+	m_status = Job_Finished;
 	m_reply.reset();
 	emit succeeded(m_index_within_job);
 }
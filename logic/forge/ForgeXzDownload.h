@@ -17,11 +17,11 @@
 
 #include "logic/net/NetAction.h"
 #include "logic/net/HttpMetaCache.h"
-#include <QFile>
-#include <QTemporaryFile>
 #include "ForgeMirror.h"
 
 typedef std::shared_ptr<class ForgeXzDownload> ForgeXzDownloadPtr;
+class XzPack200Pipe;
+class XzUnpackThread;
 
 class ForgeXzDownload : public NetAction
 {
@@ -30,8 +30,8 @@ public:
 	MetaEntryPtr m_entry;
 	/// if saving to file, use the one specified in this string
 	QString m_target_path;
-	/// this is the output file, if any
-	QTemporaryFile m_pack200_xz_file;
+	/// downloaded data on its way to the unpacker, if any
+	std::shared_ptr<XzPack200Pipe> m_pipe;
 	/// mirror index (NOT OPTICS, I SWEAR)
 	int m_mirror_index = 0;
 	/// list of mirrors to use. Mirror has the url base
@@ -45,22 +45,44 @@ public:
 	{
 		return ForgeXzDownloadPtr(new ForgeXzDownload(relative_path, entry));
 	}
-	virtual ~ForgeXzDownload(){};
+	virtual ~ForgeXzDownload();
 	void setMirrors(QList<ForgeMirror> & mirrors);
 
+	/// what the unpacker thread ended with
+	struct UnpackResult
+	{
+		bool ok = false;
+		QString md5sum;
+		QString error;
+	};
+	// the mirror used doesn't matter
+	virtual QString sharingKey() const
+	{
+		return m_url_path + '\n' + m_target_path;
+	}
+	virtual void adoptTransfer(NetActionPtr other);
+
 protected
 slots:
 	virtual void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 	virtual void downloadError(QNetworkReply::NetworkError error);
 	virtual void downloadFinished();
 	virtual void downloadReadyRead();
+	void unpackFinished();
 
 public
 slots:
 	virtual void start();
 
 private:
-	void decompressAndInstall();
+	void startUnpacking();
+	void finishIfDone();
 	void failAndTryNextMirror();
 	void updateUrl();
+
+	/// the running unpacker, if any. It deletes itself when done
+	XzUnpackThread *m_unpack_thread = nullptr;
+	UnpackResult m_unpack_result;
+	bool m_download_done = false;
+	bool m_unpack_done = false;
 };
@@ -21,13 +21,20 @@
 #include <QMimeData>
 #include <QUrl>
 #include <QFileSystemWatcher>
+#include <QImageReader>
 #include <MultiMC.h>
 #include <logic/settings/Setting.h>
 
 #define MAX_SIZE 1024
+// user icons bigger than this are only decoded once, to make a thumbnail of this size
+#define THUMBNAIL_SIZE 256
+// png text key of the stamp that saveIcon leaves in the files it writes
+#define ICON_STAMP_KEY "MultiMC-Icon"
 
 IconList::IconList(QObject *parent) : QAbstractListModel(parent)
 {
+	m_thumbnailDir.setPath(QDir("cache/icons").absolutePath());
+
 	// add builtin icons
 	QDir instance_icons(":/icons/instances/");
 	auto file_info_list = instance_icons.entryInfoList(QDir::Files, QDir::Name);
@@ -96,6 +103,7 @@ void IconList::directoryChanged(const QString &path)
 		if (idx == -1)
 			continue;
 		icons[idx].remove(MMCIcon::FileBased);
+		removeThumbnails(key);
 		if (icons[idx].type() == MMCIcon::ToBeDeleted)
 		{
 			beginRemoveRows(QModelIndex(), idx, idx);
@@ -134,11 +142,10 @@ void IconList::fileChanged(const QString &path)
 	int idx = getIconIndex(key);
 	if (idx == -1)
 		return;
-	QIcon icon(path);
-	if (!icon.availableSizes().size())
+	if (!QImageReader(path).canRead())
 		return;
 
-	icons[idx].m_images[MMCIcon::FileBased].icon = icon;
+	icons[idx].replace(MMCIcon::FileBased, path);
 	dataChanged(index(idx), index(idx));
 	emit iconUpdated(key);
 }
@@ -233,7 +240,7 @@ QVariant IconList::data(const QModelIndex &index, int role) const
 	switch (role)
 	{
 	case Qt::DecorationRole:
-		return icons[row].icon();
+		return decode(icons[row]);
 	case Qt::DisplayRole:
 		return icons[row].name();
 	case Qt::UserRole:
@@ -282,14 +289,14 @@ bool IconList::deleteIcon(QString key)
 bool IconList::addIcon(QString key, QString name, QString path, MMCIcon::Type type)
 {
 	// replace the icon even? is the input valid?
-	QIcon icon(path);
-	if (!icon.availableSizes().size())
+	// only the header is read here, the image itself is decoded when it is first used
+	if (!QImageReader(path).canRead())
 		return false;
 	auto iter = name_index.find(key);
 	if (iter != name_index.end())
 	{
 		auto &oldOne = icons[*iter];
-		oldOne.replace(type, icon, path);
+		oldOne.replace(type, path);
 		dataChanged(index(*iter), index(*iter));
 		return true;
 	}
@@ -301,7 +308,7 @@ bool IconList::addIcon(QString key, QString name, QString path, MMCIcon::Type ty
 			MMCIcon mmc_icon;
 			mmc_icon.m_name = name;
 			mmc_icon.m_key = key;
-			mmc_icon.replace(type, icon, path);
+			mmc_icon.replace(type, path);
 			icons.push_back(mmc_icon);
 			name_index[key] = icons.size() - 1;
 		}
@@ -326,31 +333,131 @@ QIcon IconList::getIcon(QString key)
 	int icon_index = getIconIndex(key);
 
 	if (icon_index != -1)
-		return icons[icon_index].icon();
+		return decode(icons[icon_index]);
 
 	// Fallback for icons that don't exist.
 	icon_index = getIconIndex("infinity");
 
 	if (icon_index != -1)
-		return icons[icon_index].icon();
+		return decode(icons[icon_index]);
 	return QIcon();
 }
 
 QIcon IconList::getBigIcon(QString key)
+{
+	QPixmap bigone = getPixmap(key, 256);
+	if (bigone.isNull())
+		return QIcon();
+	return QIcon(bigone);
+}
+
+QPixmap IconList::getPixmap(QString key, int size)
 {
 	int icon_index = getIconIndex(key);
 
+	// Fallback for icons that don't exist.
 	if (icon_index == -1)
-		key = "infinity";
+		icon_index = getIconIndex("infinity");
 
-	// Fallback for icons that don't exist.
-	icon_index = getIconIndex(key);
+	if (icon_index == -1)
+		return QPixmap();
+
+	const MMCImage &image = icons[icon_index].image();
+	auto iter = image.pixmaps.find(size);
+	if (iter != image.pixmaps.end())
+		return *iter;
 
+	QPixmap pixmap = decode(icons[icon_index]).pixmap(size, size);
+	if (!pixmap.isNull() && pixmap.size() != QSize(size, size))
+	{
+		pixmap = pixmap.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	}
+	image.pixmaps.insert(size, pixmap);
+	return pixmap;
+}
+
+bool IconList::saveIcon(QString key, QString path, int size)
+{
+	int icon_index = getIconIndex(key);
 	if (icon_index == -1)
+		icon_index = getIconIndex("infinity");
+	if (icon_index == -1)
+		return false;
+
+	// which file, and which version of it, the png was made from
+	const MMCImage &image = icons[icon_index].image();
+	const QString stamp = QString("%1 %2 %3 %4")
+							  .arg(icons[icon_index].m_key)
+							  .arg(size)
+							  .arg(image.changed.toMSecsSinceEpoch())
+							  .arg(image.filename);
+	// reading the text chunks does not decode the image
+	if (QFile::exists(path) && QImageReader(path).text(ICON_STAMP_KEY) == stamp)
+		return true;
+
+	QImage out = getPixmap(key, size).toImage();
+	out.setText(ICON_STAMP_KEY, stamp);
+	return out.save(path, "PNG");
+}
+
+QString IconList::thumbnailPath(const MMCIcon &icon) const
+{
+	// keys are file base names, so they never contain a dot
+	const MMCImage &image = icon.image();
+	return m_thumbnailDir.filePath(
+		QString("%1.%2.png").arg(icon.m_key).arg(image.changed.toMSecsSinceEpoch()));
+}
+
+void IconList::removeThumbnails(const QString &key) const
+{
+	for (auto thumbnail : m_thumbnailDir.entryList({key + ".*.png"}, QDir::Files))
+	{
+		QFile::remove(m_thumbnailDir.filePath(thumbnail));
+	}
+}
+
+QIcon IconList::decode(const MMCIcon &icon) const
+{
+	if (icon.type() == MMCIcon::ToBeDeleted)
 		return QIcon();
+	const MMCImage &image = icon.image();
+	if (!image.icon.isNull())
+		return image.icon;
 
-	QPixmap bigone = icons[icon_index].icon().pixmap(256,256).scaled(256,256);
-	return QIcon(bigone);
+	if (icon.type() != MMCIcon::FileBased)
+	{
+		image.icon = QIcon(image.filename);
+		return image.icon;
+	}
+
+	const QString thumbnail = thumbnailPath(icon);
+	if (QFile::exists(thumbnail))
+	{
+		image.icon = QIcon(thumbnail);
+		return image.icon;
+	}
+
+	QImageReader reader(image.filename);
+	const QSize size = reader.size();
+	if (size.width() > THUMBNAIL_SIZE || size.height() > THUMBNAIL_SIZE)
+	{
+		QImage full = reader.read();
+		if (!full.isNull())
+		{
+			QImage scaled = full.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio,
+										Qt::SmoothTransformation);
+			// the thumbnails of older versions of the file are useless now
+			removeThumbnails(icon.m_key);
+			if (ensureFolderPathExists(m_thumbnailDir.absolutePath()))
+			{
+				scaled.save(thumbnail, "PNG");
+			}
+			image.icon = QIcon(QPixmap::fromImage(scaled));
+			return image.icon;
+		}
+	}
+	image.icon = QIcon(image.filename);
+	return image.icon;
 }
 
 int IconList::getIconIndex(QString key)
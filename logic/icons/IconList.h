@@ -35,6 +35,10 @@ public:
 
 	QIcon getIcon(QString key);
 	QIcon getBigIcon(QString key);
+	/// the icon as a size x size pixmap. these are cached, so asking again is cheap
+	QPixmap getPixmap(QString key, int size);
+	/// write the icon to a png file, unless the file already holds this version of the icon
+	bool saveIcon(QString key, QString path, int size);
 	int getIconIndex(QString key);
 
 	virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
@@ -63,6 +67,10 @@ private:
 	// hide assign op
 	IconList &operator=(const IconList &) = delete;
 	void reindex();
+	/// the decoded icon. big user icons are decoded from a thumbnail made the first time
+	QIcon decode(const MMCIcon &icon) const;
+	QString thumbnailPath(const MMCIcon &icon) const;
+	void removeThumbnails(const QString &key) const;
 
 protected
 slots:
@@ -75,4 +83,5 @@ private:
 	QMap<QString, int> name_index;
 	QVector<MMCIcon> icons;
 	QDir m_dir;
+	QDir m_thumbnailDir;
 };
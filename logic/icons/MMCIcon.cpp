@@ -54,17 +54,14 @@ bool MMCIcon::has(MMCIcon::Type _type) const
 	return m_images[_type].present();
 }
 
-QIcon MMCIcon::icon() const
+const MMCImage &MMCIcon::image() const
 {
-	if (m_current_type == Type::ToBeDeleted)
-		return QIcon();
-	return m_images[m_current_type].icon;
+	return m_images[m_current_type];
 }
 
 void MMCIcon::remove(Type rm_type)
 {
-	m_images[rm_type].filename = QString();
-	m_images[rm_type].icon = QIcon();
+	m_images[rm_type] = MMCImage();
 	for (auto iter = rm_type; iter != Type::ToBeDeleted; iter--)
 	{
 		if (m_images[iter].present())
@@ -76,14 +73,15 @@ void MMCIcon::remove(Type rm_type)
 	m_current_type = Type::ToBeDeleted;
 }
 
-void MMCIcon::replace(MMCIcon::Type new_type, QIcon icon, QString path)
+void MMCIcon::replace(MMCIcon::Type new_type, QString path)
 {
 	QFileInfo foo(path);
 	if (new_type > m_current_type || m_current_type == MMCIcon::ToBeDeleted)
 	{
 		m_current_type = new_type;
 	}
-	m_images[new_type].icon = icon;
+	// drop whatever was decoded from the old file
+	m_images[new_type] = MMCImage();
 	m_images[new_type].changed = foo.lastModified();
 	m_images[new_type].filename = path;
 }
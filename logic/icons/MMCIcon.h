@@ -17,14 +17,19 @@
 #include <QString>
 #include <QDateTime>
 #include <QIcon>
+#include <QPixmap>
+#include <QMap>
 struct MMCImage
 {
-	QIcon icon;
 	QString filename;
 	QDateTime changed;
+	/// decoded on first use, see IconList::decode
+	mutable QIcon icon;
+	/// renderings of the icon, by size in pixels
+	mutable QMap<int, QPixmap> pixmaps;
 	bool present() const
 	{
-		return !icon.isNull();
+		return !filename.isEmpty();
 	}
 };
 
@@ -46,7 +51,8 @@ struct MMCIcon
 	Type type() const;
 	QString name() const;
 	bool has(Type _type) const;
-	QIcon icon() const;
+	/// the image currently in use. only valid if the type isn't ToBeDeleted
+	const MMCImage &image() const;
 	void remove(Type rm_type);
-	void replace(Type new_type, QIcon icon, QString path = QString());
+	void replace(Type new_type, QString path);
 };
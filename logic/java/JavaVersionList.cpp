@@ -150,6 +150,7 @@ void JavaVersionList::updateListData(QList<BaseVersionPtr> versions)
 	beginResetModel();
 	m_vlist = versions;
 	m_loaded = true;
+	rebuildLookup();
 	endResetModel();
 	// NOW SORT!!
 	// sort();
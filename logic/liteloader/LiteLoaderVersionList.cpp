@@ -54,17 +54,16 @@ int LiteLoaderVersionList::count() const
 	return m_vlist.count();
 }
 
-static bool cmpVersions(BaseVersionPtr first, BaseVersionPtr second)
+static int versionSortKey(BaseVersionPtr version)
 {
-	auto left = std::dynamic_pointer_cast<LiteLoaderVersion>(first);
-	auto right = std::dynamic_pointer_cast<LiteLoaderVersion>(second);
-	return left->timestamp > right->timestamp;
+	return std::dynamic_pointer_cast<LiteLoaderVersion>(version)->timestamp;
 }
 
 void LiteLoaderVersionList::sort()
 {
 	beginResetModel();
-	std::sort(m_vlist.begin(), m_vlist.end(), cmpVersions);
+	sortDescending(m_vlist, versionSortKey);
+	rebuildLookup();
 	endResetModel();
 }
 
@@ -86,7 +85,8 @@ void LiteLoaderVersionList::updateListData(QList<BaseVersionPtr> versions)
 	beginResetModel();
 	m_vlist = versions;
 	m_loaded = true;
-	std::sort(m_vlist.begin(), m_vlist.end(), cmpVersions);
+	sortDescending(m_vlist, versionSortKey);
+	rebuildLookup();
 	endResetModel();
 }
 
@@ -66,16 +66,14 @@ int MinecraftVersionList::count() const
 	return m_vlist.count();
 }
 
-static bool cmpVersions(BaseVersionPtr first, BaseVersionPtr second)
+static qint64 versionSortKey(BaseVersionPtr version)
 {
-	auto left = std::dynamic_pointer_cast<MinecraftVersion>(first);
-	auto right = std::dynamic_pointer_cast<MinecraftVersion>(second);
-	return left->m_releaseTime > right->m_releaseTime;
+	return std::dynamic_pointer_cast<MinecraftVersion>(version)->m_releaseTime.toMSecsSinceEpoch();
 }
 
 void MinecraftVersionList::sortInternal()
 {
-	qSort(m_vlist.begin(), m_vlist.end(), cmpVersions);
+	sortDescending(m_vlist, versionSortKey);
 }
 
 void MinecraftVersionList::loadCachedList()
@@ -556,13 +554,10 @@ void MinecraftVersionList::saveCachedList()
 void MinecraftVersionList::finalizeUpdate(QString version)
 {
 	int idx = -1;
-	for (int i = 0; i < m_vlist.size(); i++)
+	auto found = m_lookup.value(version);
+	if (found)
 	{
-		if (version == m_vlist[i]->descriptor())
-		{
-			idx = i;
-			break;
-		}
+		idx = m_vlist.indexOf(found);
 	}
 	if (idx == -1)
 	{
@@ -56,7 +56,6 @@ public:
 
 protected:
 	QList<BaseVersionPtr> m_vlist;
-	QMap<QString, BaseVersionPtr> m_lookup;
 
 	bool m_loaded = false;
 	bool m_hasLocalIndex = false;
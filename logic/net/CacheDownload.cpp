@@ -22,12 +22,12 @@
 #include <QDateTime>
 #include "logger/QsLog.h"
 
-CacheDownload::CacheDownload(QUrl url, MetaEntryPtr entry)
-	: NetAction(), md5sum(QCryptographicHash::Md5)
+CacheDownload::CacheDownload(QUrl url, MetaEntryPtr entry) : NetAction()
 {
 	m_url = url;
 	m_entry = entry;
 	m_target_path = entry->getFullPath();
+	m_output_file.reset(new PartialFile(m_target_path));
 	m_status = Job_NotStarted;
 }
 
@@ -40,9 +40,6 @@ void CacheDownload::start()
 		emit succeeded(m_index_within_job);
 		return;
 	}
-	// create a new save file
-	m_output_file.reset(new QSaveFile(m_target_path));
-
 	// if there already is a file and md5 checking is in effect and it can be opened
 	if (!ensureFilePathExists(m_target_path))
 	{
@@ -51,7 +48,8 @@ void CacheDownload::start()
 		emit failed(m_index_within_job);
 		return;
 	}
-	if (!m_output_file->open(QIODevice::WriteOnly))
+	QNetworkRequest request(m_url);
+	if (!m_output_file->begin(request))
 	{
 		QLOG_ERROR() << "Could not open " + m_target_path + " for writing";
 		m_status = Job_Failed;
@@ -59,11 +57,10 @@ void CacheDownload::start()
 		return;
 	}
 	QLOG_INFO() << "Downloading " << m_url.toString();
-	QNetworkRequest request(m_url);
 
-	// check file consistency first.
+	// check file consistency first. not when resuming, we need the partial content then.
 	QFile current(m_target_path);
-	if(current.exists() && current.size() != 0)
+	if(!m_output_file->resuming() && current.exists() && current.size() != 0)
 	{
 		if (m_entry->remote_changed_timestamp.size())
 			request.setRawHeader(QString("If-Modified-Since").toLatin1(),
@@ -88,9 +85,11 @@ void CacheDownload::start()
 
 void CacheDownload::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
-	m_total_progress = bytesTotal;
-	m_progress = bytesReceived;
-	emit progress(m_index_within_job, bytesReceived, bytesTotal);
+	// count what earlier attempts got as well
+	qint64 offset = m_output_file->offset();
+	m_total_progress = bytesTotal < 0 ? bytesTotal : bytesTotal + offset;
+	m_progress = bytesReceived + offset;
+	emit progress(m_index_within_job, m_progress, m_total_progress);
 }
 
 void CacheDownload::downloadError(QNetworkReply::NetworkError error)
@@ -125,25 +124,27 @@ void CacheDownload::downloadFinished()
 	// if the download succeeded
 	if (m_status == Job_Failed)
 	{
-		m_output_file->cancelWriting();
+		// keep what we got, the next attempt only needs the rest
+		m_output_file->keep(m_reply.get());
 		m_reply.reset();
 		emit failed(m_index_within_job);
 		return;
 	}
 
-	// if we wrote any data to the save file, we try to commit the data to the real file.
-	if (wroteAnyData)
+	// if we wrote any data to the part file, we try to commit the data to the real file.
+	if (m_output_file->wroteAnyData())
 	{
 		// nothing went wrong...
+		QString md5sum = m_output_file->md5sum();
 		if (m_output_file->commit())
 		{
 			m_status = Job_Finished;
-			m_entry->md5sum = md5sum.result().toHex().constData();
+			m_entry->md5sum = md5sum;
 		}
 		else
 		{
 			QLOG_ERROR() << "Failed to commit changes to " << m_target_path;
-			m_output_file->cancelWriting();
+			m_output_file->discard();
 			m_reply.reset();
 			m_status = Job_Failed;
 			emit failed(m_index_within_job);
@@ -152,12 +153,11 @@ void CacheDownload::downloadFinished()
 	}
 	else
 	{
+		// not modified. the part file is empty, nothing to keep
+		m_output_file->discard();
 		m_status = Job_Finished;
 	}
 
-	// then get rid of the save file
-	m_output_file.reset();
-
 	QFileInfo output_file_info(m_target_path);
 
 	m_entry->etag = m_reply->rawHeader("ETag").constData();
@@ -175,16 +175,23 @@ void CacheDownload::downloadFinished()
 	return;
 }
 
+void CacheDownload::adoptTransfer(NetActionPtr other)
+{
+	auto winner = std::dynamic_pointer_cast<CacheDownload>(other);
+	if (winner && winner->m_entry != m_entry)
+	{
+		m_entry->adoptState(*winner->m_entry);
+	}
+	NetAction::adoptTransfer(other);
+}
+
 void CacheDownload::downloadReadyRead()
 {
 	QByteArray ba = m_reply->readAll();
-	md5sum.addData(ba);
-	if (m_output_file->write(ba) != ba.size())
+	if (!m_output_file->write(m_reply.get(), ba))
 	{
 		QLOG_ERROR() << "Failed writing into " + m_target_path;
 		m_status = Job_Failed;
 		m_reply->abort();
-		emit failed(m_index_within_job);
 	}
-	wroteAnyData = true;
 }
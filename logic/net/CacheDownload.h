@@ -17,8 +17,7 @@
 
 #include "NetAction.h"
 #include "HttpMetaCache.h"
-#include <QCryptographicHash>
-#include <QSaveFile>
+#include "PartialFile.h"
 
 typedef std::shared_ptr<class CacheDownload> CacheDownloadPtr;
 class CacheDownload : public NetAction
@@ -28,12 +27,8 @@ private:
 	MetaEntryPtr m_entry;
 	/// if saving to file, use the one specified in this string
 	QString m_target_path;
-	/// this is the output file, if any
-	std::shared_ptr<QSaveFile> m_output_file;
-	/// the hash-as-you-download
-	QCryptographicHash md5sum;
-
-	bool wroteAnyData = false;
+	/// this is the output file. keeps data and hash of failed attempts for resuming
+	std::unique_ptr<PartialFile> m_output_file;
 
 public:
 	explicit CacheDownload(QUrl url, MetaEntryPtr entry);
@@ -46,6 +41,11 @@ public:
 	{
 		return m_target_path;
 	}
+	virtual QString sharingKey() const
+	{
+		return m_url.toString() + '\n' + m_target_path;
+	}
+	virtual void adoptTransfer(NetActionPtr other);
 protected
 slots:
 	virtual void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
@@ -0,0 +1,70 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DownloadCoordinator.h"
+#include "NetJob.h"
+#include "MultiMC.h"
+#include "logic/settings/SettingsObject.h"
+#include "logger/QsLog.h"
+
+DownloadCoordinator::DownloadCoordinator(QObject *parent) : QObject(parent)
+{
+	qRegisterMetaType<NetActionPtr>("NetActionPtr");
+}
+
+bool DownloadCoordinator::canStart() const
+{
+	return m_active < qMax(1, MMC->settings()->get("NetMaxConnections").toInt());
+}
+
+bool DownloadCoordinator::isRunning(const QString &key) const
+{
+	return !key.isEmpty() && m_running.contains(key);
+}
+
+void DownloadCoordinator::transferStarted(const QString &key, NetActionPtr action)
+{
+	m_active++;
+	if (!key.isEmpty())
+	{
+		Transfer transfer;
+		transfer.action = action;
+		m_running.insert(key, transfer);
+	}
+}
+
+void DownloadCoordinator::transferFinished(const QString &key, bool success)
+{
+	m_active--;
+	if (!key.isEmpty())
+	{
+		auto transfer = m_running.take(key);
+		for (auto &waiter : transfer.waiters)
+		{
+			if (!waiter.job)
+				continue;
+			// queued, the finishing job may still be in the middle of its own bookkeeping
+			QMetaObject::invokeMethod(waiter.job.data(), "sharedPartFinished",
+									  Qt::QueuedConnection, Q_ARG(int, waiter.index),
+									  Q_ARG(bool, success), Q_ARG(NetActionPtr, transfer.action));
+		}
+	}
+}
+
+void DownloadCoordinator::waitFor(const QString &key, NetJob *job, int index)
+{
+	QLOG_INFO() << "Sharing the running transfer of" << key.section('\n', 0, 0);
+	m_running[key].waiters.append({job, index});
+}
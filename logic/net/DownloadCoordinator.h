@@ -0,0 +1,66 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <QObject>
+#include <QMap>
+#include <QList>
+#include <QPointer>
+#include "NetAction.h"
+
+class NetJob;
+
+/**
+ * Process-wide bookkeeping of running transfers.
+ *
+ * When a NetJob is about to start a transfer that another job is already running (same
+ * sharing key), it waits for that transfer instead and gets its result. It also holds the
+ * global budget of transfers all jobs together may run at once.
+ */
+class DownloadCoordinator : public QObject
+{
+	Q_OBJECT
+public:
+	explicit DownloadCoordinator(QObject *parent = 0);
+
+	/// may another transfer be started within the global budget?
+	bool canStart() const;
+
+	/// is a transfer with the key running right now?
+	bool isRunning(const QString &key) const;
+
+	/// action is starting a transfer. The key may be empty for transfers that can't be shared.
+	void transferStarted(const QString &key, NetActionPtr action);
+	/// a transfer ended. Its waiters are told about the result.
+	void transferFinished(const QString &key, bool success);
+
+	/// have job's part wait for the running transfer with the key
+	void waitFor(const QString &key, NetJob *job, int index);
+
+private:
+	struct Waiter
+	{
+		QPointer<NetJob> job;
+		int index;
+	};
+	struct Transfer
+	{
+		/// the action doing the transfer, handed to the waiters when it's done
+		NetActionPtr action;
+		QList<Waiter> waiters;
+	};
+	QMap<QString, Transfer> m_running;
+	int m_active = 0;
+};
@@ -0,0 +1,133 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HostThrottle.h"
+#include "MultiMC.h"
+#include "logic/settings/SettingsObject.h"
+#include "logger/QsLog.h"
+
+#include <QMap>
+#include <memory>
+
+namespace
+{
+// the old fixed limit - a good place to start from
+const int INITIAL_LIMIT = 6;
+// don't decide anything based on less than this
+const qint64 WINDOW_MSECS = 1000;
+const int WINDOW_MIN_TRANSFERS = 4;
+}
+
+HostThrottle &HostThrottle::get(const QString &host)
+{
+	static QMap<QString, std::shared_ptr<HostThrottle>> throttles;
+	auto &throttle = throttles[host];
+	if (!throttle)
+	{
+		throttle.reset(new HostThrottle());
+	}
+	return *throttle;
+}
+
+HostThrottleNotifier *HostThrottle::notifier()
+{
+	static HostThrottleNotifier notifier;
+	return &notifier;
+}
+
+HostThrottle::HostThrottle()
+{
+	m_limit = qMin(INITIAL_LIMIT, maxLimit());
+}
+
+int HostThrottle::maxLimit() const
+{
+	return qMax(1, MMC->settings()->get("NetMaxConnectionsPerHost").toInt());
+}
+
+bool HostThrottle::canStart() const
+{
+	return m_active < qMin(m_limit, maxLimit());
+}
+
+void HostThrottle::transferStarted()
+{
+	if (!m_window.isValid())
+		m_window.start();
+	m_active++;
+	m_peakActive = qMax(m_peakActive, m_active);
+}
+
+void HostThrottle::transferFinished(qint64 bytes, qint64 msecs, qint64 msecsToFirstByte,
+									bool success)
+{
+	m_active--;
+	emit notifier()->capacityAvailable();
+	if (!success)
+	{
+		m_limit = qMax(1, m_limit / 2);
+		m_probing = false;
+		return;
+	}
+	if (msecsToFirstByte >= 0)
+	{
+		m_rtt = m_rtt < 0 ? msecsToFirstByte : (m_rtt * 7 + msecsToFirstByte) / 8;
+		// waiting for the first byte took most of the time -> more connections will help
+		if (msecsToFirstByte * 2 >= msecs)
+			m_windowLatencyBound++;
+	}
+	m_windowBytes += bytes;
+	m_windowTransfers++;
+	if (m_window.elapsed() >= WINDOW_MSECS && m_windowTransfers >= WINDOW_MIN_TRANSFERS)
+	{
+		endWindow();
+	}
+}
+
+void HostThrottle::endWindow()
+{
+	double throughput = double(m_windowBytes) * 1000.0 / qMax<qint64>(1, m_window.elapsed());
+	bool saturated = m_peakActive >= m_limit;
+	bool latencyBound = m_windowLatencyBound * 2 > m_windowTransfers;
+	int oldLimit = m_limit;
+
+	if (m_probing && throughput < m_lastThroughput * 1.05 && !latencyBound)
+	{
+		// the last increase didn't buy anything
+		m_limit = qMax(1, m_limit - 1);
+		m_probing = false;
+	}
+	else if (saturated && (latencyBound || m_probing) && m_limit < maxLimit())
+	{
+		m_limit++;
+		m_probing = true;
+	}
+	else
+	{
+		m_probing = false;
+	}
+	if (oldLimit != m_limit)
+	{
+		QLOG_DEBUG() << "Host connection limit" << oldLimit << "->" << m_limit << "at"
+					 << int(throughput / 1024) << "KiB/s, rtt" << m_rtt << "ms";
+	}
+
+	m_lastThroughput = throughput;
+	m_windowBytes = 0;
+	m_windowTransfers = 0;
+	m_windowLatencyBound = 0;
+	m_peakActive = m_active;
+	m_window.restart();
+}
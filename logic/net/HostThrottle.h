@@ -0,0 +1,95 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QElapsedTimer>
+
+/// Tells the NetJobs that a transfer ended somewhere, so a host may have room again.
+class HostThrottleNotifier : public QObject
+{
+	Q_OBJECT
+signals:
+	void capacityAvailable();
+};
+
+/**
+ * Tracks the transfers running against one host and decides how many may run at once.
+ *
+ * The limit is probed upwards while it pays off: when most transfers are dominated by the
+ * time to first byte (many tiny files), or when the last increase raised the throughput.
+ * An increase that didn't help is taken back, and failures halve the limit.
+ *
+ * Throttles are shared by all NetJobs in the process.
+ */
+class HostThrottle
+{
+public:
+	/// get the throttle for a host
+	static HostThrottle &get(const QString &host);
+	/**
+	 * Emits capacityAvailable whenever any throttle's transfer ended.
+	 * Jobs with parts held back by a full host have nothing of their own running that
+	 * would wake them up, so they listen to this.
+	 */
+	static HostThrottleNotifier *notifier();
+
+	/// may another transfer be started right now?
+	bool canStart() const;
+	/// current number of transfers allowed at once
+	int limit() const
+	{
+		return m_limit;
+	}
+	int active() const
+	{
+		return m_active;
+	}
+
+	void transferStarted();
+	/**
+	 * Report a finished transfer.
+	 * msecsToFirstByte is negative when no data was received at all.
+	 */
+	void transferFinished(qint64 bytes, qint64 msecs, qint64 msecsToFirstByte, bool success);
+
+	/// estimated round trip time in milliseconds, or -1 if unknown
+	qint64 rtt() const
+	{
+		return m_rtt;
+	}
+
+private:
+	HostThrottle();
+	void endWindow();
+	int maxLimit() const;
+
+private:
+	int m_limit;
+	int m_active = 0;
+	int m_peakActive = 0;
+
+	qint64 m_rtt = -1;
+
+	// measurement window
+	QElapsedTimer m_window;
+	qint64 m_windowBytes = 0;
+	int m_windowTransfers = 0;
+	int m_windowLatencyBound = 0;
+	double m_lastThroughput = 0;
+	/// did the limit go up at the end of the previous window?
+	bool m_probing = false;
+};
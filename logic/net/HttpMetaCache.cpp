@@ -23,6 +23,9 @@
 #include <QSaveFile>
 #include <QDateTime>
 #include <QCryptographicHash>
+#include <QtConcurrentMap>
+#include <QDataStream>
+#include <QtEndian>
 
 #include "logger/QsLog.h"
 
@@ -35,9 +38,32 @@ QString MetaEntry::getFullPath()
 	return PathCombine(MMC->metacache()->getBasePath(base), path);
 }
 
+void MetaEntry::adoptState(const MetaEntry &other)
+{
+	md5sum = other.md5sum;
+	etag = other.etag;
+	local_changed_timestamp = other.local_changed_timestamp;
+	remote_changed_timestamp = other.remote_changed_timestamp;
+	stale = other.stale;
+}
+
+namespace
+{
+// "MMCI"
+const quint32 LOG_MAGIC = 0x4d4d4349;
+const quint32 LOG_VERSION = 2;
+const int LOG_HEADER_SIZE = 8;
+enum RecordType : quint8
+{
+	PutRecord = 1,
+	RemoveRecord = 2
+};
+}
+
 HttpMetaCache::HttpMetaCache(QString path) : QObject()
 {
 	m_index_file = path;
+	m_log_file = path + ".idx";
 	saveBatchingTimer.setSingleShot(true);
 	saveBatchingTimer.setTimerType(Qt::VeryCoarseTimer);
 	connect(&saveBatchingTimer, SIGNAL(timeout()), SLOT(SaveNow()));
@@ -58,6 +84,7 @@ MetaEntryPtr HttpMetaCache::getEntry(QString base, QString resource_path)
 		return MetaEntryPtr();
 	}
 	EntryMap &map = m_entries[base];
+	loadBase(map);
 	if (map.entry_list.contains(resource_path))
 	{
 		return map.entry_list[resource_path];
@@ -65,9 +92,28 @@ MetaEntryPtr HttpMetaCache::getEntry(QString base, QString resource_path)
 	return MetaEntryPtr();
 }
 
-MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path,
-										 QString expected_etag)
+QString HttpMetaCache::md5sumOfFile(const QString &path)
 {
+	QFile input(path);
+	if (!input.open(QIODevice::ReadOnly))
+		return QString();
+	QCryptographicHash md5(QCryptographicHash::Md5);
+	char buffer[64 * 1024];
+	qint64 read;
+	while ((read = input.read(buffer, sizeof(buffer))) > 0)
+	{
+		md5.addData(buffer, read);
+	}
+	if (read < 0)
+		return QString();
+	return md5.result().toHex().constData();
+}
+
+MetaEntryPtr HttpMetaCache::checkEntry(QString base, QString resource_path,
+									   QString expected_etag, bool &needsHash,
+									   qint64 &file_last_changed)
+{
+	needsHash = false;
 	auto entry = getEntry(base, resource_path);
 	// it's not present? generate a default stale entry
 	if (!entry)
@@ -83,40 +129,118 @@ MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path,
 	if (!finfo.isFile() || !finfo.isReadable())
 	{
 		// if the file doesn't exist, we disown the entry
-		selected_base.entry_list.remove(resource_path);
+		removeEntry(selected_base, resource_path);
 		return staleEntry(base, resource_path);
 	}
 
 	if (!expected_etag.isEmpty() && expected_etag != entry->etag)
 	{
 		// if the etag doesn't match expected, we disown the entry
-		selected_base.entry_list.remove(resource_path);
+		removeEntry(selected_base, resource_path);
 		return staleEntry(base, resource_path);
 	}
 
-	// if the file changed, check md5sum
-	qint64 file_last_changed = finfo.lastModified().toUTC().toMSecsSinceEpoch();
+	// if the file changed, the md5sum has to be checked
+	file_last_changed = finfo.lastModified().toUTC().toMSecsSinceEpoch();
 	if (file_last_changed != entry->local_changed_timestamp)
 	{
-		QFile input(real_path);
-		input.open(QIODevice::ReadOnly);
-		QString md5sum = QCryptographicHash::hash(input.readAll(), QCryptographicHash::Md5)
-							 .toHex()
-							 .constData();
-		if (entry->md5sum != md5sum)
+		needsHash = true;
+	}
+	return entry;
+}
+
+MetaEntryPtr HttpMetaCache::applyHash(MetaEntryPtr entry, qint64 file_last_changed,
+									  QString md5sum)
+{
+	auto &selected_base = m_entries[entry->base];
+	if (entry->md5sum != md5sum)
+	{
+		// only disown the entry if it wasn't replaced in the meantime
+		auto iter = selected_base.entry_list.find(entry->path);
+		if (iter != selected_base.entry_list.end() && *iter == entry)
 		{
-			selected_base.entry_list.remove(resource_path);
-			return staleEntry(base, resource_path);
+			removeEntry(selected_base, entry->path);
 		}
-		// md5sums matched... keep entry and save the new state to file
-		entry->local_changed_timestamp = file_last_changed;
-		SaveEventually();
+		return staleEntry(entry->base, entry->path);
 	}
+	// md5sums matched... keep entry and save the new state to file
+	entry->local_changed_timestamp = file_last_changed;
+	appendRecord(putRecord(entry));
+	return entry;
+}
 
+MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path,
+										 QString expected_etag)
+{
+	bool needsHash;
+	qint64 file_last_changed;
+	auto entry = checkEntry(base, resource_path, expected_etag, needsHash, file_last_changed);
+	if (needsHash)
+	{
+		return applyHash(entry, file_last_changed, md5sumOfFile(entry->getFullPath()));
+	}
 	// entry passed all the checks we cared about.
 	return entry;
 }
 
+MetaResolveBatchPtr HttpMetaCache::resolveEntries(const QList<MetaResolveRequest> &requests)
+{
+	MetaResolveBatchPtr batch(new MetaResolveBatch(this), [](MetaResolveBatch *done)
+	{ done->deleteLater(); });
+	for (auto &request : requests)
+	{
+		bool needsHash;
+		qint64 file_last_changed;
+		auto entry = checkEntry(request.base, request.path, request.expected_etag, needsHash,
+								file_last_changed);
+		if (needsHash)
+		{
+			MetaResolveBatch::Verification verification;
+			verification.index = batch->m_entries.size();
+			verification.real_path = entry->getFullPath();
+			verification.file_last_changed = file_last_changed;
+			batch->m_pending.append(verification);
+		}
+		batch->m_entries.append(entry);
+	}
+	if (batch->m_pending.isEmpty())
+	{
+		// nothing to wait for, but keep the result asynchronous for the caller
+		QMetaObject::invokeMethod(batch.get(), "verificationFinished", Qt::QueuedConnection);
+		return batch;
+	}
+	QLOG_INFO() << "Verifying" << batch->m_pending.size() << "changed cache entries";
+	QObject::connect(&batch->m_watcher, SIGNAL(finished()), batch.get(),
+					 SLOT(verificationFinished()));
+	std::function<MetaResolveBatch::Verification(const MetaResolveBatch::Verification &)>
+		hasher = [](const MetaResolveBatch::Verification &in)
+	{
+		MetaResolveBatch::Verification out = in;
+		out.md5sum = md5sumOfFile(in.real_path);
+		return out;
+	};
+	batch->m_watcher.setFuture(QtConcurrent::mapped(batch->m_pending, hasher));
+	return batch;
+}
+
+void MetaResolveBatch::verificationFinished()
+{
+	if (!m_pending.isEmpty())
+	{
+		auto future = m_watcher.future();
+		for (int i = 0; i < future.resultCount(); i++)
+		{
+			auto result = future.resultAt(i);
+			m_entries[result.index] = m_cache->applyHash(m_entries[result.index],
+														 result.file_last_changed,
+														 result.md5sum);
+		}
+		m_pending.clear();
+	}
+	m_finished = true;
+	emit finished();
+}
+
 bool HttpMetaCache::updateEntry(MetaEntryPtr stale_entry)
 {
 	if (!m_entries.contains(stale_entry->base))
@@ -130,8 +254,10 @@ bool HttpMetaCache::updateEntry(MetaEntryPtr stale_entry)
 		QLOG_ERROR() << "Cannot add stale entry: " << stale_entry->getFullPath().toLocal8Bit();
 		return false;
 	}
-	m_entries[stale_entry->base].entry_list[stale_entry->path] = stale_entry;
-	SaveEventually();
+	auto &map = m_entries[stale_entry->base];
+	loadBase(map);
+	map.entry_list[stale_entry->path] = stale_entry;
+	appendRecord(putRecord(stale_entry));
 	return true;
 }
 
@@ -164,32 +290,185 @@ QString HttpMetaCache::getBasePath(QString base)
 	return QString();
 }
 
-void HttpMetaCache::Load()
+void HttpMetaCache::loadBase(EntryMap &map)
+{
+	if (map.pending_records.isEmpty())
+		return;
+	for (auto &record : map.pending_records)
+	{
+		QDataStream in(record);
+		in.setVersion(QDataStream::Qt_5_0);
+		quint8 type;
+		QString base, path;
+		in >> type >> base >> path;
+		if (type == RemoveRecord)
+		{
+			map.entry_list.remove(path);
+			continue;
+		}
+		auto foo = new MetaEntry;
+		foo->base = base;
+		foo->path = path;
+		in >> foo->md5sum >> foo->etag >> foo->local_changed_timestamp >>
+			foo->remote_changed_timestamp;
+		// presumed innocent until closer examination
+		foo->stale = false;
+		map.entry_list[path] = MetaEntryPtr(foo);
+	}
+	map.pending_records.clear();
+}
+
+void HttpMetaCache::removeEntry(EntryMap &map, QString resource_path)
+{
+	auto iter = map.entry_list.find(resource_path);
+	if (iter == map.entry_list.end())
+		return;
+	QString base = (*iter)->base;
+	map.entry_list.erase(iter);
+	appendRecord(removeRecord(base, resource_path));
+}
+
+QByteArray HttpMetaCache::putRecord(MetaEntryPtr entry)
+{
+	QByteArray payload;
+	QDataStream out(&payload, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_0);
+	out << quint8(PutRecord) << entry->base << entry->path << entry->md5sum << entry->etag
+		<< entry->local_changed_timestamp << entry->remote_changed_timestamp;
+	return payload;
+}
+
+QByteArray HttpMetaCache::removeRecord(QString base, QString resource_path)
+{
+	QByteArray payload;
+	QDataStream out(&payload, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_0);
+	out << quint8(RemoveRecord) << base << resource_path;
+	return payload;
+}
+
+// record framing: payload size, payload, CRC-16 of the payload
+static QByteArray frameRecord(const QByteArray &payload)
+{
+	QByteArray frame;
+	QDataStream out(&frame, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_0);
+	out << quint32(payload.size());
+	out.writeRawData(payload.constData(), payload.size());
+	out << quint16(qChecksum(payload.constData(), payload.size()));
+	return frame;
+}
+
+void HttpMetaCache::appendRecord(const QByteArray &payload)
+{
+	if (!m_log)
+	{
+		// no usable log. compacting creates a new one.
+		if (!compact())
+			return;
+	}
+	QByteArray frame = frameRecord(payload);
+	if (m_log->write(frame) != frame.size() || !m_log->flush())
+	{
+		QLOG_ERROR() << "Failed to append to the cache index" << m_log_file;
+		m_log.reset();
+		return;
+	}
+	m_log_records++;
+	SaveEventually();
+}
+
+bool HttpMetaCache::loadLog()
+{
+	QFile index(m_log_file);
+	if (!index.open(QIODevice::ReadOnly))
+		return false;
+	qint64 size = index.size();
+	if (size < LOG_HEADER_SIZE)
+		return false;
+	const uchar *data = index.map(0, size);
+	QByteArray buffer;
+	if (!data)
+	{
+		buffer = index.readAll();
+		data = (const uchar *)buffer.constData();
+	}
+	if (qFromBigEndian<quint32>(data) != LOG_MAGIC ||
+		qFromBigEndian<quint32>(data + 4) != LOG_VERSION)
+	{
+		QLOG_WARN() << "Unknown cache index format in" << m_log_file;
+		return false;
+	}
+
+	qint64 pos = LOG_HEADER_SIZE;
+	m_log_records = 0;
+	while (pos + 4 <= size)
+	{
+		quint32 length = qFromBigEndian<quint32>(data + pos);
+		if (pos + 4 + length + 2 > size)
+			break;
+		const char *payload = (const char *)data + pos + 4;
+		quint16 checksum = qFromBigEndian<quint16>(data + pos + 4 + length);
+		if (qChecksum(payload, length) != checksum)
+			break;
+
+		// only the base is decoded here, the rest waits until the base is used
+		QByteArray record(payload, length);
+		QDataStream in(record);
+		in.setVersion(QDataStream::Qt_5_0);
+		quint8 type;
+		QString base;
+		in >> type >> base;
+		if (m_entries.contains(base))
+		{
+			m_entries[base].pending_records.append(record);
+		}
+		m_log_records++;
+		pos += 4 + length + 2;
+	}
+	bool truncated = pos != size;
+	index.close();
+
+	if (truncated)
+	{
+		QLOG_WARN() << "Dropping" << size - pos << "bytes of incomplete records from"
+					<< m_log_file;
+		QFile::resize(m_log_file, pos);
+	}
+	m_log.reset(new QFile(m_log_file));
+	if (!m_log->open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		m_log.reset();
+	}
+	return true;
+}
+
+bool HttpMetaCache::loadLegacyJson()
 {
 	QFile index(m_index_file);
 	if (!index.open(QIODevice::ReadOnly))
-		return;
+		return false;
 
 	QJsonDocument json = QJsonDocument::fromJson(index.readAll());
 	if (!json.isObject())
-		return;
+		return false;
 	auto root = json.object();
 	// check file version first
 	auto version_val = root.value("version");
 	if (!version_val.isString())
-		return;
+		return false;
 	if (version_val.toString() != "1")
-		return;
+		return false;
 
 	// read the entry array
 	auto entries_val = root.value("entries");
 	if (!entries_val.isArray())
-		return;
+		return false;
 	QJsonArray array = entries_val.toArray();
 	for (auto element : array)
 	{
 		if (!element.isObject())
-			return;
+			return false;
 		auto element_obj = element.toObject();
 		QString base = element_obj.value("base").toString();
 		if (!m_entries.contains(base))
@@ -207,6 +486,23 @@ void HttpMetaCache::Load()
 		foo->stale = false;
 		entrymap.entry_list[path] = MetaEntryPtr(foo);
 	}
+	return true;
+}
+
+void HttpMetaCache::Load()
+{
+	if (loadLog())
+		return;
+
+	// no usable binary index, try migrating the old JSON one
+	if (!loadLegacyJson())
+		return;
+	QLOG_INFO() << "Migrating the cache index from" << m_index_file << "to" << m_log_file;
+	if (compact())
+	{
+		QFile::remove(m_index_file + ".v1");
+		QFile::rename(m_index_file, m_index_file + ".v1");
+	}
 }
 
 void HttpMetaCache::SaveEventually()
@@ -218,36 +514,53 @@ void HttpMetaCache::SaveEventually()
 
 void HttpMetaCache::SaveNow()
 {
-	QSaveFile tfile(m_index_file);
-	if (!tfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	int live = 0;
+	for (auto &group : m_entries)
+	{
+		live += group.entry_list.size() + group.pending_records.size();
+	}
+	// the log is only rewritten once it's mostly garbage
+	if (m_log && m_log_records <= 2 * live + 1000)
 		return;
-	QJsonObject toplevel;
-	toplevel.insert("version", QJsonValue(QString("1")));
-	QJsonArray entriesArr;
-	for (auto group : m_entries)
+	compact();
+}
+
+bool HttpMetaCache::compact()
+{
+	QSaveFile tfile(m_log_file);
+	if (!tfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QByteArray data;
+	{
+		QDataStream out(&data, QIODevice::WriteOnly);
+		out.setVersion(QDataStream::Qt_5_0);
+		out << LOG_MAGIC << LOG_VERSION;
+	}
+	int records = 0;
+	for (auto &group : m_entries)
 	{
+		loadBase(group);
 		for (auto entry : group.entry_list)
 		{
-			QJsonObject entryObj;
-			entryObj.insert("base", QJsonValue(entry->base));
-			entryObj.insert("path", QJsonValue(entry->path));
-			entryObj.insert("md5sum", QJsonValue(entry->md5sum));
-			entryObj.insert("etag", QJsonValue(entry->etag));
-			entryObj.insert("last_changed_timestamp",
-							QJsonValue(double(entry->local_changed_timestamp)));
-			if (!entry->remote_changed_timestamp.isEmpty())
-				entryObj.insert("remote_changed_timestamp",
-								QJsonValue(entry->remote_changed_timestamp));
-			entriesArr.append(entryObj);
+			data.append(frameRecord(putRecord(entry)));
+			records++;
 		}
 	}
-	toplevel.insert("entries", entriesArr);
-	QJsonDocument doc(toplevel);
-	QByteArray jsonData = doc.toJson();
-	qint64 result = tfile.write(jsonData);
-	if (result == -1)
-		return;
-	if (result != jsonData.size())
-		return;
-	tfile.commit();
+	qint64 result = tfile.write(data);
+	if (result != data.size())
+		return false;
+	// the old append handle points at the replaced file
+	m_log.reset();
+	if (!tfile.commit())
+		return false;
+	m_log_records = records;
+	m_log.reset(new QFile(m_log_file));
+	if (!m_log->open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		QLOG_ERROR() << "Failed to open the cache index" << m_log_file << "for appending";
+		m_log.reset();
+		return false;
+	}
+	return true;
 }
@@ -16,7 +16,11 @@
 #pragma once
 #include <QString>
 #include <QMap>
+#include <QList>
+#include <QFutureWatcher>
+#include <QFile>
 #include <qtimer.h>
+#include <memory>
 
 struct MetaEntry
 {
@@ -28,10 +32,77 @@ struct MetaEntry
 	QString remote_changed_timestamp; // QString for now, RFC 2822 encoded time
 	bool stale = true;
 	QString getFullPath();
+	/// take over what another entry for the same file knows about it
+	void adoptState(const MetaEntry &other);
 };
 
 typedef std::shared_ptr<MetaEntry> MetaEntryPtr;
 
+struct MetaResolveRequest
+{
+	QString base;
+	QString path;
+	QString expected_etag;
+};
+
+class HttpMetaCache;
+
+/**
+ * A batch of cache entries being resolved in the background.
+ * Emits finished() on the GUI thread once every entry has been resolved.
+ */
+class MetaResolveBatch : public QObject
+{
+	Q_OBJECT
+	friend class HttpMetaCache;
+	explicit MetaResolveBatch(HttpMetaCache *cache) : m_cache(cache)
+	{
+	}
+
+public:
+	/// resolved entries, in the same order as the requests
+	QList<MetaEntryPtr> entries() const
+	{
+		return m_entries;
+	}
+	bool isFinished() const
+	{
+		return m_finished;
+	}
+
+signals:
+	void finished();
+
+private slots:
+	void verificationFinished();
+
+private:
+	struct Verification
+	{
+		int index;
+		QString real_path;
+		qint64 file_last_changed;
+		QString md5sum;
+	};
+	HttpMetaCache *m_cache;
+	QList<MetaEntryPtr> m_entries;
+	QList<Verification> m_pending;
+	QFutureWatcher<Verification> m_watcher;
+	bool m_finished = false;
+};
+/// releasing the last reference deletes the batch later, so that is safe from its own signals
+typedef std::shared_ptr<MetaResolveBatch> MetaResolveBatchPtr;
+
+/**
+ * The cache index is stored as an append-only log of binary records.
+ *
+ * Every change to an entry appends one record, so updates are O(1) and a crash can at most
+ * lose the record being written - a torn record at the end is detected by its checksum and
+ * dropped. Records of a base are only decoded when the base is first used. The log is
+ * rewritten (compacted) once it holds a lot more records than live entries.
+ *
+ * The old JSON index (version "1") is migrated on first load.
+ */
 class HttpMetaCache : public QObject
 {
 	Q_OBJECT
@@ -48,28 +119,70 @@ public:
 	MetaEntryPtr resolveEntry(QString base, QString resource_path,
 							  QString expected_etag = QString());
 
+	/**
+	 * Resolve many entries at once. Entries that need their contents checked are hashed
+	 * concurrently on the global thread pool, so this never blocks on file reads.
+	 */
+	MetaResolveBatchPtr resolveEntries(const QList<MetaResolveRequest> &requests);
+
 	// add a previously resolved stale entry
 	bool updateEntry(MetaEntryPtr stale_entry);
 
 	void addBase(QString base, QString base_root);
 
-	// (re)start a timer that calls SaveNow later.
+	/// md5sum of the file's contents as hex, empty if it can't be read
+	static QString md5sumOfFile(const QString &path);
+
+	// (re)start a timer that compacts the index later, if it needs it.
 	void SaveEventually();
 	void Load();
 	QString getBasePath(QString base);
 public
 slots:
+	// compact the index now, if it needs it
 	void SaveNow();
 
 private:
+	friend class MetaResolveBatch;
 	// create a new stale entry, given the parameters
 	MetaEntryPtr staleEntry(QString base, QString resource_path);
+	/**
+	 * Do all the checks that don't need the file contents.
+	 * Sets needsHash and returns the entry if it can only be trusted after its md5sum is
+	 * compared.
+	 */
+	MetaEntryPtr checkEntry(QString base, QString resource_path, QString expected_etag,
+							bool &needsHash, qint64 &file_last_changed);
+	// apply the result of comparing the file's md5sum to the entry
+	MetaEntryPtr applyHash(MetaEntryPtr entry, qint64 file_last_changed, QString md5sum);
+
 	struct EntryMap
 	{
 		QString base_path;
 		QMap<QString, MetaEntryPtr> entry_list;
+		/// undecoded log records of this base, in log order
+		QList<QByteArray> pending_records;
 	};
+	/// decode the pending log records of the base, if there are any
+	void loadBase(EntryMap &map);
+	/// drop an entry from memory and from the index
+	void removeEntry(EntryMap &map, QString resource_path);
+
+	/// append one record to the index log
+	void appendRecord(const QByteArray &payload);
+	QByteArray putRecord(MetaEntryPtr entry);
+	QByteArray removeRecord(QString base, QString resource_path);
+	/// rewrite the index log with only the live entries
+	bool compact();
+	bool loadLog();
+	bool loadLegacyJson();
+
 	QMap<QString, EntryMap> m_entries;
 	QString m_index_file;
+	QString m_log_file;
+	/// the log, open for appending
+	std::unique_ptr<QFile> m_log;
+	/// number of records in the log
+	int m_log_records = 0;
 	QTimer saveBatchingTimer;
-};
\ No newline at end of file
+};
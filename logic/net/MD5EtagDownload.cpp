@@ -15,30 +15,27 @@
 
 #include "MultiMC.h"
 #include "MD5EtagDownload.h"
+#include "HttpMetaCache.h"
 #include <pathutils.h>
-#include <QCryptographicHash>
 #include "logger/QsLog.h"
 
 MD5EtagDownload::MD5EtagDownload(QUrl url, QString target_path) : NetAction()
 {
 	m_url = url;
 	m_target_path = target_path;
+	m_output_file.reset(new PartialFile(target_path));
 	m_status = Job_NotStarted;
 }
 
 void MD5EtagDownload::start()
 {
+	m_status = Job_InProgress;
 	QString filename = m_target_path;
-	m_output_file.setFileName(filename);
 	// if there already is a file and md5 checking is in effect and it can be opened
-	if (m_output_file.exists() && m_output_file.open(QIODevice::ReadOnly))
+	if (QFile::exists(filename))
 	{
 		// get the md5 of the local file.
-		m_local_md5 =
-			QCryptographicHash::hash(m_output_file.readAll(), QCryptographicHash::Md5)
-				.toHex()
-				.constData();
-		m_output_file.close();
+		m_local_md5 = HttpMetaCache::md5sumOfFile(filename);
 		// if we are expecting some md5sum, compare it with the local one
 		if (!m_expected_md5.isEmpty())
 		{
@@ -46,6 +43,7 @@ void MD5EtagDownload::start()
 			if(m_local_md5 == m_expected_md5)
 			{
 				QLOG_INFO() << "Skipping " << m_url.toString() << ": md5 match.";
+				m_status = Job_Finished;
 				emit succeeded(m_index_within_job);
 				return;
 			}
@@ -57,15 +55,27 @@ void MD5EtagDownload::start()
 	}
 	if (!ensureFilePathExists(filename))
 	{
+		m_status = Job_Failed;
 		emit failed(m_index_within_job);
 		return;
 	}
 
 	QNetworkRequest request(m_url);
 
+	// Go ahead and try to open the file.
+	// If we don't do this, empty files won't be created, which breaks the updater.
+	// Plus, this way, we don't end up starting a download for a file we can't open.
+	if (!m_output_file->begin(request))
+	{
+		m_status = Job_Failed;
+		emit failed(m_index_within_job);
+		return;
+	}
+
 	QLOG_INFO() << "Downloading " << m_url.toString() << " local MD5: " << m_local_md5;
 
-	if(!m_local_md5.isEmpty())
+	// not when resuming, we need the partial content then.
+	if(!m_local_md5.isEmpty() && !m_output_file->resuming())
 	{
 		request.setRawHeader(QString("If-None-Match").toLatin1(), m_local_md5.toLatin1());
 	}
@@ -74,15 +84,6 @@ void MD5EtagDownload::start()
 
 	request.setHeader(QNetworkRequest::UserAgentHeader, "MultiMC/5.0 (Uncached)");
 
-	// Go ahead and try to open the file.
-	// If we don't do this, empty files won't be created, which breaks the updater.
-	// Plus, this way, we don't end up starting a download for a file we can't open.
-	if (!m_output_file.open(QIODevice::WriteOnly))
-	{
-		emit failed(m_index_within_job);
-		return;
-	}
-
 	auto worker = MMC->qnam();
 	QNetworkReply *rep = worker->get(request);
 
@@ -97,9 +98,11 @@ void MD5EtagDownload::start()
 
 void MD5EtagDownload::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
-	m_total_progress = bytesTotal;
-	m_progress = bytesReceived;
-	emit progress(m_index_within_job, bytesReceived, bytesTotal);
+	// count what earlier attempts got as well
+	qint64 offset = m_output_file->offset();
+	m_total_progress = bytesTotal < 0 ? bytesTotal : bytesTotal + offset;
+	m_progress = bytesReceived + offset;
+	emit progress(m_index_within_job, m_progress, m_total_progress);
 }
 
 void MD5EtagDownload::downloadError(QNetworkReply::NetworkError error)
@@ -114,12 +117,38 @@ void MD5EtagDownload::downloadFinished()
 	// if the download succeeded
 	if (m_status != Job_Failed)
 	{
+		int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+		if (status == 304)
+		{
+			// our file is the right one
+			m_output_file->discard();
+		}
+		else
+		{
+			QString md5sum = m_output_file->md5sum();
+			if (!m_expected_md5.isEmpty() && md5sum != m_expected_md5)
+			{
+				QLOG_ERROR() << "Got" << md5sum << "instead of" << m_expected_md5 << "from"
+							 << m_url.toString();
+				m_output_file->discard();
+				m_status = Job_Failed;
+				m_reply.reset();
+				emit failed(m_index_within_job);
+				return;
+			}
+			if (!m_output_file->commit())
+			{
+				QLOG_ERROR() << "Failed to move the download to " << m_target_path;
+				m_output_file->discard();
+				m_status = Job_Failed;
+				m_reply.reset();
+				emit failed(m_index_within_job);
+				return;
+			}
+		}
 		// nothing went wrong...
 		m_status = Job_Finished;
-		m_output_file.close();
 
-		// FIXME: compare with the real written data md5sum
-		// this is just an ETag
 		QLOG_INFO() << "Finished " << m_url.toString() << " got " << m_reply->rawHeader("ETag").constData();
 
 		m_reply.reset();
@@ -129,8 +158,8 @@ void MD5EtagDownload::downloadFinished()
 	// else the download failed
 	else
 	{
-		m_output_file.close();
-		m_output_file.remove();
+		// keep what we got, the next attempt only needs the rest
+		m_output_file->keep(m_reply.get());
 		m_reply.reset();
 		emit failed(m_index_within_job);
 		return;
@@ -139,17 +168,12 @@ void MD5EtagDownload::downloadFinished()
 
 void MD5EtagDownload::downloadReadyRead()
 {
-	if (!m_output_file.isOpen())
+	if (!m_output_file->write(m_reply.get(), m_reply->readAll()))
 	{
-		if (!m_output_file.open(QIODevice::WriteOnly))
-		{
-			/*
-			* Can't open the file... the job failed
-			*/
-			m_reply->abort();
-			emit failed(m_index_within_job);
-			return;
-		}
+		/*
+		* Can't write the file... the job failed
+		*/
+		m_status = Job_Failed;
+		m_reply->abort();
 	}
-	m_output_file.write(m_reply->readAll());
 }
@@ -16,7 +16,7 @@
 #pragma once
 
 #include "NetAction.h"
-#include <QFile>
+#include "PartialFile.h"
 
 typedef std::shared_ptr<class MD5EtagDownload> Md5EtagDownloadPtr;
 class MD5EtagDownload : public NetAction
@@ -29,8 +29,8 @@ public:
 	QString m_local_md5;
 	/// if saving to file, use the one specified in this string
 	QString m_target_path;
-	/// this is the output file, if any
-	QFile m_output_file;
+	/// this is the output file. keeps data and hash of failed attempts for resuming
+	std::unique_ptr<PartialFile> m_output_file;
 
 public:
 	explicit MD5EtagDownload(QUrl url, QString target_path);
@@ -39,6 +39,10 @@ public:
 		return Md5EtagDownloadPtr(new MD5EtagDownload(url, target_path));
 	}
 	virtual ~MD5EtagDownload(){};
+	virtual QString sharingKey() const
+	{
+		return m_url.toString() + '\n' + m_target_path;
+	}
 protected
 slots:
 	virtual void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
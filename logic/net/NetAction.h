@@ -19,6 +19,7 @@
 #include <QUrl>
 #include <memory>
 #include <QNetworkReply>
+#include <QMetaType>
 
 enum JobStatus
 {
@@ -55,6 +56,24 @@ public:
 	{
 		return shared_from_this();
 	}
+	/**
+	 * Identifies what this action transfers. Running actions with the same key are shared
+	 * between jobs. Empty for actions that can't be shared.
+	 */
+	virtual QString sharingKey() const
+	{
+		return QString();
+	}
+	/**
+	 * Another action with the same sharing key did the transfer for this one.
+	 * Take over its outcome and finish the way a transfer of our own would.
+	 */
+	virtual void adoptTransfer(NetActionPtr other)
+	{
+		m_status = Job_Finished;
+		m_progress = m_total_progress = other->m_total_progress;
+		emit succeeded(m_index_within_job);
+	}
 
 public:
 	/// the network reply
@@ -95,3 +114,5 @@ public
 slots:
 	virtual void start() = 0;
 };
+
+Q_DECLARE_METATYPE(NetActionPtr)
@@ -20,7 +20,35 @@
 #include "ByteArrayDownload.h"
 #include "CacheDownload.h"
 
+#include "HostThrottle.h"
+#include "logic/settings/SettingsObject.h"
+
 #include "logger/QsLog.h"
+#include <algorithm>
+
+NetJob::~NetJob()
+{
+	// whoever waits for our transfers will have to do them on their own
+	for (auto index : m_doing)
+	{
+		if (m_shared.contains(index))
+			continue;
+		auto part = downloads[index];
+		disconnect(part.get(), 0, this, 0);
+		if (part->m_reply)
+			part->m_reply->abort();
+		finishAttempt(index, false);
+	}
+}
+
+void NetJob::finishAttempt(int index, bool success)
+{
+	auto &slot = parts_progress[index];
+	MMC->downloadCoordinator()->transferFinished(slot.key, success);
+	HostThrottle::get(slot.host)
+		.transferFinished(slot.current_progress, slot.timer.elapsed(), slot.first_byte_msecs,
+						  success);
+}
 
 void NetJob::partSucceeded(int index)
 {
@@ -28,6 +56,9 @@ void NetJob::partSucceeded(int index)
 	auto &slot = parts_progress[index];
 	partProgress(index, slot.total_progress, slot.total_progress);
 
+	// a part that adopted another job's transfer didn't take part in any of the bookkeeping
+	if (!m_shared.remove(index))
+		finishAttempt(index, true);
 	m_doing.remove(index);
 	m_done.insert(index);
 	disconnect(downloads[index].get(), 0, this, 0);
@@ -36,18 +67,71 @@ void NetJob::partSucceeded(int index)
 
 void NetJob::partFailed(int index)
 {
+	finishAttempt(index, false);
 	m_doing.remove(index);
+	disconnect(downloads[index].get(), 0, this, 0);
 	auto &slot = parts_progress[index];
-	if (slot.failures == 3)
+	if (slot.failures >= MMC->settings()->get("NetMaxRetries").toInt())
 	{
 		m_failed.insert(index);
 	}
 	else
 	{
+		// exponential backoff with full jitter, so failed parts don't retry in lockstep
+		int base = MMC->settings()->get("NetRetryDelay").toInt();
+		int ceiling = base * (1 << qMin(slot.failures, 6));
+		std::uniform_int_distribution<int> jitter(0, qMax(0, ceiling));
+		int delay = jitter(m_rng);
 		slot.failures++;
-		m_todo.enqueue(index);
+		QLOG_INFO() << m_job_name.toLocal8Bit() << "retrying part" << index << "in" << delay
+					<< "ms";
+		if (!m_retryClock.isValid())
+			m_retryClock.start();
+		m_retrying.insert(m_retryClock.elapsed() + delay, index);
+		scheduleRetries();
 	}
-	disconnect(downloads[index].get(), 0, this, 0);
+	startMoreParts();
+}
+
+void NetJob::scheduleRetries()
+{
+	if (m_retrying.isEmpty())
+	{
+		m_retryTimer.stop();
+		return;
+	}
+	qint64 due = m_retrying.firstKey() - m_retryClock.elapsed();
+	m_retryTimer.start(qMax<qint64>(0, due));
+}
+
+void NetJob::sharedPartFinished(int index, bool success, NetActionPtr winner)
+{
+	if (!m_shared.contains(index))
+		return;
+	if (success)
+	{
+		// the action finishes through the usual signals, with the other action's results
+		auto part = downloads[index];
+		connect(part.get(), SIGNAL(succeeded(int)), SLOT(partSucceeded(int)));
+		part->adoptTransfer(winner);
+		return;
+	}
+	// the other job failed, so try again on our own
+	m_shared.remove(index);
+	m_doing.remove(index);
+	m_todo.prepend(index);
+	startMoreParts();
+}
+
+void NetJob::retryParts()
+{
+	qint64 now = m_retryClock.elapsed();
+	while (!m_retrying.isEmpty() && m_retrying.firstKey() <= now)
+	{
+		// retries go to the front, they were scheduled before everything still waiting
+		m_todo.prepend(m_retrying.take(m_retrying.firstKey()));
+	}
+	scheduleRetries();
 	startMoreParts();
 }
 
@@ -55,6 +139,11 @@ void NetJob::partProgress(int index, qint64 bytesReceived, qint64 bytesTotal)
 {
 	auto &slot = parts_progress[index];
 
+	if (slot.first_byte_msecs < 0 && bytesReceived > 0 && m_doing.contains(index))
+	{
+		slot.first_byte_msecs = slot.timer.elapsed();
+	}
+
 	current_progress -= slot.current_progress;
 	slot.current_progress = bytesReceived;
 	current_progress += slot.current_progress;
@@ -71,50 +160,104 @@ void NetJob::start()
 	m_running = true;
 	for (int i = 0; i < downloads.size(); i++)
 	{
-		m_todo.enqueue(i);
+		m_todo.append(i);
 	}
+	// big files first - the small ones fill the gaps while those are running
+	std::stable_sort(m_todo.begin(), m_todo.end(), [this](int a, int b)
+	{
+		return parts_progress[a].total_progress > parts_progress[b].total_progress;
+	});
+	// queued, the job reporting a finished transfer is still in the middle of its bookkeeping
+	connect(HostThrottle::notifier(), SIGNAL(capacityAvailable()), SLOT(startMoreParts()),
+			Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection));
 	// hack that delays early failures so they can be caught easier
 	QMetaObject::invokeMethod(this, "startMoreParts", Qt::QueuedConnection);
 }
 
+void NetJob::finishJob()
+{
+	m_running = false;
+	disconnect(HostThrottle::notifier(), 0, this, 0);
+	if (!m_failed.size())
+	{
+		QLOG_INFO() << m_job_name.toLocal8Bit() << "succeeded.";
+		emit succeeded();
+	}
+	else
+	{
+		QLOG_ERROR() << m_job_name.toLocal8Bit() << "failed.";
+		emit failed();
+	}
+}
+
+void NetJob::startPart(int index)
+{
+	auto &slot = parts_progress[index];
+	auto coordinator = MMC->downloadCoordinator();
+	m_doing.insert(index);
+	QString key = downloads[index]->sharingKey();
+	if (coordinator->isRunning(key))
+	{
+		// another job is getting the same thing right now
+		m_shared.insert(index);
+		coordinator->waitFor(key, this, index);
+		return;
+	}
+	coordinator->transferStarted(key, downloads[index]);
+	// the action's key may change while it runs (redirects)
+	slot.key = key;
+	slot.host = downloads[index]->m_url.host();
+	slot.first_byte_msecs = -1;
+	slot.timer.start();
+	HostThrottle::get(slot.host).transferStarted();
+
+	auto part = downloads[index];
+	// connect signals :D
+	connect(part.get(), SIGNAL(succeeded(int)), SLOT(partSucceeded(int)));
+	connect(part.get(), SIGNAL(failed(int)), SLOT(partFailed(int)));
+	connect(part.get(), SIGNAL(progress(int, qint64, qint64)),
+			SLOT(partProgress(int, qint64, qint64)));
+	part->start();
+}
+
 void NetJob::startMoreParts()
 {
 	// check for final conditions if there's nothing in the queue
 	if(!m_todo.size())
 	{
-		if(!m_doing.size())
+		if(m_running && !m_doing.size() && !m_retrying.size())
 		{
-			if(!m_failed.size())
-			{
-				QLOG_INFO() << m_job_name.toLocal8Bit() << "succeeded.";
-				emit succeeded();
-			}
-			else
-			{
-				QLOG_ERROR() << m_job_name.toLocal8Bit() << "failed.";
-				emit failed();
-			}
+			finishJob();
 		}
 		return;
 	}
-	// otherwise try to start more parts
-	while (m_doing.size() < 6)
+	// otherwise start everything the hosts and the global budget have room for, in queue order
+	auto coordinator = MMC->downloadCoordinator();
+	QSet<QString> fullHosts;
+	for (int i = 0; i < m_todo.size();)
 	{
-		if(!m_todo.size())
-			return;
-		int doThis = m_todo.dequeue();
-		m_doing.insert(doThis);
-		auto part = downloads[doThis];
-		// connect signals :D
-		connect(part.get(), SIGNAL(succeeded(int)), SLOT(partSucceeded(int)));
-		connect(part.get(), SIGNAL(failed(int)), SLOT(partFailed(int)));
-		connect(part.get(), SIGNAL(progress(int, qint64, qint64)),
-				SLOT(partProgress(int, qint64, qint64)));
-		part->start();
+		int index = m_todo[i];
+		QString key = downloads[index]->sharingKey();
+		// waiting for another job's transfer doesn't cost anything
+		if (!coordinator->isRunning(key) && !coordinator->canStart())
+			break;
+		QString host = downloads[index]->m_url.host();
+		if (fullHosts.contains(host))
+		{
+			i++;
+			continue;
+		}
+		if (!HostThrottle::get(host).canStart())
+		{
+			fullHosts.insert(host);
+			i++;
+			continue;
+		}
+		m_todo.removeAt(i);
+		startPart(index);
 	}
 }
 
-
 QStringList NetJob::getFailedFiles()
 {
 	QStringList failed;
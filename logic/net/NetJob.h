@@ -16,6 +16,9 @@
 #pragma once
 #include <QtNetwork>
 #include <QLabel>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <random>
 #include "NetAction.h"
 #include "ByteArrayDownload.h"
 #include "MD5EtagDownload.h"
@@ -31,8 +34,12 @@ class NetJob : public ProgressProvider
 {
 	Q_OBJECT
 public:
-	explicit NetJob(QString job_name) : ProgressProvider(), m_job_name(job_name) {}
-	virtual ~NetJob() {}
+	explicit NetJob(QString job_name) : ProgressProvider(), m_job_name(job_name)
+	{
+		m_retryTimer.setSingleShot(true);
+		connect(&m_retryTimer, SIGNAL(timeout()), SLOT(retryParts()));
+	}
+	virtual ~NetJob();
 	template <typename T> bool addNetAction(T action)
 	{
 		NetActionPtr base = std::static_pointer_cast<NetAction>(action);
@@ -46,15 +53,12 @@ public:
 		}
 		parts_progress.append(pi);
 		total_progress += pi.total_progress;
-		// if this is already running, the action needs to be started right away!
+		// if this is already running, the action needs to be scheduled right away!
 		if (isRunning())
 		{
 			emit progress(current_progress, total_progress);
-			connect(base.get(), SIGNAL(succeeded(int)), SLOT(partSucceeded(int)));
-			connect(base.get(), SIGNAL(failed(int)), SLOT(partFailed(int)));
-			connect(base.get(), SIGNAL(progress(int, qint64, qint64)),
-					SLOT(partProgress(int, qint64, qint64)));
-			base->start();
+			m_todo.append(base->m_index_within_job);
+			startMoreParts();
 		}
 		return true;
 	}
@@ -85,6 +89,9 @@ public:
 
 private slots:
 	void startMoreParts();
+	void retryParts();
+	/// a transfer this job was waiting for in another job ended
+	void sharedPartFinished(int index, bool success, NetActionPtr winner);
 
 signals:
 	void started();
@@ -108,15 +115,35 @@ private:
 		qint64 current_progress = 0;
 		qint64 total_progress = 1;
 		int failures = 0;
+		/// host the part was started against
+		QString host;
+		/// sharing key the part was started with
+		QString key;
+		/// measures the current attempt
+		QElapsedTimer timer;
+		qint64 first_byte_msecs = -1;
 	};
+	void startPart(int index);
+	void finishJob();
+	void scheduleRetries();
+	/// report the end of an attempt to the host throttle
+	void finishAttempt(int index, bool success);
+
 	QString m_job_name;
 	QList<NetActionPtr> downloads;
 	QList<part_info> parts_progress;
-	QQueue<int> m_todo;
+	QList<int> m_todo;
+	/// parts waiting to be retried, by the time they are due (on m_retryClock)
+	QMultiMap<qint64, int> m_retrying;
+	QElapsedTimer m_retryClock;
+	QTimer m_retryTimer;
 	QSet<int> m_doing;
+	/// running parts that wait for the same transfer in another job
+	QSet<int> m_shared;
 	QSet<int> m_done;
 	QSet<int> m_failed;
 	qint64 current_progress = 0;
 	qint64 total_progress = 0;
 	bool m_running = false;
+	std::mt19937 m_rng{std::random_device()()};
 };
@@ -0,0 +1,208 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PartialFile.h"
+
+#include <QNetworkReply>
+#include <QFileInfo>
+#include <pathutils.h>
+#include "logger/QsLog.h"
+
+PartialFile::PartialFile(QString target_path)
+	: m_target_path(target_path), m_part(target_path + ".part"),
+	  m_md5(QCryptographicHash::Md5)
+{
+}
+
+QString PartialFile::validatorPath() const
+{
+	return m_part.fileName() + ".validator";
+}
+
+bool PartialFile::rehash()
+{
+	if (!m_part.open(QIODevice::ReadOnly))
+		return false;
+	if (!m_part.seek(m_hashed))
+	{
+		m_part.close();
+		return false;
+	}
+	char buffer[64 * 1024];
+	qint64 read;
+	while ((read = m_part.read(buffer, sizeof(buffer))) > 0)
+	{
+		m_md5.addData(buffer, read);
+		m_hashed += read;
+	}
+	m_part.close();
+	return read == 0;
+}
+
+bool PartialFile::begin(QNetworkRequest &request)
+{
+	m_checkedReply = false;
+	m_ignoreData = false;
+	m_wroteAnyData = false;
+	m_offset = 0;
+	if (m_part.isOpen())
+		m_part.close();
+
+	if (!ensureFilePathExists(m_part.fileName()))
+		return false;
+
+	// the validator is remembered on disk, so a partial file can be picked up again later
+	if (m_validator.isEmpty())
+	{
+		QFile validator(validatorPath());
+		if (validator.open(QIODevice::ReadOnly))
+			m_validator = validator.readAll().trimmed();
+	}
+
+	qint64 existing = QFileInfo(m_part.fileName()).size();
+	if (existing > 0 && !m_validator.isEmpty())
+	{
+		// the hash carries over from the last attempt, only new data has to be read
+		if (m_hashed > existing)
+		{
+			m_md5.reset();
+			m_hashed = 0;
+		}
+		if (m_hashed == existing || rehash())
+		{
+			m_offset = existing;
+		}
+	}
+
+	QIODevice::OpenMode mode = QIODevice::WriteOnly;
+	if (m_offset)
+	{
+		mode |= QIODevice::Append;
+		request.setRawHeader("Range", "bytes=" + QByteArray::number(m_offset) + "-");
+		request.setRawHeader("If-Range", m_validator);
+		QLOG_INFO() << "Resuming" << m_target_path << "at byte" << m_offset;
+	}
+	else
+	{
+		mode |= QIODevice::Truncate;
+		m_md5.reset();
+		m_hashed = 0;
+		m_validator.clear();
+		QFile::remove(validatorPath());
+	}
+	return m_part.open(mode);
+}
+
+bool PartialFile::write(QNetworkReply *reply, const QByteArray &data)
+{
+	if (!m_checkedReply)
+	{
+		m_checkedReply = true;
+		int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+		if (status == 206 && m_offset)
+		{
+			// the rest of what we have. unless it's a different rest.
+			QByteArray range = reply->rawHeader("Content-Range");
+			QByteArray expected = "bytes " + QByteArray::number(m_offset) + "-";
+			if (!range.startsWith(expected))
+			{
+				QLOG_ERROR() << "Unexpected range" << range << "for" << m_target_path;
+				discard();
+				return false;
+			}
+		}
+		else if (status == 200 || (status == 0 && !reply->url().scheme().startsWith("http")))
+		{
+			// the whole file. start over
+			if (m_offset)
+			{
+				QLOG_INFO() << "Server sent all of" << m_target_path << "- not resuming";
+				m_part.resize(0);
+				m_part.seek(0);
+				m_md5.reset();
+				m_hashed = 0;
+				m_offset = 0;
+			}
+		}
+		else
+		{
+			// redirect bodies, error pages and the like
+			m_ignoreData = true;
+		}
+		QByteArray validator = reply->rawHeader("ETag");
+		if (validator.isEmpty() || validator.startsWith("W/"))
+			validator = reply->rawHeader("Last-Modified");
+		if (!m_ignoreData)
+			m_validator = validator;
+	}
+	if (m_ignoreData)
+		return true;
+	if (m_part.write(data) != data.size())
+		return false;
+	m_md5.addData(data);
+	m_hashed += data.size();
+	m_wroteAnyData = true;
+	return true;
+}
+
+bool PartialFile::commit()
+{
+	m_part.close();
+	QFile::remove(validatorPath());
+	if (QFile::exists(m_target_path) && !QFile::remove(m_target_path))
+		return false;
+	if (!m_part.rename(m_target_path))
+		return false;
+	// the part file object now points at the target, point it back
+	m_part.setFileName(m_target_path + ".part");
+	m_md5.reset();
+	m_hashed = 0;
+	m_validator.clear();
+	return true;
+}
+
+void PartialFile::keep(QNetworkReply *reply)
+{
+	m_part.close();
+	int status = reply ? reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() : 0;
+	// without a validator, there's no safe way to continue.
+	// 416 means the server doesn't agree with what we have.
+	if (m_validator.isEmpty() || m_part.size() == 0 || status == 416)
+	{
+		discard();
+		return;
+	}
+	QFile validator(validatorPath());
+	if (validator.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		validator.write(m_validator);
+	}
+}
+
+void PartialFile::discard()
+{
+	m_part.close();
+	m_part.remove();
+	QFile::remove(validatorPath());
+	m_md5.reset();
+	m_hashed = 0;
+	m_offset = 0;
+	m_validator.clear();
+}
+
+QString PartialFile::md5sum()
+{
+	return m_md5.result().toHex().constData();
+}
@@ -0,0 +1,95 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QCryptographicHash>
+#include <QNetworkRequest>
+
+class QNetworkReply;
+
+/**
+ * Download target that survives failed attempts.
+ *
+ * Data goes to '<target>.part', which is only moved over the target once the download is
+ * complete. When an attempt fails, the partial data is kept along with the validator
+ * (ETag or Last-Modified) of the response, so the next attempt can ask for the rest only,
+ * using a Range request guarded by If-Range. If the server sends the whole file instead,
+ * the partial data is thrown away.
+ *
+ * The MD5 of the data is computed as it is written and carries over between attempts.
+ */
+class PartialFile
+{
+public:
+	explicit PartialFile(QString target_path);
+
+	/**
+	 * Start a new attempt: open the part file and set up the request to continue where the
+	 * last attempt stopped, if that's possible.
+	 * Returns false if the part file couldn't be opened.
+	 */
+	bool begin(QNetworkRequest &request);
+
+	/// are we asking for the rest of a partial file?
+	bool resuming() const
+	{
+		return m_offset > 0;
+	}
+	/// bytes that were already there when this attempt started
+	qint64 offset() const
+	{
+		return m_offset;
+	}
+
+	/**
+	 * Write data from the reply. The first call checks the response status and drops the
+	 * partial data if the server didn't honor the range.
+	 */
+	bool write(QNetworkReply *reply, const QByteArray &data);
+
+	/// did this attempt write anything?
+	bool wroteAnyData() const
+	{
+		return m_wroteAnyData;
+	}
+
+	/// the attempt succeeded - move the data to the target
+	bool commit();
+	/// the attempt failed - keep what we have for the next one
+	void keep(QNetworkReply *reply);
+	/// the data is useless - remove it
+	void discard();
+
+	/// MD5 of everything written (including previous attempts), in hex
+	QString md5sum();
+
+private:
+	/// bring the hash up to date with the part file contents
+	bool rehash();
+	QString validatorPath() const;
+
+	QString m_target_path;
+	QFile m_part;
+	QCryptographicHash m_md5;
+	/// bytes of the part file already in m_md5
+	qint64 m_hashed = 0;
+	qint64 m_offset = 0;
+	QByteArray m_validator;
+	bool m_checkedReply = false;
+	bool m_ignoreData = false;
+	bool m_wroteAnyData = false;
+};
@@ -16,60 +16,101 @@
 #include "logic/settings/INIFile.h"
 
 #include <QFile>
-#include <QTextStream>
-#include <QStringList>
 #include <QSaveFile>
 #include <QDebug>
 
+#include <cstring>
+
 INIFile::INIFile()
 {
 }
 
-QString INIFile::unescape(QString orig)
+// Escapes are plain ASCII, so both directions work on the UTF-8 bytes directly.
+// A '#' has to be escaped too, otherwise the rest of the value reads back as a comment.
+static void escapeInto(QByteArray &out, const QByteArray &in)
 {
-	QString out;
-	QChar prev = 0;
-	for(auto c: orig)
+	const char *data = in.constData();
+	const int size = in.size();
+	for (int i = 0; i < size; i++)
 	{
-		if(prev == '\\')
-		{
-			if(c == 'n')
-				out += '\n';
-			else if (c == 't')
-				out += '\t';
-			else
-				out += c;
-			prev = 0;
-		}
-		else
+		const char c = data[i];
+		switch (c)
 		{
-			if(c == '\\')
-			{
-				prev = c;
-				continue;
-			}
-			out += c;
-			prev = 0;
+		case '\n':
+			out.append("\\n", 2);
+			break;
+		case '\r':
+			out.append("\\r", 2);
+			break;
+		case '\t':
+			out.append("\\t", 2);
+			break;
+		case '\\':
+			out.append("\\\\", 2);
+			break;
+		case '#':
+			out.append("\\#", 2);
+			break;
+		default:
+			out.append(c);
 		}
 	}
-	return out;
 }
 
-QString INIFile::escape(QString orig)
+static void unescapeInto(QByteArray &out, const char *data, int size)
 {
-	QString out;
-	for(auto c: orig)
+	for (int i = 0; i < size; i++)
 	{
-		if(c == '\n')
-			out += "\\n";
-		else if (c == '\t')
-			out += "\\t";
-		else if(c == '\\')
-			out += "\\\\";
+		char c = data[i];
+		if (c != '\\')
+		{
+			out.append(c);
+			continue;
+		}
+		// a trailing backslash is dropped
+		if (++i == size)
+			break;
+		c = data[i];
+		if (c == 'n')
+			out.append('\n');
+		else if (c == 'r')
+			out.append('\r');
+		else if (c == 't')
+			out.append('\t');
 		else
-			out += c;
+			out.append(c);
 	}
-	return out;
+}
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline void trim(const char *&begin, const char *&end)
+{
+	while (begin < end && isBlank(*begin))
+		begin++;
+	while (end > begin && isBlank(end[-1]))
+		end--;
+}
+
+QString INIFile::unescape(QString orig)
+{
+	QByteArray out;
+	const QByteArray in = orig.toUtf8();
+	out.reserve(in.size());
+	unescapeInto(out, in.constData(), in.size());
+	return QString::fromUtf8(out);
+}
+
+QString INIFile::escape(QString orig)
+{
+	QByteArray out;
+	const QByteArray in = orig.toUtf8();
+	out.reserve(in.size() + 16);
+	escapeInto(out, in);
+	return QString::fromUtf8(out);
 }
 
 bool INIFile::saveFile(QString fileName)
@@ -81,14 +122,14 @@ bool INIFile::saveFile(QString fileName)
 		return false;
 	}
 	QByteArray outArray;
+	// instance.cfg lines are short, this is usually enough to never grow
+	outArray.reserve(size() * 48);
 
-	for (Iterator iter = begin(); iter != end(); iter++)
+	for (ConstIterator iter = constBegin(); iter != constEnd(); iter++)
 	{
-		QString value = iter.value().toString();
-		value = escape(value);
 		outArray.append(iter.key().toUtf8());
 		outArray.append('=');
-		outArray.append(iter.value().toString().toUtf8());
+		escapeInto(outArray, iter.value().toString().toUtf8());
 		outArray.append('\n');
 	}
 	if(file.write(outArray) != outArray.size())
@@ -118,26 +159,67 @@ bool INIFile::loadFile(QString fileName)
 }
 bool INIFile::loadFile(QByteArray file)
 {
-	QTextStream in(file);
-	in.setCodec("UTF-8");
+	const char *pos = file.constData();
+	const char *const fileEnd = pos + file.size();
 
-	QStringList lines = in.readAll().split('\n');
-	for (int i = 0; i < lines.count(); i++)
-	{
-		QString &lineRaw = lines[i];
-		// Ignore comments.
-		QString line = lineRaw.left(lineRaw.indexOf('#')).trimmed();
+	// skip the UTF-8 BOM, like QTextStream did
+	if (file.startsWith("\xEF\xBB\xBF"))
+		pos += 3;
 
-		int eqPos = line.indexOf('=');
-		if (eqPos == -1)
-			continue;
-		QString key = line.left(eqPos).trimmed();
-		QString valueStr = line.right(line.length() - eqPos - 1).trimmed();
+	// only used for values that contain escapes, shared by all lines
+	QByteArray unescaped;
+	unescaped.reserve(256);
 
-		valueStr = unescape(valueStr);
+	while (pos < fileEnd)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(pos, '\n', fileEnd - pos));
+		if (!lineEnd)
+			lineEnd = fileEnd;
+
+		// one pass over the line: find the separator and the start of a comment
+		const char *eq = nullptr;
+		const char *end = pos;
+		bool escaped = false;
+		for (; end < lineEnd; end++)
+		{
+			const char c = *end;
+			if (c == '\\')
+			{
+				escaped = true;
+				// the escaped character can't end the line or separate the key
+				if (end + 1 < lineEnd)
+					end++;
+			}
+			else if (c == '#')
+				break;
+			else if (c == '=' && !eq)
+				eq = end;
+		}
 
-		QVariant value(valueStr);
-		this->operator[](key) = value;
+		if (eq)
+		{
+			const char *keyBegin = pos, *keyEnd = eq;
+			const char *valueBegin = eq + 1, *valueEnd = end;
+			trim(keyBegin, keyEnd);
+			trim(valueBegin, valueEnd);
+
+			QString key = QString::fromUtf8(keyBegin, keyEnd - keyBegin);
+			QString value;
+			if (escaped)
+			{
+				unescaped.resize(0);
+				unescapeInto(unescaped, valueBegin, valueEnd - valueBegin);
+				value = QString::fromUtf8(unescaped.constData(), unescaped.size());
+			}
+			else
+			{
+				value = QString::fromUtf8(valueBegin, valueEnd - valueBegin);
+			}
+			insert(key, QVariant(value));
+		}
+		if (lineEnd == fileEnd)
+			break;
+		pos = lineEnd + 1;
 	}
 
 	return true;
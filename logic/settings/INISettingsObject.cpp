@@ -16,23 +16,78 @@
 #include "INISettingsObject.h"
 #include "Setting.h"
 
+#include <QCoreApplication>
+
+// how long changes are collected before the file is saved
+const static int SAVE_DELAY_MS = 500;
+
 INISettingsObject::INISettingsObject(const QString &path, QObject *parent)
-	: SettingsObject(parent)
+	: INISettingsObject(path, INIFile(), parent)
 {
-	m_filePath = path;
 	m_ini.loadFile(path);
 }
 
+INISettingsObject::INISettingsObject(const QString &path, const INIFile &contents,
+									 QObject *parent)
+	: SettingsObject(parent), m_saveTimer(this)
+{
+	m_filePath = path;
+	m_ini = contents;
+	m_saveTimer.setSingleShot(true);
+	m_saveTimer.setInterval(SAVE_DELAY_MS);
+	connect(&m_saveTimer, SIGNAL(timeout()), SLOT(flush()));
+	connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(flush()));
+}
+
+INISettingsObject::~INISettingsObject()
+{
+	flush();
+}
+
 void INISettingsObject::setFilePath(const QString &filePath)
 {
+	// changes made so far belong to the old file
+	flush();
 	m_filePath = filePath;
 }
 
 bool INISettingsObject::reload()
 {
+	// don't throw away changes that weren't written yet
+	flush();
 	return m_ini.loadFile(m_filePath) && SettingsObject::reload();
 }
 
+void INISettingsObject::beginBatch()
+{
+	m_batchDepth++;
+}
+
+void INISettingsObject::commit()
+{
+	if (m_batchDepth == 0)
+		return;
+	m_batchDepth--;
+	if (m_batchDepth == 0 && m_dirty)
+		flush();
+}
+
+void INISettingsObject::flush()
+{
+	m_saveTimer.stop();
+	if (!m_dirty)
+		return;
+	m_dirty = false;
+	m_ini.saveFile(m_filePath);
+}
+
+void INISettingsObject::saveEventually()
+{
+	m_dirty = true;
+	if (m_batchDepth == 0 && !m_saveTimer.isActive())
+		m_saveTimer.start();
+}
+
 void INISettingsObject::changeSetting(const Setting &setting, QVariant value)
 {
 	if (contains(setting.id()))
@@ -51,7 +106,7 @@ void INISettingsObject::changeSetting(const Setting &setting, QVariant value)
 			for(auto iter: setting.configKeys())
 				m_ini.remove(iter);
 		}
-		m_ini.saveFile(m_filePath);
+		saveEventually();
 	}
 }
 
@@ -62,7 +117,7 @@ void INISettingsObject::resetSetting(const Setting &setting)
 	{
 		for(auto iter: setting.configKeys())
 			m_ini.remove(iter);
-		m_ini.saveFile(m_filePath);
+		saveEventually();
 	}
 }
 
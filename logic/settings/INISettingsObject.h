@@ -16,6 +16,7 @@
 #pragma once
 
 #include <QObject>
+#include <QTimer>
 
 #include "logic/settings/INIFile.h"
 
@@ -23,12 +24,18 @@
 
 /*!
  * \brief A settings object that stores its settings in an INIFile.
+ *
+ * Changes are written behind: the file is saved once after a short delay instead of after
+ * every change, when a batch is committed, when flush() is called and on shutdown.
  */
 class INISettingsObject : public SettingsObject
 {
 	Q_OBJECT
 public:
 	explicit INISettingsObject(const QString &path, QObject *parent = 0);
+	//! Uses contents that were already read from the file at path.
+	INISettingsObject(const QString &path, const INIFile &contents, QObject *parent = 0);
+	virtual ~INISettingsObject();
 
 	/*!
 	 * \brief Gets the path to the INI file.
@@ -47,6 +54,13 @@ public:
 
 	bool reload() override;
 
+	void beginBatch() override;
+	void commit() override;
+
+public
+slots:
+	void flush() override;
+
 protected
 slots:
 	virtual void changeSetting(const Setting &setting, QVariant value);
@@ -55,7 +69,15 @@ slots:
 protected:
 	virtual QVariant retrieveValue(const Setting &setting);
 
+	/// save the file later, after the batch or the save delay
+	void saveEventually();
+
 	INIFile m_ini;
 
 	QString m_filePath;
+
+	// a child, so it moves along when the object is moved to another thread
+	QTimer m_saveTimer;
+	bool m_dirty = false;
+	int m_batchDepth = 0;
 };
@@ -117,6 +117,28 @@ public:
 	 */
 	virtual bool reload();
 
+	/*!
+	 * \brief Holds back writing changed settings until commit() is called.
+	 * Use this around code that changes many settings at once. Batches can be nested.
+	 */
+	virtual void beginBatch()
+	{
+	}
+
+	/*!
+	 * \brief Ends a batch started with beginBatch() and writes the changes made during it.
+	 */
+	virtual void commit()
+	{
+	}
+
+	/*!
+	 * \brief Writes any changed settings that are still waiting to be written.
+	 */
+	virtual void flush()
+	{
+	}
+
 signals:
 	/*!
 	 * \brief Signal emitted when one of this SettingsObject object's settings changes.
@@ -0,0 +1,152 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ObjectStore.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <pathutils.h>
+
+#include "logger/QsLog.h"
+
+ObjectStore::ObjectStore(QString root) : m_root(root)
+{
+}
+
+QString ObjectStore::objectPath(const QString &hash) const
+{
+	return PathCombine(m_root, hash.left(2), hash);
+}
+
+bool ObjectStore::contains(const QString &hash) const
+{
+	return QFileInfo(objectPath(hash)).isFile();
+}
+
+QString ObjectStore::hashFile(const QString &path)
+{
+	QFile input(path);
+	if (!input.open(QIODevice::ReadOnly))
+		return QString();
+	QCryptographicHash sha1(QCryptographicHash::Sha1);
+	char buffer[64 * 1024];
+	qint64 read;
+	while ((read = input.read(buffer, sizeof(buffer))) > 0)
+	{
+		sha1.addData(buffer, read);
+	}
+	if (read < 0)
+		return QString();
+	return sha1.result().toHex();
+}
+
+QString ObjectStore::importFile(const QString &path)
+{
+	QString hash = hashFile(path);
+	if (hash.isEmpty())
+	{
+		QLOG_ERROR() << "Object store: couldn't read" << path;
+		return QString();
+	}
+	if (contains(hash))
+		return hash;
+
+	QString objPath = objectPath(hash);
+	if (!ensureFilePathExists(objPath))
+	{
+		QLOG_ERROR() << "Object store: couldn't create folder for" << objPath;
+		return QString();
+	}
+	// go through a temporary name so a half-written object is never visible.
+	// the source isn't linked, it may still be modified in place by its owner.
+	QString tempPath = objPath + ".part";
+	QFile::remove(tempPath);
+	if (!cloneFile(path, tempPath))
+	{
+		QLOG_ERROR() << "Object store: couldn't import" << path;
+		return QString();
+	}
+	if (!QFile::rename(tempPath, objPath))
+	{
+		QFile::remove(tempPath);
+		// somebody else may have stored the same object meanwhile
+		if (!contains(hash))
+			return QString();
+	}
+	return hash;
+}
+
+bool ObjectStore::materialize(const QString &hash, const QString &target)
+{
+	QString objPath = objectPath(hash);
+	if (!QFileInfo(objPath).isFile())
+		return false;
+	if (!ensureFilePathExists(target))
+		return false;
+	// the target is only replaced once the new link is in place
+	QString tempPath = target + ".part";
+	QFile::remove(tempPath);
+	// different file system, or one without hard links -> clone or copy instead
+	if (!hardlinkFile(objPath, tempPath) && !cloneFile(objPath, tempPath))
+		return false;
+	if (QFileInfo(target).exists() && !QFile::remove(target))
+	{
+		QFile::remove(tempPath);
+		return false;
+	}
+	return QFile::rename(tempPath, target);
+}
+
+bool ObjectStore::deduplicate(const QString &path)
+{
+	QString hash = importFile(path);
+	if (hash.isEmpty())
+		return false;
+	return materialize(hash, path);
+}
+
+qint64 ObjectStore::collectGarbage()
+{
+	qint64 reclaimed = 0;
+	int removed = 0;
+	QDirIterator iter(m_root, QDir::Files, QDirIterator::Subdirectories);
+	while (iter.hasNext())
+	{
+		QString path = iter.next();
+		if (path.endsWith(".part"))
+		{
+			reclaimed += iter.fileInfo().size();
+			QFile::remove(path);
+			continue;
+		}
+		if (fileLinkCount(path) != 1)
+			continue;
+		qint64 size = iter.fileInfo().size();
+		if (QFile::remove(path))
+		{
+			reclaimed += size;
+			removed++;
+		}
+	}
+	if (removed)
+	{
+		QLOG_INFO() << "Object store: removed" << removed << "unreferenced objects,"
+					<< reclaimed << "bytes reclaimed";
+	}
+	return reclaimed;
+}
@@ -0,0 +1,71 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <QString>
+
+/**
+ * A content addressed file store.
+ *
+ * Objects are keyed by the hex SHA-1 of their contents and live in
+ * <root>/<first two hash chars>/<hash>, the same layout used by assets/objects.
+ *
+ * Objects are handed out by materializing them at a target path: a hard link is used
+ * when possible, then a reflink, then a plain copy. Objects must therefore be treated
+ * as read-only by everything that receives them.
+ */
+class ObjectStore
+{
+public:
+	explicit ObjectStore(QString root);
+
+	/// path of the object with the given hash (it doesn't have to exist)
+	QString objectPath(const QString &hash) const;
+
+	/// is the object present in the store?
+	bool contains(const QString &hash) const;
+
+	/**
+	 * Add a copy of the file to the store.
+	 * Returns the hash of the file or an empty string on failure.
+	 */
+	QString importFile(const QString &path);
+
+	/**
+	 * Put the object with the given hash at the target path.
+	 * Any existing file at target is replaced.
+	 */
+	bool materialize(const QString &hash, const QString &target);
+
+	/**
+	 * Import the file and replace it with a link to the stored object.
+	 * Identical files deduplicated this way end up sharing storage.
+	 */
+	bool deduplicate(const QString &path);
+
+	/**
+	 * Remove all objects that are not linked from anywhere else.
+	 * Only objects materialized by hard link can be tracked this way - the others are
+	 * independent copies and the store keeps no record of them.
+	 * Returns the number of bytes reclaimed.
+	 */
+	qint64 collectGarbage();
+
+	/// SHA-1 of the file contents in hex, read in fixed-size chunks
+	static QString hashFile(const QString &path);
+
+private:
+	QString m_root;
+};
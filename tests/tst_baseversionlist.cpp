@@ -0,0 +1,129 @@
+#include <QTest>
+#include "TestUtil.h"
+
+#include "logic/BaseVersionList.h"
+
+struct TestVersion : public BaseVersion
+{
+	TestVersion(const QString &id, int time) : id(id), time(time)
+	{
+	}
+	QString descriptor() override
+	{
+		return id;
+	}
+	QString name() override
+	{
+		return id;
+	}
+	QString typeString() const override
+	{
+		return "test";
+	}
+	QString id;
+	int time;
+};
+
+class TestVersionList : public BaseVersionList
+{
+public:
+	Task *getLoadTask() override
+	{
+		return nullptr;
+	}
+	bool isLoaded() override
+	{
+		return true;
+	}
+	const BaseVersionPtr at(int i) const override
+	{
+		return m_vlist.at(i);
+	}
+	int count() const override
+	{
+		return m_vlist.count();
+	}
+	void sort() override
+	{
+		sortDescending(m_vlist, [](BaseVersionPtr version)
+		{ return std::dynamic_pointer_cast<TestVersion>(version)->time; });
+		rebuildLookup();
+	}
+	void setVersions(QList<BaseVersionPtr> versions)
+	{
+		updateListData(versions);
+	}
+
+protected:
+	void updateListData(QList<BaseVersionPtr> versions) override
+	{
+		m_vlist = versions;
+		sort();
+	}
+	QList<BaseVersionPtr> m_vlist;
+};
+
+class BaseVersionListTest : public QObject
+{
+	Q_OBJECT
+
+	static QList<BaseVersionPtr> makeVersions(int count)
+	{
+		QList<BaseVersionPtr> versions;
+		for (int i = 0; i < count; i++)
+		{
+			// not in order, so sorting has something to do
+			versions.append(BaseVersionPtr(new TestVersion(QString("1.%1").arg(i), (i * 7919) % count)));
+		}
+		return versions;
+	}
+
+private
+slots:
+	void test_findVersion()
+	{
+		TestVersionList list;
+		QVERIFY(!list.findVersion("1.0"));
+
+		auto versions = makeVersions(100);
+		auto duplicate = BaseVersionPtr(new TestVersion("1.5", 1000));
+		versions.append(duplicate);
+		list.setVersions(versions);
+
+		QCOMPARE(list.count(), 101);
+		QCOMPARE(list.findVersion("1.42")->descriptor(), QString("1.42"));
+		QVERIFY(!list.findVersion("2.0"));
+		// like a scan of the list would, the first of two equal descriptors is found
+		QCOMPARE(list.at(0), duplicate);
+		QCOMPARE(list.findVersion("1.5"), duplicate);
+	}
+
+	void test_sort()
+	{
+		TestVersionList list;
+		list.setVersions(makeVersions(1000));
+		for (int i = 1; i < list.count(); i++)
+		{
+			auto previous = std::dynamic_pointer_cast<TestVersion>(list.at(i - 1));
+			auto current = std::dynamic_pointer_cast<TestVersion>(list.at(i));
+			QVERIFY(previous->time >= current->time);
+		}
+	}
+
+	void test_findVersion_benchmark()
+	{
+		TestVersionList list;
+		list.setVersions(makeVersions(5000));
+		QBENCHMARK
+		{
+			for (int i = 0; i < 5000; i += 50)
+			{
+				QVERIFY(list.findVersion(QString("1.%1").arg(i)));
+			}
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(BaseVersionListTest)
+
+#include "tst_baseversionlist.moc"
@@ -0,0 +1,109 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "logic/forge/ForgeVersionList.h"
+
+class ForgeVersionListTest : public QObject
+{
+	Q_OBJECT
+
+	static void writeFile(const QString &path, const QByteArray &data)
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(data);
+	}
+	static void writeLists(const QDir &dir)
+	{
+		writeFile(dir.filePath("list.json"),
+				  "{\"builds\": [{\"build\": 100, \"files\": ["
+				  "{\"buildtype\": \"universal\", \"mcver\": \"1.5.2\", \"jobbuildver\": \"7.8.0.100\","
+				  " \"url\": \"http://files.example/forge-universal-100.zip\"},"
+				  "{\"buildtype\": \"installer\", \"url\": \"http://files.example/forge-installer-100.jar\"}"
+				  "]}]}");
+		writeFile(dir.filePath("json"),
+				  "{\"webpath\": \"http://files.example/maven\", \"artifact\": \"forge\", \"number\": {"
+				  "\"1200\": {\"build\": 1200, \"version\": \"10.13.0.1200\", \"mcversion\": \"1.7.10_pre4\","
+				  " \"files\": [[\"jar\", \"universal\", \"abc\"], [\"jar\", \"installer\", \"def\"]]},"
+				  "\"1300\": {\"build\": 1300, \"version\": \"10.13.2.1300\", \"mcversion\": \"1.7.10\","
+				  " \"branch\": \"new\", \"files\": [[\"jar\", \"installer\", \"ghi\"]]}}}");
+	}
+	static ForgeVersionPtr forge(const BaseVersionPtr &version)
+	{
+		return std::dynamic_pointer_cast<ForgeVersion>(version);
+	}
+
+private
+slots:
+	void test_parse()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		writeLists(dir);
+
+		auto result = ForgeListLoadTask::parseLists(dir.filePath("list.json"), dir.filePath("json"),
+													dir.filePath("versions.dat"), "key");
+		QVERIFY(result.error.isEmpty());
+		QVERIFY(!result.fromCache);
+		QCOMPARE(result.versions.size(), 3);
+
+		// newest build first
+		auto newest = forge(result.versions[0]);
+		QCOMPARE(newest->m_buildnr, 1300);
+		QCOMPARE(newest->installer_url,
+				 QString("http://files.example/maven/1.7.10-10.13.2.1300-new/"
+						 "forge-1.7.10-10.13.2.1300-new-installer.jar"));
+		QVERIFY(newest->universal_url.isEmpty());
+		QCOMPARE(forge(result.versions[1])->mcver_sane, QString("1.7.10-pre4"));
+		auto legacy = forge(result.versions[2]);
+		QCOMPARE(legacy->type, ForgeVersion::Legacy);
+		QCOMPARE(legacy->universal_filename, QString("forge-universal-100.zip"));
+		QCOMPARE(legacy->installer_filename, QString("forge-installer-100.jar"));
+	}
+
+	void test_cache()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		writeLists(dir);
+		auto parse = [&](const QString &key)
+		{
+			return ForgeListLoadTask::parseLists(dir.filePath("list.json"), dir.filePath("json"),
+												 dir.filePath("versions.dat"), key);
+		};
+		auto parsed = parse("key");
+
+		// the cache doesn't need the lists anymore
+		QFile::remove(dir.filePath("list.json"));
+		auto cached = parse("key");
+		QVERIFY(cached.error.isEmpty());
+		QVERIFY(cached.fromCache);
+		QCOMPARE(cached.versions.size(), parsed.versions.size());
+		for (int i = 0; i < parsed.versions.size(); i++)
+		{
+			auto expected = forge(parsed.versions[i]);
+			auto actual = forge(cached.versions[i]);
+			QCOMPARE(actual->type, expected->type);
+			QCOMPARE(actual->m_buildnr, expected->m_buildnr);
+			QCOMPARE(actual->branch, expected->branch);
+			QCOMPARE(actual->universal_url, expected->universal_url);
+			QCOMPARE(actual->installer_url, expected->installer_url);
+			QCOMPARE(actual->changelog_url, expected->changelog_url);
+			QCOMPARE(actual->jobbuildver, expected->jobbuildver);
+			QCOMPARE(actual->mcver, expected->mcver);
+			QCOMPARE(actual->mcver_sane, expected->mcver_sane);
+			QCOMPARE(actual->universal_filename, expected->universal_filename);
+			QCOMPARE(actual->installer_filename, expected->installer_filename);
+		}
+
+		// changed lists must be parsed again
+		auto changed = parse("other key");
+		QVERIFY(!changed.fromCache);
+		QVERIFY(!changed.error.isEmpty());
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(ForgeVersionListTest)
+
+#include "tst_forgeversionlist.moc"
@@ -0,0 +1,104 @@
+#include <QTest>
+#include <QStandardItemModel>
+#include <QScrollBar>
+#include "TestUtil.h"
+
+#include "gui/groupview/GroupView.h"
+#include "gui/groupview/InstanceDelegate.h"
+
+class GroupViewTest : public QObject
+{
+	Q_OBJECT
+
+	static QStandardItem *makeItem(const QString &name, const QString &group)
+	{
+		auto item = new QStandardItem(name);
+		item->setData(group, GroupViewRoles::GroupRole);
+		return item;
+	}
+	// spreads the items over a few groups, in model order
+	static void fill(QStandardItemModel &model, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			model.appendRow(makeItem(QString("Instance %1").arg(i), QString("Group %1").arg(i / 7)));
+		}
+	}
+	static QList<QRect> allRects(GroupView &view, QStandardItemModel &model)
+	{
+		QList<QRect> rects;
+		for (int i = 0; i < model.rowCount(); i++)
+		{
+			rects.append(view.visualRect(model.index(i, 0)));
+		}
+		return rects;
+	}
+	static void setup(GroupView &view, QStandardItemModel &model)
+	{
+		view.setItemDelegate(new ListViewDelegate(&view));
+		view.setModel(&model);
+		view.resize(400, 300);
+		view.show();
+		QCoreApplication::processEvents();
+		view.doItemsLayout();
+	}
+
+private
+slots:
+	void test_indexAt()
+	{
+		QStandardItemModel model;
+		fill(model, 50);
+		GroupView view;
+		setup(view, model);
+
+		for (int scroll : {0, view.verticalScrollBar()->maximum() / 2})
+		{
+			view.verticalScrollBar()->setValue(scroll);
+			for (int i = 0; i < model.rowCount(); i++)
+			{
+				const QModelIndex index = model.index(i, 0);
+				const QRect rect = view.visualRect(index);
+				QVERIFY(rect.isValid());
+				QCOMPARE(view.indexAt(rect.center()), index);
+				QCOMPARE(view.indexAt(rect.topLeft()), index);
+				QVERIFY(!view.indexAt(rect.topLeft() - QPoint(1, 1)).isValid());
+			}
+		}
+	}
+
+	void test_insertMatchesLayout()
+	{
+		QStandardItemModel model;
+		fill(model, 30);
+		GroupView view;
+		setup(view, model);
+
+		model.insertRow(3, makeItem("Inserted", "Group 0"));
+		model.insertRow(10, makeItem("New group", "Another group"));
+		model.appendRow(makeItem("Last", "Group 1"));
+		const QList<QRect> incremental = allRects(view, model);
+
+		view.doItemsLayout();
+		QCOMPARE(incremental, allRects(view, model));
+	}
+
+	void test_dataChangedMatchesLayout()
+	{
+		QStandardItemModel model;
+		fill(model, 30);
+		GroupView view;
+		setup(view, model);
+
+		// long enough to wrap onto more lines and make its row taller
+		model.item(8)->setText("An instance with a name that needs several lines of text");
+		const QList<QRect> incremental = allRects(view, model);
+
+		view.doItemsLayout();
+		QCOMPARE(incremental, allRects(view, model));
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(GroupViewTest)
+
+#include "tst_groupview.moc"
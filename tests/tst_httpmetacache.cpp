@@ -0,0 +1,186 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "logic/net/HttpMetaCache.h"
+
+class HttpMetaCacheTest : public QObject
+{
+	Q_OBJECT
+
+	static std::unique_ptr<HttpMetaCache> openCache(const QDir &dir)
+	{
+		std::unique_ptr<HttpMetaCache> cache(new HttpMetaCache(dir.filePath("metacache")));
+		cache->addBase("libraries", dir.filePath("libraries"));
+		cache->addBase("assets", dir.filePath("assets"));
+		cache->Load();
+		return cache;
+	}
+	static MetaEntryPtr makeEntry(const QString &base, const QString &path, const QString &md5)
+	{
+		MetaEntryPtr entry(new MetaEntry);
+		entry->base = base;
+		entry->path = path;
+		entry->md5sum = md5;
+		entry->etag = "\"" + md5 + "\"";
+		entry->local_changed_timestamp = 1234;
+		entry->remote_changed_timestamp = "Sat, 17 Oct 2026 00:00:00 GMT";
+		entry->stale = false;
+		return entry;
+	}
+	static void flipByte(const QString &path, qint64 offset)
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::ReadWrite));
+		QVERIFY(file.seek(offset));
+		char byte;
+		QVERIFY(file.getChar(&byte));
+		QVERIFY(file.seek(offset));
+		QVERIFY(file.putChar(byte ^ 0x5a));
+	}
+
+private
+slots:
+	void test_appendAndReload()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		{
+			auto cache = openCache(dir);
+			QVERIFY(cache->updateEntry(makeEntry("libraries", "a.jar", "aaaa")));
+			QVERIFY(cache->updateEntry(makeEntry("assets", "b.ogg", "bbbb")));
+			// a newer record replaces the older one
+			QVERIFY(cache->updateEntry(makeEntry("libraries", "a.jar", "cccc")));
+		}
+		QVERIFY(QFile::exists(dir.filePath("metacache.idx")));
+
+		auto cache = openCache(dir);
+		auto a = cache->getEntry("libraries", "a.jar");
+		QVERIFY(a.get());
+		QCOMPARE(a->md5sum, QString("cccc"));
+		QCOMPARE(a->etag, QString("\"cccc\""));
+		QCOMPARE(a->local_changed_timestamp, qint64(1234));
+		QCOMPARE(a->remote_changed_timestamp, QString("Sat, 17 Oct 2026 00:00:00 GMT"));
+		QVERIFY(!a->stale);
+		auto b = cache->getEntry("assets", "b.ogg");
+		QVERIFY(b.get());
+		QCOMPARE(b->md5sum, QString("bbbb"));
+		QVERIFY(!cache->getEntry("libraries", "b.ogg").get());
+	}
+
+	void test_truncatedRecord()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		const QString log = dir.filePath("metacache.idx");
+		{
+			auto cache = openCache(dir);
+			QVERIFY(cache->updateEntry(makeEntry("libraries", "a.jar", "aaaa")));
+		}
+		const qint64 intact = QFileInfo(log).size();
+		{
+			// a record cut off in the middle of writing it
+			QFile file(log);
+			QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+			file.write(QByteArray("\x00\x00\x00\x40partial", 11));
+		}
+
+		{
+			auto cache = openCache(dir);
+			QVERIFY(cache->getEntry("libraries", "a.jar").get());
+		}
+		QCOMPARE(QFileInfo(log).size(), intact);
+	}
+
+	void test_corruptRecord()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		const QString log = dir.filePath("metacache.idx");
+		qint64 intact;
+		{
+			auto cache = openCache(dir);
+			QVERIFY(cache->updateEntry(makeEntry("libraries", "a.jar", "aaaa")));
+			intact = QFileInfo(log).size();
+			QVERIFY(cache->updateEntry(makeEntry("libraries", "b.jar", "bbbb")));
+		}
+		// damage the payload of the last record, so its checksum doesn't match
+		flipByte(log, intact + 10);
+
+		{
+			auto cache = openCache(dir);
+			QVERIFY(cache->getEntry("libraries", "a.jar").get());
+			QVERIFY(!cache->getEntry("libraries", "b.jar").get());
+		}
+		QCOMPARE(QFileInfo(log).size(), intact);
+	}
+
+	void test_compaction()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		const QString log = dir.filePath("metacache.idx");
+		const QString gone = dir.filePath("libraries/gone.jar");
+		QVERIFY(QDir().mkpath(dir.filePath("libraries")));
+		qint64 before;
+		{
+			auto cache = openCache(dir);
+			QVERIFY(cache->updateEntry(makeEntry("libraries", "gone.jar", "dddd")));
+			for (int i = 0; i < 1500; i++)
+			{
+				QVERIFY(cache->updateEntry(makeEntry("libraries", "a.jar", QString::number(i))));
+			}
+			// the file isn't there, so the entry is dropped
+			QVERIFY(!QFile::exists(gone));
+			QVERIFY(cache->resolveEntry("libraries", "gone.jar")->stale);
+			before = QFileInfo(log).size();
+			cache->SaveNow();
+		}
+		// only the last record of the one live entry is left
+		QVERIFY(QFileInfo(log).size() < before / 100);
+
+		auto cache = openCache(dir);
+		auto a = cache->getEntry("libraries", "a.jar");
+		QVERIFY(a.get());
+		QCOMPARE(a->md5sum, QString("1499"));
+		QVERIFY(!cache->getEntry("libraries", "gone.jar").get());
+	}
+
+	void test_migrateJson()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		{
+			QFile legacy(dir.filePath("metacache"));
+			QVERIFY(legacy.open(QIODevice::WriteOnly));
+			legacy.write("{\"version\": \"1\", \"entries\": ["
+						 "{\"base\": \"libraries\", \"path\": \"a.jar\", \"md5sum\": \"aaaa\","
+						 " \"etag\": \"\\\"aaaa\\\"\", \"last_changed_timestamp\": 1234,"
+						 " \"remote_changed_timestamp\": \"yesterday\"},"
+						 "{\"base\": \"unknown\", \"path\": \"x.jar\", \"md5sum\": \"xxxx\"}"
+						 "]}");
+		}
+		{
+			auto cache = openCache(dir);
+			auto a = cache->getEntry("libraries", "a.jar");
+			QVERIFY(a.get());
+			QCOMPARE(a->md5sum, QString("aaaa"));
+			QCOMPARE(a->etag, QString("\"aaaa\""));
+			QCOMPARE(a->local_changed_timestamp, qint64(1234));
+			QCOMPARE(a->remote_changed_timestamp, QString("yesterday"));
+		}
+		// the old index is kept around under a new name, the new one takes over
+		QVERIFY(!QFile::exists(dir.filePath("metacache")));
+		QVERIFY(QFile::exists(dir.filePath("metacache.v1")));
+		QVERIFY(QFile::exists(dir.filePath("metacache.idx")));
+
+		auto cache = openCache(dir);
+		auto a = cache->getEntry("libraries", "a.jar");
+		QVERIFY(a.get());
+		QCOMPARE(a->md5sum, QString("aaaa"));
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(HttpMetaCacheTest)
+
+#include "tst_httpmetacache.moc"
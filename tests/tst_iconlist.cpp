@@ -0,0 +1,65 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QImageReader>
+#include "TestUtil.h"
+
+#include "logic/icons/IconList.h"
+#include "logic/settings/SettingsObject.h"
+
+class IconListTest : public QObject
+{
+	Q_OBJECT
+
+private
+slots:
+	void test_saveIcon()
+	{
+		QTemporaryDir iconDir;
+		QTemporaryDir targetDir;
+		MMC->settings()->set("IconsDir", iconDir.path());
+		IconList list;
+
+		const QString path = QDir(targetDir.path()).absoluteFilePath("icon.png");
+		QVERIFY(list.saveIcon("infinity", path, 128));
+		QImageReader reader(path);
+		QCOMPARE(reader.size(), QSize(128, 128));
+
+		// same stamp, different picture. an unchanged icon must leave the file alone
+		const QString stamp = reader.text("MultiMC-Icon");
+		QVERIFY(!stamp.isEmpty());
+		QImage other(16, 16, QImage::Format_ARGB32);
+		other.fill(Qt::red);
+		other.setText("MultiMC-Icon", stamp);
+		QVERIFY(other.save(path, "PNG"));
+		QVERIFY(list.saveIcon("infinity", path, 128));
+		QCOMPARE(QImageReader(path).size(), QSize(16, 16));
+
+		// a different size is a different icon
+		QVERIFY(list.saveIcon("infinity", path, 64));
+		QCOMPARE(QImageReader(path).size(), QSize(64, 64));
+	}
+
+	void test_thumbnail()
+	{
+		QTemporaryDir iconDir;
+		QImage big(600, 600, QImage::Format_ARGB32);
+		big.fill(Qt::blue);
+		QVERIFY(big.save(QDir(iconDir.path()).absoluteFilePath("bigicon.png"), "PNG"));
+		MMC->settings()->set("IconsDir", iconDir.path());
+		IconList list;
+
+		QCOMPARE(list.getPixmap("bigicon", 48).size(), QSize(48, 48));
+		QCOMPARE(list.getPixmap("bigicon", 256).size(), QSize(256, 256));
+
+		QDir thumbnails("cache/icons");
+		auto made = thumbnails.entryList({"bigicon.*.png"}, QDir::Files);
+		QCOMPARE(made.size(), 1);
+		QCOMPARE(QImageReader(thumbnails.filePath(made.first())).size(), QSize(256, 256));
+		QFile::remove(thumbnails.filePath(made.first()));
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(IconListTest)
+
+#include "tst_iconlist.moc"
@@ -1,4 +1,6 @@
 #include <QTest>
+#include <QTemporaryDir>
+#include <QDir>
 #include "TestUtil.h"
 
 #include "logic/settings/INIFile.h"
@@ -26,6 +28,8 @@ slots:
 		QTest::newRow("Plain text") << "Lorem ipsum dolor sit amet.";
 		QTest::newRow("Escape sequences") << "Lorem\n\t\n\\n\\tAAZ\nipsum dolor\n\nsit amet.";
 		QTest::newRow("Escape sequences 2") << "\"\n\n\"";
+		QTest::newRow("Comment character") << "-Dfoo=#bar \\# baz";
+		QTest::newRow("Unicode") << QString::fromUtf8("M\xC3\xA1jnsv\xC3\xA1\xC3\xB0i\r\n\xE2\x9C\x93");
 	}
 	void test_PathCombine1()
 	{
@@ -36,6 +40,82 @@ slots:
 		
 		QCOMPARE(back, through);
 	}
+
+	void test_SaveLoad_data()
+	{
+		test_PathCombine1_data();
+	}
+	void test_SaveLoad()
+	{
+		QFETCH(QString, through);
+
+		QTemporaryDir tempDir;
+		QString fileName = QDir(tempDir.path()).absoluteFilePath("test.cfg");
+		INIFile out;
+		out.set("value", through);
+		out.set("other", "abc");
+		QVERIFY(out.saveFile(fileName));
+
+		INIFile in;
+		QVERIFY(in.loadFile(fileName));
+		QCOMPARE(in.size(), 2);
+		QCOMPARE(in.get("value", QVariant()).toString(), through);
+		QCOMPARE(in.get("other", QVariant()).toString(), QString("abc"));
+	}
+
+	void test_Parse()
+	{
+		INIFile ini;
+		QVERIFY(ini.loadFile(QByteArray("\xEF\xBB\xBF# comment\r\n"
+										"  name = Some Instance  \r\n"
+										"no separator\n"
+										"JvmArgs=-Xss1M # trailing comment\n"
+										"path=C:\\\\Games\\\\mc\n"
+										"empty=\n"
+										"last=1")));
+		QCOMPARE(ini.size(), 5);
+		QCOMPARE(ini.get("name", QVariant()).toString(), QString("Some Instance"));
+		QCOMPARE(ini.get("JvmArgs", QVariant()).toString(), QString("-Xss1M"));
+		QCOMPARE(ini.get("path", QVariant()).toString(), QString("C:\\Games\\mc"));
+		QCOMPARE(ini.get("empty", QVariant("x")).toString(), QString());
+		QCOMPARE(ini.get("last", QVariant()).toString(), QString("1"));
+	}
+
+	// every iteration parses one instance.cfg sized file, so files/sec is 1 / time per iteration
+	void test_Load_benchmark()
+	{
+		INIFile source;
+		source.set("name", QString::fromUtf8("Some Instance \xE2\x9C\x93"));
+		source.set("iconKey", "infinity");
+		source.set("InstanceType", "OneSix");
+		source.set("IntendedVersion", "1.7.10");
+		source.set("JvmArgs", "-XX:+UseConcMarkSweepGC -Dfml.ignoreInvalidMinecraftCertificates=true");
+		source.set("JavaPath", "C:\\Program Files\\Java\\jre7\\bin\\javaw.exe");
+		source.set("notes", "Line one\nLine two\n\tindented # not a comment");
+		source.set("lastLaunchTime", "1420070400000");
+		source.set("totalTimePlayed", "123456");
+		for (int i = 0; i < 16; i++)
+		{
+			source.set(QString("Override%1").arg(i), "false");
+		}
+
+		QTemporaryDir tempDir;
+		QString fileName = QDir(tempDir.path()).absoluteFilePath("instance.cfg");
+		QVERIFY(source.saveFile(fileName));
+		QFile file(fileName);
+		QVERIFY(file.open(QFile::ReadOnly));
+		const QByteArray data = file.readAll();
+
+		QBENCHMARK
+		{
+			INIFile ini;
+			ini.loadFile(data);
+		}
+
+		INIFile check;
+		QVERIFY(check.loadFile(data));
+		QVERIFY(check == source);
+	}
 };
 
 QTEST_GUILESS_MAIN_MULTIMC(IniFileTest)
@@ -0,0 +1,125 @@
+#include <QTest>
+#include <QStandardItemModel>
+#include <QImage>
+#include <QPainter>
+#include <QApplication>
+#include "TestUtil.h"
+
+#include "gui/groupview/InstanceDelegate.h"
+
+class InstanceDelegateTest : public QObject
+{
+	Q_OBJECT
+
+	static void fill(QStandardItemModel &model, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			model.appendRow(new QStandardItem(QString("Instance number %1").arg(i)));
+		}
+	}
+	// paints the whole model as a grid, like the instance view does
+	static void paintGrid(QAbstractItemDelegate &delegate, QStandardItemModel &model, QImage &image)
+	{
+		QPainter painter(&image);
+		QStyleOptionViewItem option;
+		option.palette = QApplication::palette();
+		option.font = QApplication::font();
+		option.state = QStyle::State_Enabled | QStyle::State_Active;
+		const int perRow = image.width() / 105;
+		for (int i = 0; i < model.rowCount(); i++)
+		{
+			const QModelIndex index = model.index(i, 0);
+			const QSize size = delegate.sizeHint(option, index);
+			option.rect = QRect(QPoint(5 + (i % perRow) * 105, 5 + (i / perRow) * 105), size);
+			delegate.paint(&painter, option, index);
+		}
+	}
+
+	// largest difference of any channel of any pixel, the images have to be the same size
+	static int maxDifference(const QImage &a, const QImage &b)
+	{
+		int result = 0;
+		for (int y = 0; y < a.height(); y++)
+		{
+			auto lineA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+			auto lineB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+			for (int x = 0; x < a.width(); x++)
+			{
+				result = qMax(result, qAbs(qRed(lineA[x]) - qRed(lineB[x])));
+				result = qMax(result, qAbs(qGreen(lineA[x]) - qGreen(lineB[x])));
+				result = qMax(result, qAbs(qBlue(lineA[x]) - qBlue(lineB[x])));
+				result = qMax(result, qAbs(qAlpha(lineA[x]) - qAlpha(lineB[x])));
+			}
+		}
+		return result;
+	}
+
+private
+slots:
+	void test_cachedMatchesUncached()
+	{
+		QStandardItemModel model;
+		fill(model, 20);
+		QImage first(1050, 220, QImage::Format_ARGB32_Premultiplied);
+		first.fill(Qt::white);
+		QImage second = first;
+
+		ListViewDelegate delegate;
+		paintGrid(delegate, model, first);
+		paintGrid(delegate, model, second);
+		QCOMPARE(second, first);
+
+		// a cached tile has to look like one painted straight into the view. blending the
+		// translucent tile onto the background may round a little differently, nothing more.
+		QImage direct = first;
+		direct.fill(Qt::white);
+		ListViewDelegate uncached;
+		uncached.setTileCacheEnabled(false);
+		paintGrid(uncached, model, direct);
+		QCOMPARE(direct.size(), second.size());
+		QVERIFY(maxDifference(direct, second) <= 2);
+
+		// renaming has to show up, even though the tile was cached
+		model.item(3)->setText("Renamed");
+		QImage renamed = first;
+		renamed.fill(Qt::white);
+		paintGrid(delegate, model, renamed);
+		QVERIFY(renamed != first);
+	}
+
+	void test_paint_benchmark_data()
+	{
+		QTest::addColumn<bool>("cached");
+
+		QTest::newRow("first frame") << false;
+		QTest::newRow("repaint") << true;
+	}
+	void test_paint_benchmark()
+	{
+		QFETCH(bool, cached);
+
+		QStandardItemModel model;
+		fill(model, 1000);
+		QImage image(1050, 10600, QImage::Format_ARGB32_Premultiplied);
+
+		ListViewDelegate delegate;
+		paintGrid(delegate, model, image);
+		QBENCHMARK
+		{
+			if (cached)
+			{
+				paintGrid(delegate, model, image);
+			}
+			else
+			{
+				ListViewDelegate fresh;
+				paintGrid(fresh, model, image);
+			}
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(InstanceDelegateTest)
+
+#include "tst_instancedelegate.moc"
@@ -0,0 +1,105 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <quazip.h>
+#include <quazipfile.h>
+#include "TestUtil.h"
+
+#include "logic/JarUtils.h"
+
+class JarUtilsTest : public QObject
+{
+	Q_OBJECT
+
+	static void writeFile(const QString &path, const QByteArray &data)
+	{
+		QDir().mkpath(QFileInfo(path).absolutePath());
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(data);
+	}
+	static void makeZip(const QString &path, const QMap<QString, QByteArray> &entries)
+	{
+		QuaZip zip(path);
+		QVERIFY(zip.open(QuaZip::mdCreate));
+		for (auto it = entries.begin(); it != entries.end(); ++it)
+		{
+			QuaZipFile file(&zip);
+			QVERIFY(file.open(QIODevice::WriteOnly, QuaZipNewInfo(it.key())));
+			file.write(it.value());
+			file.close();
+		}
+		zip.close();
+	}
+	static QByteArray readEntry(const QString &path, const QString &entry)
+	{
+		QuaZip zip(path);
+		if (!zip.open(QuaZip::mdUnzip) || !zip.setCurrentFile(entry))
+			return QByteArray();
+		QuaZipFile file(&zip);
+		if (!file.open(QIODevice::ReadOnly))
+			return QByteArray();
+		return file.readAll();
+	}
+
+private
+slots:
+	void test_build()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		makeZip(dir.filePath("minecraft.jar"), {{"a.class", "base"}, {"META-INF/MOJANG.SF", "sig"}});
+		makeZip(dir.filePath("mod.zip"), {{"a.class", "mod"}});
+		const QString jar = dir.filePath("modded.jar");
+
+		QList<Mod> mods{Mod(QFileInfo(dir.filePath("mod.zip")), false)};
+		bool rebuilt = false;
+		QVERIFY(JarUtils::createModdedJar(dir.filePath("minecraft.jar"), jar, mods, &rebuilt));
+		QVERIFY(rebuilt);
+		QCOMPARE(readEntry(jar, "a.class"), QByteArray("mod"));
+		QVERIFY(readEntry(jar, "META-INF/MOJANG.SF").isNull());
+
+		// same inputs, nothing to do
+		QVERIFY(JarUtils::createModdedJar(dir.filePath("minecraft.jar"), jar, mods, &rebuilt));
+		QVERIFY(!rebuilt);
+
+		// an identical jar in its place, like one linked from the object store, is fine too
+		QVERIFY(QFile::copy(jar, jar + ".copy"));
+		QVERIFY(QFile::remove(jar));
+		QVERIFY(QFile::rename(jar + ".copy", jar));
+		QVERIFY(JarUtils::createModdedJar(dir.filePath("minecraft.jar"), jar, mods, &rebuilt));
+		QVERIFY(!rebuilt);
+		QCOMPARE(readEntry(jar, "a.class"), QByteArray("mod"));
+
+		// removing the mod brings back the base class
+		QVERIFY(JarUtils::createModdedJar(dir.filePath("minecraft.jar"), jar, QList<Mod>()));
+		QCOMPARE(readEntry(jar, "a.class"), QByteArray("base"));
+	}
+
+	void test_removeShadowingMod()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		makeZip(dir.filePath("minecraft.jar"), {{"a.class", "base"}});
+		writeFile(dir.filePath("folder/b.class"), "folder");
+		writeFile(dir.filePath("folder/c.class"), "folder");
+		// the zip comes later, so it wins over the folder mod
+		makeZip(dir.filePath("shadow.zip"), {{"folder/b.class", "zip"}});
+		const QString jar = dir.filePath("modded.jar");
+
+		Mod folder(QFileInfo(dir.filePath("folder")), false);
+		Mod shadow(QFileInfo(dir.filePath("shadow.zip")), false);
+		QVERIFY(JarUtils::createModdedJar(dir.filePath("minecraft.jar"), jar, {folder, shadow}));
+		QCOMPARE(readEntry(jar, "folder/b.class"), QByteArray("zip"));
+		QCOMPARE(readEntry(jar, "folder/c.class"), QByteArray("folder"));
+
+		// the folder mod didn't change, but the entry it lost to the zip has to come back
+		QVERIFY(JarUtils::createModdedJar(dir.filePath("minecraft.jar"), jar, {folder}));
+		QCOMPARE(readEntry(jar, "folder/b.class"), QByteArray("folder"));
+		QCOMPARE(readEntry(jar, "folder/c.class"), QByteArray("folder"));
+		QCOMPARE(readEntry(jar, "a.class"), QByteArray("base"));
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(JarUtilsTest)
+
+#include "tst_jarutils.moc"
@@ -0,0 +1,86 @@
+#include <QTest>
+#include <QSignalSpy>
+#include "TestUtil.h"
+
+#include "logic/LogModel.h"
+
+class LogModelTest : public QObject
+{
+	Q_OBJECT
+
+	static LogBlock makeLines(int first, int count)
+	{
+		LogBlock lines;
+		for (int i = first; i < first + count; i++)
+		{
+			lines.append(LogLine{QString("line %1").arg(i), MessageLevel::Message});
+		}
+		return lines;
+	}
+	static QString text(const LogModel &model, int row)
+	{
+		return model.data(model.index(row)).toString();
+	}
+
+private
+slots:
+	void test_append()
+	{
+		LogModel model(100);
+		QCOMPARE(model.append(makeLines(0, 10)), 0);
+		QCOMPARE(model.append({LogLine{"multi\nline\n", MessageLevel::MultiMC}}), 0);
+		QCOMPARE(model.rowCount(), 12);
+		QCOMPARE(text(model, 10), QString("multi"));
+		QCOMPARE(text(model, 11), QString("line"));
+	}
+
+	void test_wrap()
+	{
+		LogModel model(10);
+		QSignalSpy removes(&model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+		model.append(makeLines(0, 8));
+		QCOMPARE(model.append(makeLines(8, 5)), 3);
+		QCOMPARE(removes.count(), 1);
+		QCOMPARE(model.rowCount(), 10);
+		QCOMPARE(text(model, 0), QString("line 3"));
+		QCOMPARE(text(model, 9), QString("line 12"));
+
+		// a batch bigger than the whole log
+		QCOMPARE(model.append(makeLines(13, 25)), 10);
+		QCOMPARE(model.rowCount(), 10);
+		QCOMPARE(text(model, 0), QString("line 28"));
+		QCOMPARE(text(model, 9), QString("line 37"));
+		QCOMPARE(model.toPlainText().count('\n'), 10);
+
+		model.setMaxLines(4);
+		QCOMPARE(model.rowCount(), 4);
+		QCOMPARE(text(model, 0), QString("line 34"));
+		model.append(makeLines(38, 1));
+		QCOMPARE(text(model, 0), QString("line 35"));
+		QCOMPARE(text(model, 3), QString("line 38"));
+	}
+
+	void test_find()
+	{
+		LogModel model(10);
+		model.append(makeLines(0, 15));
+		QCOMPARE(model.find("LINE 1", 0), 5);
+		QCOMPARE(model.find("line 1", 6), 6);
+		QCOMPARE(model.find("line 1", 9, true), 9);
+		QCOMPARE(model.find("line 2", 0), -1);
+	}
+
+	void test_append_benchmark()
+	{
+		LogModel model(100000);
+		const LogBlock lines = makeLines(0, 1000);
+		QBENCHMARK
+		{
+			model.append(lines);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(LogModelTest)
+
+#include "tst_logmodel.moc"
@@ -0,0 +1,127 @@
+#include <QTest>
+#include <QSignalSpy>
+#include "TestUtil.h"
+
+#include "logic/LogProcessor.h"
+
+Q_DECLARE_METATYPE(MessageLevel::Enum)
+
+class LogProcessorTest : public QObject
+{
+	Q_OBJECT
+
+	static LogBlock collect(QSignalSpy &spy)
+	{
+		LogBlock lines;
+		for (auto &args : spy)
+		{
+			lines.append(args.at(0).value<LogBlock>());
+		}
+		return lines;
+	}
+
+private
+slots:
+	void test_split()
+	{
+		LogProcessor processor;
+		QSignalSpy spy(&processor, SIGNAL(linesReady(LogBlock)));
+		processor.appendOutput("first\r\nsec", LogProcessor::StdOut);
+		processor.appendOutput("ond\nthi", LogProcessor::StdOut);
+		processor.appendOutput("err\n", LogProcessor::StdErr);
+		processor.appendMessage("message", MessageLevel::MultiMC);
+		processor.finishChannel(LogProcessor::StdOut);
+		processor.flush();
+
+		QCOMPARE(spy.count(), 1);
+		LogBlock lines = collect(spy);
+		QCOMPARE(lines.size(), 5);
+		QCOMPARE(lines[0].text, QString("first"));
+		QCOMPARE(lines[1].text, QString("second"));
+		QCOMPARE(lines[2].text, QString("err"));
+		QCOMPARE(lines[2].level, MessageLevel::Error);
+		QCOMPARE(lines[3].text, QString("message"));
+		QCOMPARE(lines[3].level, MessageLevel::MultiMC);
+		QCOMPARE(lines[4].text, QString("thi"));
+	}
+
+	void test_guessLevel_data()
+	{
+		QTest::addColumn<QString>("line");
+		QTest::addColumn<MessageLevel::Enum>("level");
+
+		QTest::newRow("log4j info") << "[12:00:00] [Client thread/INFO]: Setting user: Player"
+									<< MessageLevel::Message;
+		QTest::newRow("log4j warn") << "[12:00:00] [Client thread/WARN]: Skipping bad option"
+									<< MessageLevel::Warning;
+		QTest::newRow("log4j debug") << "[12:00:00] [main/DEBUG]: Loading" << MessageLevel::Debug;
+		QTest::newRow("forge severe") << "2014-01-01 12:00:00 [SEVERE] [ForgeModLoader] Oops"
+									  << MessageLevel::Error;
+		QTest::newRow("stack trace") << "\tat net.minecraft.client.Minecraft.run(Minecraft.java:1)"
+									 << MessageLevel::Error;
+		QTest::newRow("plain") << "Nothing to see here" << MessageLevel::Message;
+	}
+	void test_guessLevel()
+	{
+		QFETCH(QString, line);
+		QFETCH(MessageLevel::Enum, level);
+
+		LogProcessor processor;
+		QCOMPARE(processor.guessLevel(line, MessageLevel::Message), level);
+	}
+
+	void test_censor()
+	{
+		auto session = std::make_shared<AuthSession>();
+		session->access_token = "0123abcd";
+		session->session = "token:0123abcd:fedc";
+		session->uuid = "fedc";
+		session->player_name = "Player";
+
+		LogProcessor processor;
+		processor.setSession(session);
+		QCOMPARE(processor.censor("--session token:0123abcd:fedc --uuid fedc"),
+				 QString("--session <SESSION ID> --uuid <PROFILE ID>"));
+		QCOMPARE(processor.censor("Setting user: Player, 0123abcd"),
+				 QString("Setting user: <PROFILE NAME>, <ACCESS TOKEN>"));
+		QCOMPARE(processor.censor("nothing private"), QString("nothing private"));
+
+		QSignalSpy spy(&processor, SIGNAL(linesReady(LogBlock)));
+		processor.appendOutput("Player\n", LogProcessor::StdOut);
+		processor.appendOutput("Player\n", LogProcessor::PrePostOut);
+		processor.flush();
+		LogBlock lines = collect(spy);
+		QCOMPARE(lines.size(), 2);
+		QCOMPARE(lines[0].text, QString("<PROFILE NAME>"));
+		QCOMPARE(lines[1].text, QString("Player"));
+		QCOMPARE(lines[1].level, MessageLevel::PrePost);
+	}
+
+	void test_append_benchmark()
+	{
+		auto session = std::make_shared<AuthSession>();
+		session->access_token = "0123456789abcdef0123456789abcdef";
+		session->session = "token:0123456789abcdef0123456789abcdef:fedcba9876543210";
+		session->uuid = "fedcba9876543210";
+		session->player_name = "Player";
+
+		QByteArray chunk;
+		for (int i = 0; i < 100; i++)
+		{
+			chunk += "[12:00:00] [Client thread/INFO]: Loaded 42 textures from the resource pack\n";
+			chunk += "\tat net.minecraft.client.renderer.texture.TextureMap.loadTexture(TextureMap.java:52)\n";
+		}
+
+		LogProcessor processor;
+		processor.setSession(session);
+		QBENCHMARK
+		{
+			processor.appendOutput(chunk, LogProcessor::StdOut);
+			processor.flush();
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(LogProcessorTest)
+
+#include "tst_logprocessor.moc"
@@ -0,0 +1,55 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include "TestUtil.h"
+
+#include "logic/net/MD5EtagDownload.h"
+
+class MD5EtagDownloadTest : public QObject
+{
+	Q_OBJECT
+
+	static void writeFile(const QString &path, const QByteArray &data)
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write(data);
+	}
+
+private
+slots:
+	void test_retryAfterFailure()
+	{
+		QTemporaryDir tmp;
+		QDir dir(tmp.path());
+		writeFile(dir.filePath("source.txt"), "some content");
+		const QString target = dir.filePath("target/file.txt");
+
+		auto dl = MD5EtagDownload::make(QUrl::fromLocalFile(dir.filePath("source.txt")), target);
+		QSignalSpy succeeded(dl.get(), SIGNAL(succeeded(int)));
+		QSignalSpy failed(dl.get(), SIGNAL(failed(int)));
+
+		// the first attempt gets something else than expected
+		dl->m_expected_md5 = "00000000000000000000000000000000";
+		dl->start();
+		QVERIFY(failed.wait());
+		QCOMPARE(succeeded.count(), 0);
+		QCOMPARE(dl->m_status, Job_Failed);
+		QVERIFY(!QFile::exists(target));
+
+		// the next one has to be able to finish
+		dl->m_expected_md5 = QCryptographicHash::hash("some content", QCryptographicHash::Md5)
+								 .toHex()
+								 .constData();
+		dl->start();
+		QVERIFY(succeeded.wait());
+		QCOMPARE(failed.count(), 1);
+		QCOMPARE(dl->m_status, Job_Finished);
+		QCOMPARE(TestsInternal::readFile(target), QByteArray("some content"));
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(MD5EtagDownloadTest)
+
+#include "tst_md5etagdownload.moc"
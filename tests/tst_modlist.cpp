@@ -0,0 +1,110 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "logic/ModList.h"
+
+class ModListTest : public QObject
+{
+	Q_OBJECT
+
+	// single file mods have no metadata to read, so only the list itself is measured
+	static void makeMod(const QDir &dir, const QString &name)
+	{
+		QFile file(dir.absoluteFilePath(name));
+		file.open(QFile::WriteOnly);
+		file.write(name.toUtf8());
+	}
+	// leaves gaps in the numbering, so there is room to add mods in between
+	static void makeMods(const QDir &dir, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			makeMod(dir, QString("mod%1.class").arg(i * 2, 4, 10, QChar('0')));
+		}
+	}
+
+private
+slots:
+	void test_addRemove()
+	{
+		QTemporaryDir tempDir;
+		QDir dir(tempDir.path());
+		makeMods(dir, 10);
+		ModList list(dir.absolutePath());
+		list.update();
+		QCOMPARE(list.rowCount(), 10);
+
+		QSignalSpy resets(&list, SIGNAL(modelReset()));
+		QSignalSpy inserts(&list, SIGNAL(rowsInserted(QModelIndex, int, int)));
+		QSignalSpy removes(&list, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+
+		makeMod(dir, "mod0009.class");
+		list.update();
+		QCOMPARE(list.rowCount(), 11);
+		QCOMPARE(inserts.count(), 1);
+		QCOMPARE(inserts.first().at(1).toInt(), 5);
+		QCOMPARE(list[5].mmc_id(), QString("mod0009.class"));
+
+		QVERIFY(dir.remove("mod0000.class"));
+		list.update();
+		QCOMPARE(list.rowCount(), 10);
+		QCOMPARE(removes.count(), 1);
+		QCOMPARE(removes.first().at(1).toInt(), 0);
+		QCOMPARE(resets.count(), 0);
+	}
+
+	void test_toggle()
+	{
+		QTemporaryDir tempDir;
+		QDir dir(tempDir.path());
+		makeMods(dir, 10);
+		ModList list(dir.absolutePath());
+		list.update();
+
+		QSignalSpy resets(&list, SIGNAL(modelReset()));
+		QSignalSpy inserts(&list, SIGNAL(rowsInserted(QModelIndex, int, int)));
+		QSignalSpy removes(&list, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+
+		QVERIFY(list.setData(list.index(3, ModList::ActiveColumn), Qt::Unchecked,
+							 Qt::CheckStateRole));
+		QVERIFY(dir.exists("mod0006.class.disabled"));
+		list.update();
+		QCOMPARE(list.rowCount(), 10);
+		QCOMPARE(list[3].mmc_id(), QString("mod0006.class"));
+		QVERIFY(!list[3].enabled());
+		QCOMPARE(resets.count(), 0);
+		QCOMPARE(inserts.count(), 0);
+		QCOMPARE(removes.count(), 0);
+	}
+
+	void test_update_benchmark_data()
+	{
+		QTest::addColumn<int>("count");
+
+		QTest::newRow("10 mods") << 10;
+		QTest::newRow("100 mods") << 100;
+		QTest::newRow("1000 mods") << 1000;
+	}
+	void test_update_benchmark()
+	{
+		QFETCH(int, count);
+
+		QTemporaryDir tempDir;
+		QDir dir(tempDir.path());
+		makeMods(dir, count);
+		ModList list(dir.absolutePath());
+		list.update();
+		QCOMPARE(list.rowCount(), count);
+
+		QBENCHMARK
+		{
+			list.update();
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(ModListTest)
+
+#include "tst_modlist.moc"
@@ -1,4 +1,5 @@
 #include <QTest>
+#include <QTemporaryDir>
 #include "TestUtil.h"
 
 #include "depends/util/include/pathutils.h"
@@ -67,6 +68,33 @@ slots:
 
 		QCOMPARE(PathCombine(path1, path2, path3), result);
 	}
+
+	void test_linkAndClone()
+	{
+		QTemporaryDir tempDir;
+		QVERIFY(tempDir.isValid());
+		QString src = PathCombine(tempDir.path(), "source");
+		QString linked = PathCombine(tempDir.path(), "linked");
+		QString cloned = PathCombine(tempDir.path(), "cloned");
+		{
+			QFile f(src);
+			QVERIFY(f.open(QFile::WriteOnly));
+			f.write("Lorem ipsum dolor sit amet.");
+		}
+		QCOMPARE(fileLinkCount(src), 1);
+
+		QVERIFY(hardlinkFile(src, linked));
+		QCOMPARE(fileLinkCount(src), 2);
+		QCOMPARE(TestsInternal::readFile(linked), TestsInternal::readFile(src));
+		// never overwrites
+		QVERIFY(!hardlinkFile(src, linked));
+
+		QVERIFY(cloneFile(src, cloned));
+		QCOMPARE(fileLinkCount(src), 2);
+		QCOMPARE(fileLinkCount(cloned), 1);
+		QCOMPARE(TestsInternal::readFile(cloned), TestsInternal::readFile(src));
+		QVERIFY(!cloneFile(src, cloned));
+	}
 };
 
 QTEST_GUILESS_MAIN_MULTIMC(PathUtilsTest)
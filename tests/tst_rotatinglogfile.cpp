@@ -0,0 +1,75 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <quagzipfile.h>
+#include "TestUtil.h"
+
+#include "logic/RotatingLogFile.h"
+
+class RotatingLogFileTest : public QObject
+{
+	Q_OBJECT
+
+	static LogBlock makeLines(int first, int count)
+	{
+		LogBlock lines;
+		for (int i = first; i < first + count; i++)
+		{
+			lines.append(LogLine{QString("line %1").arg(i), MessageLevel::Message});
+		}
+		return lines;
+	}
+
+private
+slots:
+	void test_rotate()
+	{
+		QTemporaryDir tempDir;
+		QDir dir(tempDir.path());
+		RotatingLogFile log(dir.absolutePath(), 1024);
+		for (int i = 0; i < 100; i++)
+		{
+			log.write(makeLines(i * 10, 10));
+		}
+		log.close();
+		QThreadPool::globalInstance()->waitForDone();
+
+		const QString current = QFileInfo(log.fileName()).fileName();
+		QStringList segments = dir.entryList(QStringList() << current + ".*.gz", QDir::Files);
+		QVERIFY(segments.size() > 1);
+		QVERIFY(dir.entryList(QStringList() << "*.part", QDir::Files).isEmpty());
+
+		// the first segment starts with the first line, and is really gzipped
+		QuaGzipFile first(dir.absoluteFilePath(current + ".1.gz"));
+		QVERIFY(first.open(QIODevice::ReadOnly));
+		QVERIFY(first.readLine().startsWith("[Message] line 0\n"));
+	}
+
+	void test_removeOldLaunches()
+	{
+		QTemporaryDir tempDir;
+		QDir dir(tempDir.path());
+		const QStringList old = {"launch-2015-01-01_00-00-00.log",
+								 "launch-2015-01-01_00-00-00.log.1.gz",
+								 "launch-2015-01-02_00-00-00.log",
+								 "launch-2015-01-03_00-00-00.log"};
+		for (auto &name : old)
+		{
+			QFile file(dir.absoluteFilePath(name));
+			QVERIFY(file.open(QIODevice::WriteOnly));
+		}
+
+		RotatingLogFile log(dir.absolutePath(), 1024, 3);
+		log.write(makeLines(0, 1));
+		log.close();
+
+		QStringList files = dir.entryList(QDir::Files, QDir::Name);
+		QCOMPARE(files.size(), 3);
+		QCOMPARE(files[0], QString("launch-2015-01-02_00-00-00.log"));
+		QCOMPARE(files[1], QString("launch-2015-01-03_00-00-00.log"));
+	}
+};
+
+QTEST_GUILESS_MAIN_MULTIMC(RotatingLogFileTest)
+
+#include "tst_rotatinglogfile.moc"